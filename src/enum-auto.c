@@ -0,0 +1,266 @@
+/* include the enumerator headers. */
+#include "enum.h"
+#include "enum-thread.h"
+
+/* ENUM_AUTO_PROBES: number of random probes of the calibration run. */
+#define ENUM_AUTO_PROBES  256
+
+/* automatic selection builds a second enumerator with the same closures,
+ * and profiles every closure over a short run of the tree size estimator.
+ * the estimator gives the number of node tests below each feasible node
+ * of every level, and the time of each test, so every prune is credited
+ * with the time of the subtree that it removed. the optional closures
+ * whose credited time falls short of their own cost are then dropped,
+ * and the remaining closures of each level are ordered by their prunes
+ * per tick. as the optional closures only anticipate the prunes of the
+ * others, the selection does not change the accepted solutions.
+ *
+ * for more details, consult:
+ *  - enum_thread_estimate() in enum-estimate.c
+ *  - enum_prof_feasible() in enum-prof.c
+ */
+
+/* auto_rank_t: structure for ordering the closures of a level. */
+typedef struct {
+  /* @rate: prunes per tick of the closure during calibration.
+   * @i: index of the closure at its level.
+   */
+  double rate;
+  unsigned int i;
+}
+auto_rank_t;
+
+/* auto_rank_cmp(): comparison function for ordering closures by
+ * decreasing prune rate, keeping the order of registration on ties.
+ */
+static int auto_rank_cmp (const void *pa, const void *pb) {
+  /* get the compared closures. */
+  const auto_rank_t *a = (const auto_rank_t*) pa;
+  const auto_rank_t *b = (const auto_rank_t*) pb;
+
+  /* compare the rates, then the indices. */
+  if (a->rate != b->rate)
+    return (a->rate > b->rate ? -1 : 1);
+
+  return (a->i > b->i) - (a->i < b->i);
+}
+
+/* auto_probe(): build and run the calibration enumerator.
+ *
+ * arguments:
+ *  @E: pointer to the enumerator structure to calibrate.
+ *  @opts: pointer to the options data structure of the enumerator.
+ *
+ * returns:
+ *  pointer to the calibration enumerator, or null on failure.
+ */
+static enum_t *auto_probe (enum_t *E, opts_t *opts) {
+  /* copy the options into a short probing run without outputs. */
+  opts_t A = *opts;
+  A.nprobe = ENUM_AUTO_PROBES;
+  A.nsample = A.lds = A.blocks = A.meet = A.restarts = A.jit = 0;
+  A.nsol_limit = 0;
+  A.fname_resume = A.fname_replay = A.fname_prof = A.select = NULL;
+
+  /* build the calibration enumerator. */
+  enum_t *C = enum_new(E->P, E->G, &A);
+  if (!C)
+    return NULL;
+
+  /* initialize its threads and profile counters. */
+  if (!enum_threads_init(C) || !enum_prof_init(C)) {
+    enum_free(C);
+    return NULL;
+  }
+
+#ifdef __IBP_HAVE_PTHREAD
+  /* execute the probes over every thread. */
+  for (unsigned int i = 0; i < C->nthreads; i++) {
+    if (pthread_create(&C->threads[i].thread, NULL,
+                       enum_thread_estimate, C->threads + i)) {
+      raise("unable to create calibration thread %u of %u",
+            i + 1, C->nthreads);
+      C->term = 1;
+      for (unsigned int j = 0; j < i; j++)
+        pthread_join(C->threads[j].thread, NULL);
+
+      enum_free(C);
+      return NULL;
+    }
+  }
+
+  /* wait for all threads to exit. */
+  for (unsigned int i = 0; i < C->nthreads; i++)
+    pthread_join(C->threads[i].thread, NULL);
+#else
+  /* execute the probes in the current thread. */
+  enum_thread_estimate(C->threads);
+#endif
+
+  /* return the calibrated enumerator. */
+  return C;
+}
+
+/* enum_auto_init(): select the pruning closures of an enumerator by a
+ * calibration probe, and print the selection.
+ *
+ * arguments:
+ *  @E: pointer to the enumerator structure to modify.
+ *  @opts: pointer to the options data structure of the enumerator.
+ *
+ * returns:
+ *  integer indicating whether (1) or not (0) the operation succeeded.
+ */
+int enum_auto_init (enum_t *E, opts_t *opts) {
+  /* get the length of the order. */
+  const unsigned int len = E->G->n_order;
+
+  /* declare required variables:
+   *  @C: calibration enumerator.
+   *  @rank: ordering of the closures of a level.
+   *  @tail: estimated node tests below each feasible node of a level.
+   *  @nodes, @ntest, @tcpu, @nprobe: estimator sums of the calibration
+   *                                 run.
+   *  @hz, @us: ticks per microsecond, and microseconds per node test.
+   *  @names, @nkept, @ntot: names of the registered methods, and their
+   *                         numbers of kept and registered closures.
+   */
+  enum_t *C;
+  auto_rank_t *rank;
+  double tail, nodes, ntest = 0.0, tcpu = 0.0, nprobe = 0.0, hz, us;
+  const char **names;
+  unsigned int *nkept, *ntot;
+  unsigned int i, m, n, lev, tid, n_names;
+  enum_prof_t cl;
+
+  /* run the calibration probe. */
+  C = auto_probe(E, opts);
+  if (!C)
+    throw("unable to run calibration probe");
+
+  /* sum the probe statistics of all threads. */
+  const unsigned int stride = 2 * len + 3;
+  for (tid = 0; tid < C->nthreads; tid++) {
+    nprobe += C->est[tid * stride + 2 * len];
+    ntest += C->est[tid * stride + 2 * len + 1];
+    tcpu += C->est[tid * stride + 2 * len + 2];
+  }
+
+  /* compute the tick rate and the cost of each node test. */
+  hz = enum_prof_hz(C);
+  us = (ntest > 0.0 ? 1.0e6 * tcpu / ntest : 0.0);
+
+  /* allocate the ranks and the method summaries. */
+  rank = (auto_rank_t*) malloc((C->prof_off[len] + 1) *
+                               sizeof(auto_rank_t));
+  names = (const char**) malloc((C->prof_off[len] + 1) * sizeof(char*));
+  nkept = (unsigned int*) calloc(C->prof_off[len] + 1, sizeof(unsigned int));
+  ntot = (unsigned int*) calloc(C->prof_off[len] + 1, sizeof(unsigned int));
+  if (!rank || !names || !nkept || !ntot) {
+    raise("unable to allocate closure ranks");
+    goto fail;
+  }
+
+  /* loop over the levels of the graph order, from the last, so that the
+   * node tests below each level are summed along the way.
+   */
+  for (lev = len, tail = 0.0, n_names = 0; lev-- > 0;) {
+    /* check that the calibration registered the same closures. */
+    if (C->prune_sz[lev] != E->prune_sz[lev]) {
+      raise("calibration closures differ at level %u", lev);
+      goto fail;
+    }
+
+    /* sum the estimated feasible nodes of the level. */
+    for (tid = 0, nodes = 0.0; tid < C->nthreads; tid++)
+      nodes += C->est[tid * stride + lev];
+
+    /* rank the closures of the level, dropping unprofitable ones. */
+    for (i = 0, n = 0; i < E->prune_sz[lev]; i++) {
+      /* get the counters and the method of the closure. */
+      enum_prof_sum(C, C->prof_off[lev] + i, &cl);
+      const char *name = E->prune_name[lev][i];
+
+      /* credit every prune with the subtree tests that it removed. */
+      const double gain = (nodes > 0.0 ? (double) cl.nprune *
+                                         tail / nodes * us : 0.0);
+      const double cost = (double) cl.ticks / hz;
+
+      /* find the summary of the method. */
+      for (m = 0; m < n_names && names[m] != name; m++);
+      if (m == n_names)
+        names[n_names++] = name;
+
+      ntot[m]++;
+
+      /* drop optional closures that do not pay off. untested closures
+       * are kept, as the calibration holds no evidence against them.
+       */
+      if (enum_prune_optional(name) && cl.ncall && gain < cost) {
+        free(E->prune_data[lev][i]);
+        continue;
+      }
+
+      /* rank the kept closure. */
+      nkept[m]++;
+      rank[n].rate = (cl.ticks ? (double) cl.nprune /
+                                 (double) cl.ticks : 0.0);
+      rank[n].i = i;
+      n++;
+    }
+
+    /* order the kept closures and compact the arrays of the level. */
+    qsort(rank, n, sizeof(auto_rank_t), auto_rank_cmp);
+    enum_prune_test_fn func[n ? n : 1];
+    void *data[n ? n : 1];
+    const char *name[n ? n : 1];
+    for (i = 0; i < n; i++) {
+      func[i] = E->prune[lev][rank[i].i];
+      data[i] = E->prune_data[lev][rank[i].i];
+      name[i] = E->prune_name[lev][rank[i].i];
+    }
+
+    for (i = 0; i < n; i++) {
+      E->prune[lev][i] = func[i];
+      E->prune_data[lev][i] = data[i];
+      E->prune_name[lev][i] = name[i];
+    }
+
+    E->prune_sz[lev] = n;
+
+    /* accumulate the node tests below the previous level. */
+    for (tid = 0; tid < C->nthreads; tid++)
+      tail += C->est[tid * stride + len + lev];
+  }
+
+  /* output the selection of every method. */
+  printf("\nPruning selection [auto, %.0lf probes]:\n", nprobe);
+  for (m = 0; m < n_names; m++)
+    printf("  %-8s : %8u/%-8u closures\n", names[m], nkept[m], ntot[m]);
+
+  /* output the methods that were kept anywhere, for reuse. */
+  printf("  methods  : ");
+  for (m = 0, n = 0; m < n_names; m++) {
+    if (nkept[m])
+      printf("%s%s", n++ ? "," : "", names[m]);
+  }
+
+  printf("\n");
+
+  /* free the calibration state and return success. */
+  free(rank);
+  free(names);
+  free(nkept);
+  free(ntot);
+  enum_free(C);
+  return 1;
+
+fail:
+  /* free the calibration state and return failure. */
+  free(rank);
+  free(names);
+  free(nkept);
+  free(ntot);
+  enum_free(C);
+  return 0;
+}
@@ -0,0 +1,409 @@
+
+/* include the enumerator headers. */
+#include "enum.h"
+#include "enum-thread.h"
+#include "enum-prune.h"
+
+/* enum_block_separable(): check whether the pruning closures registered
+ * with an enumerator allow the tree to be split into parts that are
+ * embedded separately. closures that accumulate state along the entire
+ * tree path, or that read atoms which are not linked to the current atom
+ * by a graph edge, prevent it.
+ *
+ * arguments:
+ *  @E: pointer to the enumerator structure to access.
+ *
+ * returns:
+ *  integer indicating whether (1) or not (0) the tree may be split.
+ */
+int enum_block_separable (enum_t *E) {
+  /* loop over the registered closures of every level. */
+  for (unsigned int lev = 0; lev < E->G->n_order; lev++) {
+    for (unsigned int i = 0; i < E->prune_sz[lev]; i++) {
+      /* energies accumulate over the whole path, future closures are
+       * not restricted to graph edges, and forward closures read atoms
+       * that are linked to the next atom.
+       */
+      if (E->prune[lev][i] == enum_prune_energy ||
+          E->prune[lev][i] == enum_prune_future ||
+          E->prune[lev][i] == enum_prune_forward)
+        return 0;
+    }
+  }
+
+  /* return separable. */
+  return 1;
+}
+
+/* block_reach(): compute the lowest level that each level of the order,
+ * or any level after it, depends on through a graph edge, by being a
+ * duplicate, or by taking the rotamer chosen at an earlier level.
+ *
+ * arguments:
+ *  @E: pointer to the enumerator structure to access.
+ *  @reach: output array of reached levels, with room for one sentinel.
+ */
+static void block_reach (enum_t *E, unsigned int *reach) {
+  /* get references to the graph and its order. */
+  graph_t *G = E->G;
+  const unsigned int *order = G->order;
+  const unsigned int *dup = G->orig;
+  const unsigned int len = G->n_order;
+
+  /* initialize the sentinel. */
+  reach[len] = len;
+
+  /* loop backwards over the levels of the order. */
+  for (unsigned int v = len - 1; v < len; v--) {
+    /* duplicates depend on their original level. */
+    unsigned int low = v - dup[v];
+
+    /* other levels depend on the first level they share an edge with. */
+    for (unsigned int u = 0; u < v && !dup[v]; u++) {
+      if (!dup[u] && graph_has_edge(G, order[u], order[v])) {
+        low = u;
+        break;
+      }
+    }
+
+    /* rotamer levels depend on the branch chosen at the first level of
+     * their sidechain, which may therefore not lie in a preceding frame.
+     */
+    if (E->rot && E->rot[v] && E->rot_lead[v] - 3 < low)
+      low = E->rot_lead[v] - 3;
+
+    /* store the lowest level reached at or after the current level. */
+    reach[v] = (low < reach[v + 1] ? low : reach[v + 1]);
+  }
+}
+
+/* enum_blocks_init(): split the levels of an enumerator into blocks that
+ * may be enumerated independently.
+ *
+ * a level is a separator when no level at or after it depends on a level
+ * before the three levels that precede it, which form the (rigid) frame
+ * of the embedding. each block holds at least one branching level, and
+ * blocks are cut greedily at every eligible separator. when no separator
+ * exists, the enumerator falls back to the depth-first traversal.
+ *
+ * arguments:
+ *  @E: pointer to the enumerator structure to modify.
+ *
+ * returns:
+ *  integer indicating whether (1) or not (0) the operation succeeded.
+ */
+int enum_blocks_init (enum_t *E) {
+  /* get references to the graph and the tree size. */
+  graph_t *G = E->G;
+  const unsigned int *dup = G->orig;
+  const unsigned int len = G->n_order;
+  const unsigned int m = E->n_levels;
+
+  /* declare required variables:
+   *  @reach: lowest level reached from each level onwards.
+   *  @cuts: first level of every block.
+   *  @c: candidate separator level.
+   *  @k: index of the first branching level at or after @c.
+   *  @kb: index of the first branching level of the current block.
+   */
+  unsigned int *reach, *cuts, c, k, kb, b;
+
+  /* check that the pruning methods allow decomposition. */
+  if (!enum_block_separable(E)) {
+    info("pruning methods prevent block decomposition");
+    E->thread_fn = enum_thread_execute;
+    return 1;
+  }
+
+  /* allocate the temporary arrays. */
+  reach = (unsigned int*) malloc((2 * len + 2) * sizeof(unsigned int));
+  if (!reach)
+    throw("unable to allocate separator arrays");
+
+  /* compute the reached levels. */
+  cuts = reach + (len + 1);
+  block_reach(E, reach);
+
+  /* cut the first block at the first level that may be embedded. */
+  E->n_blocks = 1;
+  cuts[0] = 3;
+
+  /* search for separators, with at least one branching level on
+   * each side of every cut.
+   */
+  for (c = 4, k = kb = 0; c < len && m; c++) {
+    /* locate the first branching level at or after the candidate. */
+    while (k < m && E->levels[k] < c)
+      k++;
+
+    /* stop when no branching levels remain. */
+    if (k == m)
+      break;
+
+    /* check for a valid separator with a non-duplicate frame. */
+    if (reach[c] + 3 < c || k == kb ||
+        dup[c - 3] || dup[c - 2] || dup[c - 1])
+      continue;
+
+    /* cut a new block. */
+    cuts[E->n_blocks++] = c;
+    kb = k;
+  }
+
+  /* fall back to depth-first traversal without separators. */
+  if (E->n_blocks < 2) {
+    info("no graph separators found, using depth-first traversal");
+    E->thread_fn = enum_thread_execute;
+    free(reach);
+    return 1;
+  }
+
+  /* allocate the block array. */
+  E->blocks = (enum_block_t*) calloc(E->n_blocks, sizeof(enum_block_t));
+  if (!E->blocks) {
+    free(reach);
+    throw("unable to allocate array of %u blocks", E->n_blocks);
+  }
+
+  /* initialize the blocks. */
+  for (b = 0, k = 0; b < E->n_blocks; b++) {
+    /* store the level range of the block. */
+    enum_block_t *blk = E->blocks + b;
+    blk->start = cuts[b];
+    blk->end = (b + 1 < E->n_blocks ? cuts[b + 1] : len);
+
+    /* count the branching levels of the block. */
+    for (kb = k; k < m && E->levels[k] < blk->end; k++);
+    blk->m = k - kb;
+
+    /* allocate the branching levels of the block. */
+    blk->lv = (unsigned int*) malloc((blk->m + 1) * sizeof(unsigned int));
+    if (!blk->lv) {
+      free(reach);
+      throw("unable to allocate levels of block %u", b + 1);
+    }
+
+    /* store the branching levels, terminated by the block end. */
+    memcpy(blk->lv, E->levels + kb, blk->m * sizeof(unsigned int));
+    blk->lv[blk->m] = blk->end;
+  }
+
+  /* initialize the block scheduling variables. */
+  E->next_block = 0;
+  E->busy = E->nthreads;
+
+  /* output an informational message about the decomposition. */
+  info("tree split into %u independent blocks", E->n_blocks);
+
+  /* free the temporary arrays and return success. */
+  free(reach);
+  return 1;
+}
+
+/* block_leaf(): store a feasible leaf of a block traversal as a partial
+ * solution of the block.
+ *
+ * arguments:
+ *  @th: pointer to the thread holding the leaf.
+ *
+ * returns:
+ *  integer indicating whether (1) or not (0) the leaf was stored.
+ */
+static int block_leaf (enum_thread_t *th) {
+  /* get the block and its size. */
+  enum_block_t *blk = th->E->blocks + th->block;
+  const unsigned int n = blk->end - blk->start;
+
+  /* grow the solution array if required. */
+  if (blk->nsol == blk->cap) {
+    blk->cap = (blk->cap ? 2 * blk->cap : 64);
+    blk->sol = (vector_t*)
+      realloc(blk->sol, blk->cap * n * sizeof(vector_t));
+
+    /* check for allocation failures. */
+    if (!blk->sol)
+      throw("unable to store solutions of block %u", th->block + 1);
+  }
+
+  /* store the atom positions of the block. */
+  for (unsigned int i = 0; i < n; i++)
+    blk->sol[blk->nsol * n + i] = th->state[blk->start + i].pos;
+
+  /* return success. */
+  blk->nsol++;
+  return 1;
+}
+
+/* block_place(): place a partial solution of a block into the state of
+ * a thread, using the current positions of the frame of the block.
+ *
+ * arguments:
+ *  @th: pointer to the thread to modify.
+ *  @blk: pointer to the block to place.
+ *  @idx: index of the partial solution to place.
+ */
+static void block_place (enum_thread_t *th, enum_block_t *blk,
+                         const unsigned int idx) {
+  /* get references to the thread state and the block size. */
+  enum_thread_node_t *state = th->state;
+  const unsigned int *dup = th->E->G->orig;
+  const unsigned int n = blk->end - blk->start;
+  const vector_t *sol = blk->sol + idx * n;
+
+  /* get the frame positions. */
+  const vector_t x0 = state[blk->start - 3].pos;
+  const vector_t x1 = state[blk->start - 2].pos;
+  const vector_t x2 = state[blk->start - 1].pos;
+  vector_t u, v, w;
+
+  /* compute the basis of the frame. */
+  enum_thread_basis(&x0, &x1, &x2, &u, &v, &w);
+
+  /* map the atoms from the canonical frame, whose basis vectors are
+   * (-1,0,0), (0,1,0) and (0,0,-1), into the current frame.
+   */
+  for (unsigned int i = 0; i < n; i++) {
+    if (dup[blk->start + i]) continue;
+    const vector_t p = sol[i];
+    state[blk->start + i].pos.x = x0.x - p.x * u.x + p.y * v.x - p.z * w.x;
+    state[blk->start + i].pos.y = x0.y - p.x * u.y + p.y * v.y - p.z * w.y;
+    state[blk->start + i].pos.z = x0.z - p.x * u.z + p.y * v.z - p.z * w.z;
+  }
+}
+
+/* block_join(): produce the solutions of an enumerator as the cartesian
+ * product of the partial solutions of its blocks.
+ *
+ * arguments:
+ *  @th: pointer to the thread used to assemble solutions.
+ *
+ * returns:
+ *  integer indicating whether (1) or not (0) the operation succeeded.
+ */
+static int block_join (enum_thread_t *th) {
+  /* get references to the enumerator and its blocks. */
+  enum_t *E = th->E;
+  enum_block_t *blocks = E->blocks;
+  const unsigned int n = E->n_blocks;
+
+  /* declare required variables:
+   *  @idx: index of the partial solution of each block.
+   *  @b: index of the first block to be placed.
+   */
+  unsigned int *idx, b;
+
+  /* there are no solutions if any block has no partial solutions. */
+  for (b = 0; b < n; b++) {
+    if (!blocks[b].nsol)
+      return 1;
+  }
+
+  /* allocate the partial solution indices. */
+  idx = (unsigned int*) calloc(n, sizeof(unsigned int));
+  if (!idx)
+    throw("unable to allocate block indices");
+
+  /* place the initial frame. */
+  enum_thread_frame(th, 0);
+
+  /* loop over every combination of partial solutions. */
+  for (b = 0; b < n;) {
+    /* place every block whose frame may have moved. */
+    for (unsigned int i = b; i < n; i++)
+      block_place(th, blocks + i, idx[i]);
+
+    /* handle the solution. */
+    if (!enum_thread_solution(th)) {
+      free(idx);
+      throw("failed to handle solution");
+    }
+
+    /* check if we should terminate enumeration. */
+    if (E->term || (E->nmax && E->nsol >= E->nmax))
+      break;
+
+    /* move to the next combination. */
+    for (b = n - 1; b < n; b--) {
+      if (++idx[b] < blocks[b].nsol)
+        break;
+
+      idx[b] = 0;
+    }
+  }
+
+  /* free the partial solution indices and return success. */
+  free(idx);
+  return 1;
+}
+
+/* enum_thread_blocks(): thread function for enumerator threads that
+ * enumerate independent blocks of the tree.
+ *
+ * threads repeatedly claim a block, place its frame canonically, and
+ * store every feasible partial solution of the block. the last thread
+ * to finish then joins the partial solutions of all blocks into the
+ * solutions of the tree.
+ *
+ * arguments:
+ *  @pdata: pointer to the current enumerator thread data structure.
+ */
+void *enum_thread_blocks (void *pdata) {
+  /* get references to the current thread data. */
+  enum_thread_t *thread = (enum_thread_t*) pdata;
+  enum_thread_node_t *state = thread->state;
+  enum_t *E = thread->E;
+  unsigned int b, last;
+
+  /* loop until no blocks remain to be claimed. */
+  while (!E->term) {
+#ifdef __IBP_HAVE_PTHREAD
+    /* claim the next block. */
+    pthread_mutex_lock(&E->write_mutex);
+    b = E->next_block++;
+    pthread_mutex_unlock(&E->write_mutex);
+#else
+    b = E->next_block++;
+#endif
+
+    /* check if all blocks have been claimed. */
+    if (b >= E->n_blocks)
+      break;
+
+    /* get the block. */
+    enum_block_t *blk = E->blocks + b;
+    thread->block = b;
+
+    /* place the frame and initialize the branch indices, such that the
+     * whole block is traversed.
+     */
+    enum_thread_frame(thread, blk->start - 3);
+    for (unsigned int k = 0; k < blk->m; k++)
+      state[blk->lv[k]].idx = state[blk->lv[k]].end = 0;
+
+    if (blk->m)
+      state[blk->lv[0]].end = state[blk->lv[0]].nb;
+
+    /* enumerate the partial solutions of the block. */
+    if (!enum_thread_traverse(thread, blk->lv, blk->m, blk->start,
+                              block_leaf)) {
+      raise("failed to enumerate block %u", b + 1);
+      E->term = 1;
+    }
+  }
+
+#ifdef __IBP_HAVE_PTHREAD
+  /* check whether this is the last thread to finish. */
+  pthread_mutex_lock(&E->write_mutex);
+  last = (--E->busy == 0);
+  pthread_mutex_unlock(&E->write_mutex);
+#else
+  last = (--E->busy == 0);
+#endif
+
+  /* join the blocks in the last thread. */
+  if (last && !E->term && !block_join(thread))
+    raise("failed to join blocks");
+
+  /* end thread execution. */
+  return NULL;
+}
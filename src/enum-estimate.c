@@ -0,0 +1,271 @@
+
+/* include the enumerator headers. */
+#include "enum.h"
+#include "enum-thread.h"
+
+/* include the timing header. */
+#include <time.h>
+
+/* estimate_clock(): return the current value of a monotonic clock.
+ *
+ * returns:
+ *  current clock time, in seconds.
+ */
+static inline double estimate_clock (void) {
+  /* read the clock and convert it to seconds. */
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (double) ts.tv_sec + 1.0e-9 * (double) ts.tv_nsec;
+}
+
+/* estimate_node(): embed and test a single node of a probe.
+ *
+ * arguments:
+ *  @th: pointer to the enumerator thread to utilize.
+ *  @lev: level of the node in the tree.
+ *  @idx: branch index of the node at its level.
+ *
+ * returns:
+ *  integer indicating whether (1) or not (0) the node is feasible.
+ */
+static inline int estimate_node (enum_thread_t *th,
+                                 const unsigned int lev,
+                                 const unsigned int idx) {
+  /* embed the atom and check the feasibility of new atoms. */
+  th->state[lev].idx = idx;
+  th->level = lev;
+  return (!enum_thread_embed(th, lev) || enum_thread_feasible(th));
+}
+
+/* enum_thread_estimate(): thread function for enumerator threads that
+ * estimate the size of the pruned tree by random probing.
+ *
+ * this is knuth's estimator: every probe descends from the root, tests
+ * all branches at each level, and continues into one feasible branch
+ * drawn uniformly at random, whose embedding is kept from its test so
+ * that every node is tested exactly once. the product of the feasible branch counts
+ * along the probe is an unbiased estimate of the number of feasible
+ * nodes at each level, and the product of the branch counts above a
+ * level estimates the number of nodes tested there by a complete
+ * depth-first traversal. no solutions are handled or written.
+ *
+ * arguments:
+ *  @pdata: pointer to the current enumerator thread data structure.
+ */
+void *enum_thread_estimate (void *pdata) {
+  /* get references to the current thread data. */
+  enum_thread_t *thread = (enum_thread_t*) pdata;
+  enum_thread_node_t *state = thread->state;
+  graph_t *G = thread->E->G;
+  enum_t *E = thread->E;
+
+  /* get the index of the thread and the length of the order. */
+  const unsigned int tid = (unsigned int) (thread - E->threads);
+  const unsigned int len = G->n_order;
+
+  /* get the estimator sums of the thread:
+   *  @nodes: sums of the feasible node estimates at each level.
+   *  @evals: sums of the tested node estimates at each level.
+   *  @stats: probe count, node test count and elapsed time.
+   */
+  double *nodes = E->est + tid * (2 * len + 3);
+  double *evals = nodes + len;
+  double *stats = evals + len;
+
+  /* declare required variables:
+   *  @cand: feasible branch indices at the current level.
+   *  @cpos, @cen: positions and energies of the feasible branches.
+   *  @lev: current level of the probe.
+   *  @nc: number of feasible branches at the current level.
+   *  @nbmax: largest number of branches at any level.
+   *  @probe: index of the current probe.
+   *  @W: estimated number of nodes at the parent level.
+   *  @t0: starting time of the thread.
+   */
+  unsigned int *cand, lev, nc, nbmax, probe, r;
+  vector_t *cpos;
+  double *cen, W, t0;
+
+  /* allocate the candidate array. */
+  for (lev = 0, nbmax = 1; lev < len; lev++)
+    nbmax = (state[lev].nb > nbmax ? state[lev].nb : nbmax);
+
+  cand = (unsigned int*) malloc(nbmax * sizeof(unsigned int));
+  cpos = (vector_t*) malloc(nbmax * sizeof(vector_t));
+  cen = (double*) malloc(nbmax * sizeof(double));
+  if (!cand || !cpos || !cen) {
+    raise("unable to allocate candidate arrays");
+    free(cand);
+    free(cpos);
+    free(cen);
+    return NULL;
+  }
+
+  /* loop over the probes apportioned to the thread. */
+  t0 = estimate_clock();
+  for (probe = tid; probe < E->nprobe && !E->term; probe += E->nthreads) {
+    /* publish the state into any requested snapshot. */
+    if (thread->snap_seen != E->snap)
+      enum_snap_publish(thread);
+
+    /* start the probe at the root, which is always feasible. */
+    for (W = 1.0, lev = 3; lev < len; lev++) {
+      /* every branch at the level is tested. */
+      evals[lev] += W * (double) state[lev].nb;
+      stats[1] += (double) state[lev].nb;
+
+      /* collect the feasible branches. */
+      for (unsigned int idx = nc = 0; idx < state[lev].nb; idx++) {
+        if (estimate_node(thread, lev, idx)) {
+          cpos[nc] = state[lev].pos;
+          cen[nc] = state[lev].energy;
+          cand[nc++] = idx;
+        }
+      }
+
+      /* end the probe if no branch is feasible. */
+      if (!nc) break;
+
+      /* accumulate the node estimate of the level. */
+      W *= (double) nc;
+      nodes[lev] += W;
+
+      /* restore a random feasible branch to continue the probe. */
+      r = enum_thread_random(thread, nc);
+      state[lev].idx = cand[r];
+      state[lev].pos = cpos[r];
+      state[lev].energy = cen[r];
+      enum_thread_moved(thread, lev);
+    }
+
+    /* count the probe. */
+    stats[0] += 1.0;
+  }
+
+  /* store the elapsed time of the thread. */
+  stats[2] = estimate_clock() - t0;
+
+  /* free the candidate arrays and end thread execution. */
+  free(cand);
+  free(cpos);
+  free(cen);
+  return NULL;
+}
+
+/* estimate_duration(): print a duration in a human-readable unit.
+ *
+ * arguments:
+ *  @t: duration to print, in seconds.
+ */
+static void estimate_duration (double t) {
+  /* define the available units. */
+  static const struct {
+    const char *name;
+    double sec;
+  } units[] = {
+    { "yr.",  3.15576e7 },
+    { "days", 8.64e4 },
+    { "hr.",  3.6e3 },
+    { "min.", 6.0e1 },
+    { "sec.", 1.0 }
+  };
+
+  /* select the largest unit that fits the duration. */
+  unsigned int u = 0;
+  while (u < 4 && t < units[u].sec)
+    u++;
+
+  /* print the duration. */
+  printf("%.3lg %s", t / units[u].sec, units[u].name);
+}
+
+/* enum_estimate_report(): output the results of a tree size estimation
+ * after all estimator threads have completed.
+ *
+ * arguments:
+ *  @E: pointer to the enumerator structure to access.
+ */
+void enum_estimate_report (enum_t *E) {
+  /* get the length of the order. */
+  const unsigned int len = E->G->n_order;
+
+  /* declare required variables:
+   *  @nprobe: total number of completed probes.
+   *  @ntest: total number of node tests performed by the probes.
+   *  @tcpu: total time spent probing by all threads.
+   *  @nodes, @evals: estimates of the tree at the current level.
+   *  @total: estimate of the node tests of a complete traversal.
+   *  @prev: node estimate at the previous branching level.
+   *  @leaves: node estimate at the final level.
+   *  @logb: sum of the log-branching factors of every level.
+   *  @nlev: number of branching levels.
+   */
+  double nprobe = 0.0, ntest = 0.0, tcpu = 0.0;
+  double nodes, evals, total = 0.0, prev = 1.0, leaves = 0.0, logb = 0.0;
+  unsigned int lev, tid, nlev = 0;
+
+  /* sum the probe statistics of all threads. */
+  for (tid = 0; tid < E->nthreads; tid++) {
+    const double *stats = E->est + tid * (2 * len + 3) + 2 * len;
+    nprobe += stats[0];
+    ntest += stats[1];
+    tcpu += stats[2];
+  }
+
+  /* output an initial header. */
+  printf("\nTree size estimate [%.0lf probes]:\n", nprobe);
+  if (nprobe == 0.0)
+    return;
+
+  /* loop over the levels of the graph order. */
+  for (lev = 3; lev < len; lev++) {
+    /* sum the estimates of the level over all threads. */
+    for (tid = 0, nodes = evals = 0.0; tid < E->nthreads; tid++) {
+      nodes += E->est[tid * (2 * len + 3) + lev] / nprobe;
+      evals += E->est[tid * (2 * len + 3) + len + lev] / nprobe;
+    }
+
+    /* accumulate the node test and leaf estimates. */
+    total += evals;
+    leaves = nodes;
+
+    /* skip duplicate and non-branching levels. */
+    if (E->G->orig[lev] || E->threads[0].state[lev].nb < 2) continue;
+
+    /* get the atom/residue indices and names. */
+    const unsigned int ai = E->G->order[lev];
+    const unsigned int ri = E->P->atoms[ai].res_id;
+    const char *atomi = E->P->atoms[ai].name;
+    const char *resi = peptide_get_resname(E->P, ri);
+
+    /* output the statistics. */
+    printf("  %3s%-4u %-4s : %16.6le nodes  %10.4lf/%-4u branches\n",
+           resi, ri + 1, atomi, nodes,
+           prev > 0.0 ? nodes / prev : 0.0,
+           E->threads[0].state[lev].nb);
+
+    /* accumulate the effective branching factor. */
+    if (prev > 0.0 && nodes > 0.0) {
+      logb += log(nodes / prev);
+      nlev++;
+    }
+
+    /* store the node estimate for the next branching level. */
+    prev = nodes;
+  }
+
+  /* output the summary statistics. */
+  printf("\nEstimated tree:\n"
+         "  Dense leaves:        10^%.3lf\n"
+         "  Feasible leaves:     %16.6le\n"
+         "  Node tests:          %16.6le\n"
+         "  Branching factor:    %16.4lf\n"
+         "  Projected time:      ",
+         E->logW, leaves, total,
+         nlev ? exp(logb / (double) nlev) : 0.0);
+
+  /* output the projected wall-clock time at the current thread count. */
+  estimate_duration(ntest > 0.0 ?
+                    total * tcpu / ntest / (double) E->nthreads : 0.0);
+  printf(" [%u thread%s]\n", E->nthreads, E->nthreads == 1 ? "" : "s");
+}
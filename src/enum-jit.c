@@ -0,0 +1,223 @@
+
+/* include the enumerator headers. */
+#include "enum.h"
+#include "enum-jit.h"
+#include "enum-thread.h"
+#include "enum-prune.h"
+
+/* include the offset and dynamic linking headers. */
+#include <stddef.h>
+#ifdef __IBP_HAVE_JIT
+#include <dlfcn.h>
+#endif
+
+/* ENUM_JIT_CC: default compiler command used to build kernels, unless
+ * overridden by the CC environment variable.
+ */
+#define ENUM_JIT_CC  "cc"
+
+/* ENUM_JIT_CFLAGS: compiler flags used to build kernels into a shared
+ * object.
+ */
+#define ENUM_JIT_CFLAGS  "-O3 -fPIC -shared"
+
+/* the direct distance feasibility kernels emitted by this source file
+ * unroll the loop of enum_prune_ddf() over the preceeding levels of each
+ * level, with the squared bounds of every edge folded into constants.
+ * squared bounds avoid the square root of every distance, and edges
+ * without bounds are left out of the kernels entirely.
+ *
+ * for more details, consult:
+ *  - enum_prune_ddf() in enum-prune-ddf.c
+ *  - enum_prune_kernel_fn in enum-prune.h
+ */
+
+/* enum_jit_emit_ddf(): write the source of the direct distance feasibility
+ * kernel of a single level of an enumerator.
+ *
+ * arguments:
+ *  @E: pointer to the enumerator structure to access.
+ *  @fh: file handle to write the kernel source into.
+ *  @lev: graph order level of the kernel.
+ */
+static void enum_jit_emit_ddf (enum_t *E, FILE *fh, const unsigned int lev) {
+  /* declare required variables:
+   *  @bound: distance bound between a preceeding level and @lev.
+   *  @l, @u: lower and upper distance bounds, including tolerance.
+   */
+  value_t bound;
+  double l, u;
+
+  /* write the kernel header. */
+  fprintf(fh, "\nint ibp_jit_ddf_%u (const void *s, "
+              "unsigned int *nt, unsigned int *np) {\n"
+              "  const double *a = POS(%u);\n"
+              "  double r;\n", lev, lev);
+
+  /* loop over all upstream embedded atoms, as in enum_prune_ddf(). */
+  for (unsigned int ib = lev - 1; ib < E->G->n_order; ib--) {
+    /* skip duplicate atoms and edges without bounds. */
+    bound = graph_get_edge(E->G, E->G->order[ib], E->G->order[lev]);
+    if (E->G->orig[ib] || value_is_undefined(bound))
+      continue;
+
+    /* widen the bounds by the tolerance. */
+    l = bound.l - E->ddf_tol;
+    u = bound.u + E->ddf_tol;
+
+    /* skip edges whose bounds are unable to prune, which are neither
+     * tested nor counted by enum_prune_ddf().
+     */
+    if (!(l > 0.0 || isfinite(u)))
+      continue;
+
+    /* write the distance computation. */
+    fprintf(fh, "  nt[%u]++; r = D2(a, POS(%u));\n", ib, ib);
+
+    /* write the bound checks, omitting trivial ones. */
+    if (l > 0.0 && isfinite(u))
+      fprintf(fh, "  if (r < %.17g || r > %.17g) { np[%u]++; return 1; }\n",
+              l * l, u * u, ib);
+    else if (l > 0.0)
+      fprintf(fh, "  if (r < %.17g) { np[%u]++; return 1; }\n", l * l, ib);
+    else
+      fprintf(fh, "  if (r > %.17g) { np[%u]++; return 1; }\n", u * u, ib);
+  }
+
+  /* write the kernel footer. */
+  fprintf(fh, "  return 0;\n}\n");
+}
+
+/* enum_jit_init(): emit, compile and load pruning kernels that are
+ * specialized to the graph and order of an enumerator, and attach them
+ * to the pruning closures that they replace.
+ *
+ * arguments:
+ *  @E: pointer to the enumerator structure to modify.
+ *
+ * returns:
+ *  integer indicating whether (1) or not (0) the operation succeeded.
+ */
+int enum_jit_init (enum_t *E) {
+#ifdef __IBP_HAVE_JIT
+  /* declare required variables:
+   *  @fsrc, @fobj: filenames of the kernel source and shared object.
+   *  @cmd: compiler command string.
+   *  @sym: kernel symbol name.
+   *  @cc: compiler binary name.
+   *  @fn: kernel function pointer.
+   *  @nk: number of emitted kernels.
+   */
+  char fsrc[64], fobj[64], cmd[256], sym[32];
+  enum_prune_kernel_fn fn;
+  unsigned int lev, i, nk;
+  const char *cc;
+  FILE *fh;
+  int fd;
+
+  /* create the kernel source file. */
+  strcpy(fsrc, "/tmp/ibp-jit-XXXXXX.c");
+  fd = mkstemps(fsrc, 2);
+  if (fd < 0 || !(fh = fdopen(fd, "w")))
+    throw("unable to create kernel source file");
+
+  /* write the kernel source preamble. */
+  fprintf(fh, "/* pruning kernels generated by ibp-ng. */\n"
+              "#define POS(i) ((const double*) "
+              "((const char*) s + (i) * %lu + %lu))\n"
+              "#define D2(a,b) (((a)[0] - (b)[0]) * ((a)[0] - (b)[0]) + \\\n"
+              "                 ((a)[1] - (b)[1]) * ((a)[1] - (b)[1]) + \\\n"
+              "                 ((a)[2] - (b)[2]) * ((a)[2] - (b)[2]))\n",
+          (unsigned long) sizeof(enum_thread_node_t),
+          (unsigned long) offsetof(enum_thread_node_t, pos));
+
+  /* write a kernel for every level having a ddf closure. */
+  for (lev = 0, nk = 0; lev < E->G->n_order; lev++) {
+    for (i = 0; i < E->prune_sz[lev]; i++) {
+      if (E->prune[lev][i] == enum_prune_ddf) {
+        enum_jit_emit_ddf(E, fh, lev);
+        nk++;
+      }
+    }
+  }
+
+  /* close the kernel source file. */
+  fclose(fh);
+
+  /* return if no kernels are required. */
+  if (!nk) {
+    unlink(fsrc);
+    info("no pruning kernels to compile");
+    return 1;
+  }
+
+  /* get the compiler binary name. */
+  cc = getenv("CC");
+  if (!cc || !*cc)
+    cc = ENUM_JIT_CC;
+
+  /* build the shared object filename and the compiler command. */
+  strcpy(fobj, fsrc);
+  strcpy(fobj + strlen(fobj) - 1, "so");
+  snprintf(cmd, sizeof(cmd), "%s %s -o %s %s", cc, ENUM_JIT_CFLAGS,
+           fobj, fsrc);
+
+  /* compile the kernels. */
+  info("compiling %u pruning kernels: %s", nk, cmd);
+  if (system(cmd) != 0) {
+    unlink(fsrc);
+    unlink(fobj);
+    throw("unable to compile pruning kernels");
+  }
+
+  /* load the shared object. the files are no longer required once the
+   * object has been mapped into memory.
+   */
+  E->jit = dlopen(fobj, RTLD_NOW | RTLD_LOCAL);
+  unlink(fsrc);
+  unlink(fobj);
+  if (!E->jit)
+    throw("unable to load pruning kernels: %s", dlerror());
+
+  /* attach the kernels to their closures. */
+  for (lev = 0; lev < E->G->n_order; lev++) {
+    for (i = 0; i < E->prune_sz[lev]; i++) {
+      /* skip closures without a kernel. */
+      if (E->prune[lev][i] != enum_prune_ddf)
+        continue;
+
+      /* look up the kernel of the level. */
+      snprintf(sym, sizeof(sym), "ibp_jit_ddf_%u", lev);
+      *(void**) (&fn) = dlsym(E->jit, sym);
+      if (!fn)
+        throw("unable to find pruning kernel '%s'", sym);
+
+      /* store the kernel in the closure. */
+      enum_prune_ddf_kernel(E->prune_data[lev][i], fn);
+    }
+  }
+
+  /* return success. */
+  return 1;
+#else
+  /* raise an exception about kernel compilation support. */
+  throw("this program was compiled without jit support");
+#endif
+}
+
+/* enum_jit_free(): unload the compiled pruning kernels of an enumerator.
+ *
+ * arguments:
+ *  @E: pointer to the enumerator structure to modify.
+ */
+void enum_jit_free (enum_t *E) {
+#ifdef __IBP_HAVE_JIT
+  /* close the shared object, if any. */
+  if (E->jit)
+    dlclose(E->jit);
+#endif
+
+  /* reset the shared object handle. */
+  E->jit = NULL;
+}
+
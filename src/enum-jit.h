@@ -0,0 +1,10 @@
+
+/* ensure once-only inclusion. */
+#pragma once
+
+/* function declarations (enum-jit.c): */
+
+int enum_jit_init (enum_t *E);
+
+void enum_jit_free (enum_t *E);
+
@@ -0,0 +1,251 @@
+
+/* include the enumerator headers. */
+#include "enum.h"
+#include "enum-thread.h"
+
+/* lds_first(): return the first branch at a level of a limited discrepancy
+ * traversal that is consistent with the discrepancy budget of the level.
+ *
+ * arguments:
+ *  @nb: number of branches at the level.
+ *  @w: number of leading branches that do not cost a discrepancy.
+ *  @left: number of discrepancies that remain to be spent.
+ *  @rem: number of branching levels below the level.
+ *
+ * returns:
+ *  index of the first admissible branch, or @nb if none exists.
+ */
+static inline unsigned int lds_first (const unsigned int nb,
+                                      const unsigned int w,
+                                      const unsigned int left,
+                                      const unsigned int rem) {
+  /* the heuristic branches are admissible if the levels below can still
+   * spend the entire budget. otherwise, spend a discrepancy here.
+   */
+  if (rem >= left)
+    return 0;
+  else if (left && nb > w)
+    return w;
+
+  /* no branch is admissible. */
+  return nb;
+}
+
+/* lds_next(): return the branch following a given branch at a level of
+ * a limited discrepancy traversal.
+ *
+ * arguments:
+ *  @idx: current branch index at the level.
+ *  @nb: number of branches at the level.
+ *  @w: number of leading branches that do not cost a discrepancy.
+ *  @left: number of discrepancies that remain to be spent.
+ *
+ * returns:
+ *  index of the next admissible branch, or @nb if none exists.
+ */
+static inline unsigned int lds_next (const unsigned int idx,
+                                     const unsigned int nb,
+                                     const unsigned int w,
+                                     const unsigned int left) {
+  /* the leading branches are free, and every other costs a discrepancy. */
+  if (idx + 1 < w)
+    return idx + 1;
+
+  return (left && idx + 1 < nb ? idx + 1 : nb);
+}
+
+/* lds_seek(): return the first branch at a level of a limited discrepancy
+ * traversal that is consistent with the discrepancy budget of the level,
+ * and not below a given branch.
+ *
+ * arguments:
+ *  @lo: lowest branch that may be returned.
+ *  @nb: number of branches at the level.
+ *  @w: number of leading branches that do not cost a discrepancy.
+ *  @left: number of discrepancies that remain to be spent.
+ *  @rem: number of branching levels below the level.
+ *
+ * returns:
+ *  index of the first admissible branch, or @nb if none exists.
+ */
+static inline unsigned int lds_seek (const unsigned int lo,
+                                     const unsigned int nb,
+                                     const unsigned int w,
+                                     const unsigned int left,
+                                     const unsigned int rem) {
+  /* get the first admissible branch of the level. */
+  const unsigned int idx = lds_first(nb, w, left, rem);
+  if (idx >= lo)
+    return idx;
+
+  /* the admissible branches run from the first one up to the free
+   * branches, and on to the last branch if a discrepancy may be spent.
+   */
+  return (lo < nb && (lo < w || left) ? lo : nb);
+}
+
+/* enum_thread_lds(): thread function for enumerator threads that perform
+ * an (improved) limited discrepancy search of the tree.
+ *
+ * the branch order produced by enum_thread_lerp_index() is treated as a
+ * heuristic, and every branch that leaves the innermost interpolation
+ * point of a branching level counts as one discrepancy. the two signs of
+ * sin(omega) are equally likely, so both branches of the innermost point
+ * are free. each iteration visits exactly the leaves reached with a given
+ * number of discrepancies, so that the tree is covered once when all
+ * iterations have completed. every thread performs every iteration over
+ * the sub-tree apportioned to it by enum_threads_init(), so that all
+ * threads share the early iterations, which hold the heuristic leaves.
+ *
+ * arguments:
+ *  @pdata: pointer to the current enumerator thread data structure.
+ */
+void *enum_thread_lds (void *pdata) {
+  /* get references to the current thread data. */
+  enum_thread_t *thread = (enum_thread_t*) pdata;
+  enum_thread_node_t *state = thread->state;
+  graph_t *G = thread->E->G;
+  enum_t *E = thread->E;
+
+  /* get references to the branching levels. */
+  const unsigned int *lv = E->levels;
+  const unsigned int m = E->n_levels;
+  const unsigned int r = E->n_split;
+
+  /* declare required variables:
+   *  @wid: number of free leading branches at each branching level.
+   *  @rem: number of branching levels at or below each branching level
+   *        that are able to spend a discrepancy.
+   *  @left: discrepancy budget on entering each branching level.
+   *  @lo, @hi: whether the path above each branching level lies on the
+   *            first or last path of the sub-tree of the thread.
+   *  @k: current branching level index of the traversal.
+   *  @d: number of discrepancies of the current iteration.
+   *  @bmin, @bmax: range of branches of the sub-tree of the thread at
+   *                the current branching level.
+   */
+  unsigned int *wid, *rem, *left, *lo, *hi, k, d, bmin, bmax;
+
+  /* embed the single-choice atoms that precede all branching. trees
+   * without branching hold a single leaf, which is handled by the first
+   * thread only.
+   */
+  if (!enum_thread_step(thread, 3, lv[0]) ||
+      (m == 0 && (thread != E->threads || G->n_order <= 3)))
+    return NULL;
+
+  if (m == 0) {
+    if (!enum_thread_solution(thread))
+      raise("failed to handle solution");
+
+    return NULL;
+  }
+
+  /* allocate the traversal arrays. */
+  wid = (unsigned int*) malloc((5 * m + 1) * sizeof(unsigned int));
+  if (!wid) {
+    raise("unable to allocate discrepancy arrays");
+    return NULL;
+  }
+
+  /* initialize the array pointers. */
+  rem = wid + m;
+  left = rem + (m + 1);
+  lo = left + m;
+  hi = lo + m;
+
+  /* determine the free branches at each branching level: distance-derived
+   * edges branch over both signs, and dihedral-derived edges do not.
+   */
+  for (k = 0; k < m; k++) {
+    wid[k] = 1;
+    if (!value_is_dihedral(graph_get_edge(G, G->order[lv[k] - 3],
+                                             G->order[lv[k]])))
+      wid[k] = 2;
+  }
+
+  /* count the branching levels at or below each branching level. */
+  rem[m] = 0;
+  for (k = m - 1; k < m; k--)
+    rem[k] = rem[k + 1] + (state[lv[k]].nb > wid[k] ? 1 : 0);
+
+  /* loop over the iterations. */
+  for (d = 0; d <= rem[0]; d++) {
+    /* start the iteration at the root, on both bounding paths of the
+     * sub-tree of the thread.
+     */
+    k = 0;
+    left[k] = d;
+    lo[k] = hi[k] = 1;
+    state[lv[k]].idx = lds_seek(r ? state[lv[k]].start : 0,
+                                state[lv[k]].nb, wid[k], d, rem[k + 1]);
+
+    /* traverse until the iteration returns above the root. */
+    while (1) {
+      /* check if we should terminate enumeration. */
+      if (E->term || (E->nmax && E->nsol >= E->nmax)) {
+        free(wid);
+        return NULL;
+      }
+
+      /* publish the state into any requested snapshot. */
+      if (thread->snap_seen != E->snap)
+        enum_snap_publish(thread);
+
+      /* get the last branch of the sub-tree at the level. the last
+       * splitting level excludes its end index.
+       */
+      bmax = state[lv[k]].nb;
+      if (k < r && hi[k])
+        bmax = state[lv[k]].end + (k < r - 1 ? 1 : 0);
+
+      /* backtrack if the level has no more admissible branches. */
+      if (state[lv[k]].idx >= state[lv[k]].nb ||
+          state[lv[k]].idx >= bmax) {
+        if (k-- == 0)
+          break;
+
+        state[lv[k]].idx = lds_next(state[lv[k]].idx, state[lv[k]].nb,
+                                    wid[k], left[k]);
+        continue;
+      }
+
+      /* embed and check the atoms of the step. */
+      if (!enum_thread_step(thread, lv[k], lv[k + 1])) {
+        state[lv[k]].idx = lds_next(state[lv[k]].idx, state[lv[k]].nb,
+                                    wid[k], left[k]);
+        continue;
+      }
+
+      /* check if the step is terminal. */
+      if (k == m - 1) {
+        /* handle the solution. */
+        if (!enum_thread_solution(thread)) {
+          raise("failed to handle solution");
+          free(wid);
+          return NULL;
+        }
+
+        /* move to the next branch. */
+        state[lv[k]].idx = lds_next(state[lv[k]].idx, state[lv[k]].nb,
+                                    wid[k], left[k]);
+        continue;
+      }
+
+      /* move down a level, spending a discrepancy if required, and
+       * follow the bounding paths of the sub-tree.
+       */
+      k++;
+      left[k] = left[k - 1] - (state[lv[k - 1]].idx >= wid[k - 1]);
+      lo[k] = lo[k - 1] && state[lv[k - 1]].idx == state[lv[k - 1]].start;
+      hi[k] = hi[k - 1] && state[lv[k - 1]].idx == state[lv[k - 1]].end;
+      bmin = (k < r && lo[k] ? state[lv[k]].start : 0);
+      state[lv[k]].idx = lds_seek(bmin, state[lv[k]].nb, wid[k], left[k],
+                                  rem[k + 1]);
+    }
+  }
+
+  /* free the traversal arrays and end thread execution. */
+  free(wid);
+  return NULL;
+}
@@ -0,0 +1,657 @@
+
+/* include the enumerator headers. */
+#include "enum.h"
+#include "enum-thread.h"
+#include "enum-prune.h"
+
+/* MEET_CELL_BITS: number of bits used to pack each coordinate of a cell
+ * of the spatial hash into a single key.
+ */
+#define MEET_CELL_BITS  21
+
+/* MEET_JOIN_CHUNK: number of forward solutions claimed at once by each
+ * thread during the join.
+ */
+#define MEET_JOIN_CHUNK  16
+
+/* meet_local(): compute the coordinates of a position in a junction
+ * frame with a given origin and basis.
+ */
+static inline vector_t meet_local (const vector_t *p, const vector_t *o,
+                                   const vector_t *u, const vector_t *v,
+                                   const vector_t *w) {
+  /* project the offset from the origin onto the basis. */
+  const double dx = p->x - o->x;
+  const double dy = p->y - o->y;
+  const double dz = p->z - o->z;
+  vector_t q;
+  q.x = dx * u->x + dy * u->y + dz * u->z;
+  q.y = dx * v->x + dy * v->y + dz * v->z;
+  q.z = dx * w->x + dy * w->y + dz * w->z;
+  return q;
+}
+
+/* meet_global(): compute a position from its coordinates in a junction
+ * frame with a given origin and basis.
+ */
+static inline vector_t meet_global (const vector_t *q, const vector_t *o,
+                                    const vector_t *u, const vector_t *v,
+                                    const vector_t *w) {
+  /* sum the basis vectors into the origin. */
+  vector_t p;
+  p.x = o->x + q->x * u->x + q->y * v->x + q->z * w->x;
+  p.y = o->y + q->x * u->y + q->y * v->y + q->z * w->y;
+  p.z = o->z + q->x * u->z + q->y * v->z + q->z * w->z;
+  return p;
+}
+
+/* meet_key(): compute the spatial hash key of the cell that holds a
+ * position, offset by a number of cells along each axis.
+ */
+static inline unsigned long long meet_key (const vector_t *q,
+                                           const double rad,
+                                           const int dx, const int dy,
+                                           const int dz) {
+  /* compute the offset cell coordinates. */
+  const long long off = 1LL << (MEET_CELL_BITS - 1);
+  const long long mask = (1LL << MEET_CELL_BITS) - 1;
+  const long long ix = ((long long) floor(q->x / rad) + dx + off) & mask;
+  const long long iy = ((long long) floor(q->y / rad) + dy + off) & mask;
+  const long long iz = ((long long) floor(q->z / rad) + dz + off) & mask;
+
+  /* pack the coordinates. */
+  return (unsigned long long)
+    ((ix << (2 * MEET_CELL_BITS)) | (iy << MEET_CELL_BITS) | iz);
+}
+
+/* meet_cell_cmp(): comparison function for sorting spatial hash keys.
+ */
+static int meet_cell_cmp (const void *pa, const void *pb) {
+  const enum_meet_cell_t *a = (const enum_meet_cell_t*) pa;
+  const enum_meet_cell_t *b = (const enum_meet_cell_t*) pb;
+  if (a->key != b->key)
+    return (a->key < b->key ? -1 : 1);
+
+  return (a->idx < b->idx ? -1 : a->idx > b->idx);
+}
+
+/* meet_in_bounds(): check whether the distance between the atoms at two
+ * levels of a thread state satisfies the bounds of their graph edge.
+ */
+static inline int meet_in_bounds (enum_t *E, const vector_t *a,
+                                  const vector_t *b,
+                                  const unsigned int la,
+                                  const unsigned int lb) {
+  /* undefined edges do not restrict the distance. */
+  const value_t bound = graph_get_edge(E->G, E->G->order[la],
+                                             E->G->order[lb]);
+  if (bound.type == VALUE_TYPE_UNDEFINED)
+    return 1;
+
+  /* check the distance against the bound. */
+  const double dist = vector_dist((vector_t*) a, (vector_t*) b);
+  return !(bound.l - dist > E->ddf_tol || dist - bound.u > E->ddf_tol);
+}
+
+/* enum_meet_init(): prepare an enumerator for bidirectional enumeration,
+ * by choosing the middle level that balances the sizes of the two halves
+ * of the tree and the crossing edge used to index backward solutions.
+ *
+ * the backward half is embedded in reverse, and therefore may not hold
+ * any duplicate levels, or levels that take the rotamer chosen at an
+ * earlier level. when no middle level exists, or the pruning methods
+ * prevent splitting the tree, the enumerator falls back to the
+ * depth-first traversal.
+ *
+ * arguments:
+ *  @E: pointer to the enumerator structure to modify.
+ *
+ * returns:
+ *  integer indicating whether (1) or not (0) the operation succeeded.
+ */
+int enum_meet_init (enum_t *E) {
+  /* get references to the graph and the tree size. */
+  graph_t *G = E->G;
+  const unsigned int *dup = G->orig;
+  const unsigned int len = G->n_order;
+  enum_thread_node_t *state = E->threads[0].state;
+
+  /* declare required variables:
+   *  @tail: first level of the duplicate-free tail of the order.
+   *  @mid: chosen middle level.
+   *  @logf: log-size of the forward half at each candidate.
+   *  @best: imbalance of the chosen middle level.
+   */
+  unsigned int tail, mid, c, k;
+  double logw, logf, best;
+  enum_meet_t *M;
+
+  /* check that the pruning methods allow splitting. */
+  if (!enum_block_separable(E)) {
+    info("pruning methods prevent bidirectional enumeration");
+    E->thread_fn = enum_thread_execute;
+    return 1;
+  }
+
+  /* locate the duplicate-free tail of the order. */
+  for (tail = len; tail > 0 && !dup[tail - 1]; tail--);
+
+  /* compute the log-size of the tree. */
+  for (c = 3, logw = 0.0; c < len; c++)
+    logw += log((double) state[c].nb);
+
+  /* choose the middle level that best balances the two halves, such
+   * that both halves branch and the junction frame lies in the tail.
+   */
+  for (c = 3, mid = 0, logf = 0.0, best = INFINITY; c < len; c++) {
+    if (c >= tail + 3 && logf > 0.0 && logf < logw &&
+        fabs(2.0 * logf - logw) < best) {
+      best = fabs(2.0 * logf - logw);
+      mid = c;
+    }
+
+    logf += log((double) state[c].nb);
+  }
+
+  /* the backward half must choose its own rotamers. */
+  for (c = mid, k = 0; mid && E->rot && c < len; c++)
+    k |= (E->rot[c] && E->rot_lead[c] != c);
+
+  /* fall back to depth-first traversal over shared rotamers. */
+  if (k) {
+    info("rotamers prevent bidirectional enumeration");
+    E->thread_fn = enum_thread_execute;
+    return 1;
+  }
+
+  /* fall back to depth-first traversal without a middle level. */
+  if (!mid) {
+    info("no middle level found, using depth-first traversal");
+    E->thread_fn = enum_thread_execute;
+    return 1;
+  }
+
+  /* allocate the bidirectional enumeration state. */
+  M = E->meet = (enum_meet_t*) calloc(1, sizeof(enum_meet_t));
+  if (!M)
+    throw("unable to allocate bidirectional enumeration state");
+
+  /* store the branching levels of the forward half. */
+  for (k = 0; k < E->n_levels && E->levels[k] < mid; k++);
+  M->mid = mid;
+  M->m = k;
+  M->lv = (unsigned int*) malloc((k + 1) * sizeof(unsigned int));
+  if (!M->lv)
+    throw("unable to allocate forward branching levels");
+
+  memcpy(M->lv, E->levels, k * sizeof(unsigned int));
+  M->lv[k] = mid;
+
+  /* check whether distance bounds are enforced. */
+  for (c = 0; c < len && !M->ddf; c++)
+    for (k = 0; k < E->prune_sz[c]; k++)
+      M->ddf |= (E->prune[c][k] == enum_prune_ddf);
+
+  /* locate the tightest edge between the two halves, excluding the
+   * junction frame, when distance bounds are enforced.
+   */
+  for (c = mid, M->rad = INFINITY; c < len && M->ddf; c++) {
+    for (k = 0; k + 3 < mid; k++) {
+      if (dup[k]) continue;
+      value_t bound = graph_get_edge(G, G->order[k], G->order[c]);
+      if (bound.type != VALUE_TYPE_UNDEFINED && bound.u < M->rad) {
+        M->rad = bound.u;
+        M->kf = k;
+        M->kb = c;
+      }
+    }
+  }
+
+  /* disable the spatial hash without a usable crossing edge, and widen
+   * its cells by the tolerance that distance bounds are checked with.
+   */
+  if (!isfinite(M->rad) || M->rad <= 0.0)
+    M->rad = 0.0;
+  else
+    M->rad += E->ddf_tol;
+
+  /* initialize the scheduling variables. */
+  M->next = 0;
+  M->next_fwd = 0;
+#ifdef __IBP_HAVE_PTHREAD
+  if (pthread_barrier_init(&M->barrier, NULL, E->nthreads))
+    throw("unable to initialize bidirectional enumeration barrier");
+#endif
+
+  /* output an informational message about the split. */
+  info("bidirectional enumeration split at level %u of %u", mid, len);
+
+  /* return success. */
+  return 1;
+}
+
+/* enum_meet_free(): free the bidirectional enumeration state of an
+ * enumerator.
+ *
+ * arguments:
+ *  @E: pointer to the enumerator structure to modify.
+ */
+void enum_meet_free (enum_t *E) {
+  /* return if no state exists. */
+  if (!E->meet)
+    return;
+
+#ifdef __IBP_HAVE_PTHREAD
+  /* destroy the barrier. */
+  pthread_barrier_destroy(&E->meet->barrier);
+#endif
+
+  /* free the arrays and the structure. */
+  free(E->meet->cells);
+  free(E->meet->lv);
+  free(E->meet->fwd);
+  free(E->meet->bwd);
+  free(E->meet);
+  E->meet = NULL;
+}
+
+/* meet_leaf(): store a feasible leaf of the forward half.
+ *
+ * arguments:
+ *  @th: pointer to the thread holding the leaf.
+ *
+ * returns:
+ *  integer indicating whether (1) or not (0) the leaf was stored.
+ */
+static int meet_leaf (enum_thread_t *th) {
+  /* get the bidirectional state. */
+  enum_meet_t *M = th->E->meet;
+  const unsigned int n = M->mid;
+
+  /* grow the solution array if required. */
+  if (M->nfwd == M->capf) {
+    M->capf = (M->capf ? 2 * M->capf : 64);
+    M->fwd = (vector_t*) realloc(M->fwd, M->capf * n * sizeof(vector_t));
+    if (!M->fwd)
+      throw("unable to store forward solutions");
+  }
+
+  /* store the atom positions of the forward half. */
+  for (unsigned int i = 0; i < n; i++)
+    M->fwd[M->nfwd * n + i] = th->state[i].pos;
+
+  /* return success. */
+  M->nfwd++;
+  return 1;
+}
+
+/* meet_backward(): enumerate the backward half of the tree, by embedding
+ * the order in reverse from a canonical frame of its last three levels
+ * down to the junction frame.
+ *
+ * arguments:
+ *  @th: pointer to the thread to traverse with.
+ *
+ * returns:
+ *  integer indicating whether (1) or not (0) the operation succeeded.
+ */
+static int meet_backward (enum_thread_t *th) {
+  /* get references to the thread state and enumerator. */
+  enum_thread_node_t *state = th->state;
+  enum_t *E = th->E;
+  enum_meet_t *M = E->meet;
+  graph_t *G = E->G;
+
+  /* get the level range and solution size of the backward half. */
+  const unsigned int len = G->n_order;
+  const unsigned int low = M->mid - 3;
+  const unsigned int n = len - M->mid;
+  vector_t o, u, v, w;
+  unsigned int i, j;
+
+  /* place the last three atoms into a canonical frame. */
+  const double d01 = graph_get_edge_exact(G, G->order[len - 1],
+                                             G->order[len - 2]);
+  const double d02 = graph_get_edge_exact(G, G->order[len - 1],
+                                             G->order[len - 3]);
+  const double d12 = graph_get_edge_exact(G, G->order[len - 2],
+                                             G->order[len - 3]);
+  const double ct = distances_to_angle(d01, d02, d12);
+  const double st = sqrt(1.0 - ct * ct);
+  vector_set(&state[len - 1].pos, 0.0, 0.0, 0.0);
+  vector_set(&state[len - 2].pos, -d01, 0.0, 0.0);
+  vector_set(&state[len - 3].pos, d12 * ct - d01, d12 * st, 0.0);
+
+  /* traverse the backward half. the branch index of the atom at each
+   * level is held by the level three below it.
+   */
+  i = len - 4;
+  state[i + 3].idx = 0;
+  while (!E->term) {
+    /* backtrack if every branch of the atom has been visited. */
+    if (state[i + 3].idx >= state[i + 3].nb) {
+      if (i == len - 4)
+        break;
+
+      i++;
+      state[i + 3].idx++;
+      continue;
+    }
+
+    /* embed the atom. */
+    enum_thread_embed_reverse(th, i);
+
+    /* check the distance bounds to the embedded atoms. */
+    for (j = i + 1; j < len && M->ddf; j++) {
+      if (!meet_in_bounds(E, &state[i].pos, &state[j].pos, i, j))
+        break;
+    }
+
+    /* move to the next branch if the atom is infeasible. */
+    if (M->ddf && j < len) {
+      state[i + 3].idx++;
+      continue;
+    }
+
+    /* move down to the next atom until the junction is reached. */
+    if (i > low) {
+      i--;
+      state[i + 3].idx = 0;
+      continue;
+    }
+
+    /* grow the solution array if required. */
+    if (M->nbwd == M->capb) {
+      M->capb = (M->capb ? 2 * M->capb : 64);
+      M->bwd = (vector_t*) realloc(M->bwd, M->capb * n * sizeof(vector_t));
+      if (!M->bwd)
+        throw("unable to store backward solutions");
+    }
+
+    /* store the atoms of the backward half in junction coordinates. */
+    o = state[low].pos;
+    enum_thread_basis(&state[low].pos, &state[low + 1].pos,
+                      &state[low + 2].pos, &u, &v, &w);
+    for (j = 0; j < n; j++)
+      M->bwd[M->nbwd * n + j] = meet_local(&state[M->mid + j].pos,
+                                           &o, &u, &v, &w);
+
+    /* move to the next branch. */
+    M->nbwd++;
+    state[i + 3].idx++;
+  }
+
+  /* return success. */
+  return 1;
+}
+
+/* meet_try(): assemble a candidate solution from the forward half held
+ * in the state of a thread and a backward solution, and handle it when
+ * every level of the backward half passes its feasibility tests.
+ *
+ * arguments:
+ *  @th: pointer to the thread holding the forward half.
+ *  @f: index of the forward solution.
+ *  @b: index of the backward solution.
+ *  @o, @u, @v, @w: origin and basis of the junction frame.
+ *
+ * returns:
+ *  integer indicating whether (1) or not (0) the candidate was handled
+ *  without errors.
+ */
+static int meet_try (enum_thread_t *th,
+                     const unsigned int f, const unsigned int b,
+                     const vector_t *o, const vector_t *u,
+                     const vector_t *v, const vector_t *w) {
+  /* get references to the thread state and enumerator. */
+  enum_thread_node_t *state = th->state;
+  enum_t *E = th->E;
+  enum_meet_t *M = E->meet;
+  const unsigned int len = E->G->n_order;
+  const vector_t *sol = M->bwd + b * (len - M->mid);
+
+  /* place the backward half into the frame of the forward half. */
+  for (unsigned int lev = M->mid; lev < len; lev++)
+    state[lev].pos = meet_global(sol + (lev - M->mid), o, u, v, w);
+
+  /* check the feasibility of every level of the backward half. */
+  for (unsigned int lev = M->mid; lev < len; lev++) {
+    th->level = lev;
+    if (!enum_thread_feasible(th))
+      return 1;
+  }
+
+  /* handle the solution. */
+  if (!enum_thread_solution(th))
+    return 0;
+
+  /* restore the forward half, which solution handling may transform. */
+  for (unsigned int lev = 0; lev < M->mid; lev++)
+    state[lev].pos = M->fwd[f * M->mid + lev];
+
+  /* return success. */
+  return 1;
+}
+
+/* meet_index(): build the spatial hash of the backward solutions of an
+ * enumerator, over the backward atom of the tightest crossing edge.
+ *
+ * arguments:
+ *  @E: pointer to the enumerator structure to modify.
+ *
+ * returns:
+ *  integer indicating whether (1) or not (0) the operation succeeded.
+ */
+static int meet_index (enum_t *E) {
+  /* get references to the bidirectional state. */
+  enum_meet_t *M = E->meet;
+  const unsigned int nb = E->G->n_order - M->mid;
+
+  /* without a crossing edge, every backward solution is tried. */
+  if (M->rad <= 0.0 || !M->nbwd)
+    return 1;
+
+  /* allocate the spatial hash. */
+  M->cells = (enum_meet_cell_t*)
+    malloc(M->nbwd * sizeof(enum_meet_cell_t));
+  if (!M->cells)
+    throw("unable to allocate spatial hash");
+
+  /* index the backward solutions by the cells of their hashed atoms. */
+  for (unsigned int b = 0; b < M->nbwd; b++) {
+    M->cells[b].key = meet_key(M->bwd + b * nb + (M->kb - M->mid),
+                               M->rad, 0, 0, 0);
+    M->cells[b].idx = b;
+  }
+
+  /* sort the backward solutions by cell. */
+  qsort(M->cells, M->nbwd, sizeof(enum_meet_cell_t), meet_cell_cmp);
+
+  /* return success. */
+  return 1;
+}
+
+/* meet_join(): join a forward solution with its compatible backward
+ * solutions, which are located through the spatial hash.
+ *
+ * arguments:
+ *  @th: pointer to the thread used to assemble solutions.
+ *  @f: index of the forward solution.
+ *
+ * returns:
+ *  integer indicating whether (1) or not (0) the operation succeeded.
+ */
+static int meet_join (enum_thread_t *th, const unsigned int f) {
+  /* get references to the thread state and enumerator. */
+  enum_thread_node_t *state = th->state;
+  enum_t *E = th->E;
+  enum_meet_t *M = E->meet;
+  const enum_meet_cell_t *cells = M->cells;
+  const unsigned int low = M->mid - 3;
+  const unsigned int nb = E->G->n_order - M->mid;
+  vector_t o, u, v, w, q;
+  unsigned int b;
+
+  /* restore the forward half. */
+  for (unsigned int i = 0; i < M->mid; i++)
+    state[i].pos = M->fwd[f * M->mid + i];
+
+  /* compute the junction frame of the forward half. */
+  o = state[low].pos;
+  enum_thread_basis(&state[low].pos, &state[low + 1].pos,
+                    &state[low + 2].pos, &u, &v, &w);
+
+  /* without a spatial hash, try every backward solution. */
+  if (!cells) {
+    for (b = 0; b < M->nbwd; b++) {
+      if (!meet_try(th, f, b, &o, &u, &v, &w))
+        return 0;
+    }
+
+    return 1;
+  }
+
+  /* get the junction coordinates of the forward hashed atom. */
+  q = meet_local(&state[M->kf].pos, &o, &u, &v, &w);
+
+  /* loop over the neighboring cells of the forward hashed atom. */
+  for (int dx = -1; dx <= 1; dx++) {
+    for (int dy = -1; dy <= 1; dy++) {
+      for (int dz = -1; dz <= 1; dz++) {
+        /* locate the first backward solution in the cell. */
+        const unsigned long long key = meet_key(&q, M->rad, dx, dy, dz);
+        unsigned int lo = 0, hi = M->nbwd;
+        while (lo < hi) {
+          const unsigned int mi = lo + (hi - lo) / 2;
+          if (cells[mi].key < key)
+            lo = mi + 1;
+          else
+            hi = mi;
+        }
+
+        /* try every backward solution in the cell that satisfies
+         * the bounds of the crossing edge.
+         */
+        for (; lo < M->nbwd && cells[lo].key == key; lo++) {
+          b = cells[lo].idx;
+          if (!meet_in_bounds(E, &q, M->bwd + b * nb + (M->kb - M->mid),
+                              M->kf, M->kb))
+            continue;
+
+          if (!meet_try(th, f, b, &o, &u, &v, &w))
+            return 0;
+        }
+      }
+    }
+  }
+
+  /* return success. */
+  return 1;
+}
+
+/* enum_thread_meet(): thread function for enumerator threads that
+ * perform a bidirectional (meet-in-the-middle) enumeration.
+ *
+ * one thread enumerates the forward half of the tree from the start of
+ * the order, and another enumerates the backward half in reverse from
+ * the end of the order. once both halves are complete, one thread builds
+ * a spatial hash of the backward solutions, and every thread then joins
+ * claimed chunks of forward solutions with their compatible backward
+ * solutions.
+ *
+ * arguments:
+ *  @pdata: pointer to the current enumerator thread data structure.
+ */
+void *enum_thread_meet (void *pdata) {
+  /* get references to the current thread data. */
+  enum_thread_t *thread = (enum_thread_t*) pdata;
+  enum_thread_node_t *state = thread->state;
+  enum_t *E = thread->E;
+  enum_meet_t *M = E->meet;
+  unsigned int h, f, fend, ok = 1;
+
+  /* loop until both halves have been claimed. */
+  while (!E->term && ok) {
+#ifdef __IBP_HAVE_PTHREAD
+    /* claim the next half. */
+    pthread_mutex_lock(&E->write_mutex);
+    h = M->next++;
+    pthread_mutex_unlock(&E->write_mutex);
+#else
+    h = M->next++;
+#endif
+
+    /* enumerate the claimed half. */
+    if (h == 0) {
+      /* initialize the branch indices of the forward half. */
+      enum_thread_frame(thread, 0);
+      for (unsigned int k = 0; k < M->m; k++)
+        state[M->lv[k]].idx = state[M->lv[k]].end = 0;
+
+      if (M->m)
+        state[M->lv[0]].end = state[M->lv[0]].nb;
+
+      /* enumerate the forward solutions. */
+      ok = enum_thread_traverse(thread, M->lv, M->m, 3, meet_leaf);
+    }
+    else if (h == 1) {
+      /* enumerate the backward solutions. */
+      ok = meet_backward(thread);
+    }
+    else
+      break;
+  }
+
+  /* check for enumeration failures. */
+  if (!ok) {
+    raise("failed to enumerate half of the tree");
+    E->term = 1;
+  }
+
+  /* wait for both halves, and index the backward half in one thread. */
+#ifdef __IBP_HAVE_PTHREAD
+  const int serial = (pthread_barrier_wait(&M->barrier) ==
+                      PTHREAD_BARRIER_SERIAL_THREAD);
+#else
+  const int serial = 1;
+#endif
+  if (serial && !E->term && !meet_index(E)) {
+    raise("failed to index backward half");
+    E->term = 1;
+  }
+
+#ifdef __IBP_HAVE_PTHREAD
+  /* wait for the spatial hash. */
+  pthread_barrier_wait(&M->barrier);
+#endif
+
+  /* loop until every forward solution has been joined. */
+  while (!E->term && !(E->nmax && E->nsol >= E->nmax)) {
+#ifdef __IBP_HAVE_PTHREAD
+    /* claim the next chunk of forward solutions. */
+    pthread_mutex_lock(&E->write_mutex);
+    f = M->next_fwd;
+    M->next_fwd += MEET_JOIN_CHUNK;
+    pthread_mutex_unlock(&E->write_mutex);
+#else
+    f = M->next_fwd;
+    M->next_fwd += MEET_JOIN_CHUNK;
+#endif
+
+    /* check if all forward solutions have been claimed. */
+    if (f >= M->nfwd)
+      break;
+
+    /* join the claimed forward solutions. */
+    fend = (f + MEET_JOIN_CHUNK < M->nfwd ? f + MEET_JOIN_CHUNK : M->nfwd);
+    for (; f < fend && !E->term && !(E->nmax && E->nsol >= E->nmax); f++) {
+      if (!meet_join(thread, f)) {
+        raise("failed to join halves");
+        E->term = 1;
+      }
+    }
+  }
+
+  /* end thread execution. */
+  return NULL;
+}
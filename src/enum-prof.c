@@ -0,0 +1,355 @@
+/* include the enumerator headers. */
+#include "enum.h"
+#include "enum-thread.h"
+
+/* include the timing header. */
+#include <time.h>
+
+/* profiling replaces the loop over the closures of each tested node by
+ * one that reads a tick counter around every closure, and accumulates
+ * the ticks, calls and prunes of each closure into counters private to
+ * each thread. on x86 the ticks are read from the time-stamp counter,
+ * which costs a few tens of cycles per read, and elsewhere from the
+ * monotonic clock in nanoseconds. the tick rate is calibrated against
+ * the monotonic clock over the whole traversal.
+ *
+ * for more details, consult:
+ *  - enum_thread_feasible() in enum-thread.c
+ */
+
+/* prof_ticks(): return the current value of the tick counter.
+ *
+ * returns:
+ *  current tick count.
+ */
+static inline unsigned long long prof_ticks (void) {
+#if defined(__x86_64__) || defined(__i386__)
+  /* read the time-stamp counter. */
+  return __builtin_ia32_rdtsc();
+#else
+  /* read the clock in nanoseconds. */
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (unsigned long long) ts.tv_sec * 1000000000ULL +
+         (unsigned long long) ts.tv_nsec;
+#endif
+}
+
+/* prof_clock(): return the current value of a monotonic clock.
+ *
+ * returns:
+ *  current clock time, in microseconds.
+ */
+static inline double prof_clock (void) {
+  /* read the clock and convert it to microseconds. */
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return 1.0e6 * (double) ts.tv_sec + 1.0e-3 * (double) ts.tv_nsec;
+}
+
+/* enum_prof_init(): allocate the profile counters of every thread of an
+ * enumerator and start the calibration of the tick counter. this must
+ * follow the registration of every pruning closure.
+ *
+ * arguments:
+ *  @E: pointer to the enumerator structure to modify.
+ *
+ * returns:
+ *  integer indicating whether (1) or not (0) the operation succeeded.
+ */
+int enum_prof_init (enum_t *E) {
+  /* get the length of the order. */
+  const unsigned int len = E->G->n_order;
+  unsigned int lev, tid;
+
+  /* allocate the closure offsets of each level. */
+  E->prof_off = (unsigned int*) malloc((len + 1) * sizeof(unsigned int));
+  if (!E->prof_off)
+    throw("unable to allocate profile offsets");
+
+  /* compute the closure offsets. */
+  for (lev = 0, E->prof_off[0] = 0; lev < len; lev++)
+    E->prof_off[lev + 1] = E->prof_off[lev] + E->prune_sz[lev];
+
+  /* allocate the counters of every thread. */
+  for (tid = 0; tid < E->nthreads; tid++) {
+    E->threads[tid].prof = (enum_prof_t*)
+      calloc(E->prof_off[len] ? E->prof_off[len] : 1, sizeof(enum_prof_t));
+
+    if (!E->threads[tid].prof)
+      throw("unable to allocate profile counters of thread %u", tid + 1);
+  }
+
+  /* start the calibration. */
+  E->prof_t0 = prof_ticks();
+  E->prof_c0 = prof_clock();
+
+  /* return success. */
+  return 1;
+}
+
+/* enum_prof_feasible(): determine whether an enumeration tree node is
+ * feasible or not, while profiling every closure that tests it. the
+ * tested node must already have been counted by the caller.
+ *
+ * arguments:
+ *  @th: pointer to the thread to feasibility-check.
+ *
+ * returns:
+ *  integer indicating whether (1) or not (0) the atom is feasible.
+ */
+int enum_prof_feasible (enum_thread_t *th) {
+  /* get local references to the pruning data and the counters. */
+  enum_t *E = th->E;
+  void **data = E->prune_data[th->level];
+  enum_prune_test_fn *func = E->prune[th->level];
+  enum_prof_t *prof = th->prof + E->prof_off[th->level];
+  const unsigned int n = E->prune_sz[th->level];
+
+  /* loop over the array of pruning function pointers. */
+  for (unsigned int i = 0; i < n; i++) {
+    /* time the closure. */
+    const unsigned long long t0 = prof_ticks();
+    const int ret = (func[i])(E, th, data[i]);
+    prof[i].ticks += prof_ticks() - t0;
+    prof[i].ncall++;
+
+    /* return infeasible if the closure returns a prune. */
+    if (ret) {
+      prof[i].nprune++;
+      return 0;
+    }
+  }
+
+  /* return feasible. */
+  return 1;
+}
+
+/* enum_prof_sum(): sum the profile counters of a closure over all
+ * threads of an enumerator.
+ *
+ * arguments:
+ *  @E: pointer to the enumerator structure to access.
+ *  @k: index of the closure in the counters of each thread.
+ *  @sum: pointer to the output counters.
+ */
+void enum_prof_sum (enum_t *E, unsigned int k, enum_prof_t *sum) {
+  /* sum the counters of every thread. */
+  sum->ticks = 0;
+  sum->ncall = sum->nprune = 0;
+  for (unsigned int tid = 0; tid < E->nthreads; tid++) {
+    sum->ticks += E->threads[tid].prof[k].ticks;
+    sum->ncall += E->threads[tid].prof[k].ncall;
+    sum->nprune += E->threads[tid].prof[k].nprune;
+  }
+}
+
+/* enum_prof_hz(): calibrate the tick counter of an enumerator against
+ * the monotonic clock, over the time elapsed since profiling began.
+ *
+ * arguments:
+ *  @E: pointer to the enumerator structure to access.
+ *
+ * returns:
+ *  number of ticks per microsecond.
+ */
+double enum_prof_hz (enum_t *E) {
+  /* compare the elapsed ticks and microseconds. */
+  const double dt = prof_clock() - E->prof_c0;
+  return (dt > 0.0 ? (double) (prof_ticks() - E->prof_t0) / dt : 1.0);
+}
+
+/* prof_row(): output a single row of the pruning profile table.
+ *
+ * arguments:
+ *  @fh: file handle to write the row into.
+ *  @label: label of the row.
+ *  @sum: summed counters of the row.
+ *  @hz: number of ticks per microsecond.
+ *  @logl: base-10 logarithm of the leaves eliminated per prune.
+ */
+static void prof_row (FILE *fh, const char *label, const enum_prof_t *sum,
+                      double hz, double logl) {
+  /* compute the per-call ticks and the prune rate. */
+  const double tpc = (sum->ncall ? (double) sum->ticks /
+                                   (double) sum->ncall : 0.0);
+  const double rate = (sum->ticks ? (double) sum->nprune * hz /
+                                    (double) sum->ticks : 0.0);
+
+  /* output the row. */
+  fprintf(fh, "  %-12s : %14lu %14lu %12.1lf %12.4lf",
+          label, sum->ncall, sum->nprune, tpc, rate);
+
+  if (logl >= 0.0)
+    fprintf(fh, "  10^%.3lf\n", logl);
+  else
+    fprintf(fh, "\n");
+}
+
+/* enum_prof_report(): output the pruning profile of an enumerator as a
+ * table, with one row for each pruning method at each level and a total
+ * row for each method, and write the counters of every closure into the
+ * profile file.
+ *
+ * the leaves eliminated by a prune at a given level are those of the
+ * dense subtree below the pruned node, which is the product of the branch
+ * counts of every later level.
+ *
+ * arguments:
+ *  @E: pointer to the enumerator structure to access.
+ *
+ * returns:
+ *  integer indicating whether (1) or not (0) the profile file was
+ *  written successfully.
+ */
+int enum_prof_report (enum_t *E) {
+  /* get the length of the order and the state of the first thread. */
+  const unsigned int len = E->G->n_order;
+  const enum_thread_node_t *state = E->threads[0].state;
+
+  /* declare required variables:
+   *  @hz: calibrated number of ticks per microsecond.
+   *  @logl: base-10 logarithm of the dense leaves below each level.
+   *  @names: distinct names of the registered pruning methods.
+   *  @sum, @tot: counters of a table row and of a pruning method.
+   *  @cl: counters of a single closure.
+   *  @fh: file handle of the profile file.
+   */
+  double hz, *logl;
+  const char **names;
+  unsigned int i, k, m, lev, n_names;
+  enum_prof_t sum, tot, cl;
+  FILE *fh;
+
+  /* calibrate the tick counter. */
+  hz = enum_prof_hz(E);
+
+  /* allocate the leaf counts and method names. */
+  logl = (double*) malloc((len + 1) * sizeof(double));
+  names = (const char**) malloc((E->prof_off[len] + 1) * sizeof(char*));
+  if (!logl || !names) {
+    free(logl);
+    free(names);
+    throw("unable to allocate profile report");
+  }
+
+  /* compute the leaf counts below each level. */
+  for (lev = len, logl[len] = 0.0; lev > 0; lev--)
+    logl[lev - 1] = logl[lev] +
+      (state[lev - 1].nb > 1 ? log10((double) state[lev - 1].nb) : 0.0);
+
+  /* gather the names of the registered pruning methods. */
+  for (lev = 0, n_names = 0; lev < len; lev++) {
+    for (i = 0; i < E->prune_sz[lev]; i++) {
+      for (m = 0; m < n_names && names[m] != E->prune_name[lev][i]; m++);
+      if (m == n_names)
+        names[n_names++] = E->prune_name[lev][i];
+    }
+  }
+
+  /* loop over the pruning methods. */
+  for (m = 0; m < n_names; m++) {
+    /* output an initial header. */
+    printf("\nPruning profile [%s, %.1lf ticks/us]:\n"
+           "  %-12s : %14s %14s %12s %12s  %s\n",
+           names[m], hz, "level", "calls", "prunes",
+           "ticks/call", "prunes/us", "leaves/prune");
+
+    /* loop over the levels of the graph order. */
+    memset(&tot, 0, sizeof(enum_prof_t));
+    for (lev = 0; lev < len; lev++) {
+      /* sum the closures of the method at the current level. */
+      memset(&sum, 0, sizeof(enum_prof_t));
+      for (i = 0; i < E->prune_sz[lev]; i++) {
+        if (E->prune_name[lev][i] != names[m]) continue;
+
+        enum_prof_sum(E, E->prof_off[lev] + i, &cl);
+        sum.ticks += cl.ticks;
+        sum.ncall += cl.ncall;
+        sum.nprune += cl.nprune;
+      }
+
+      /* skip levels that the method never tested. */
+      if (!sum.ncall) continue;
+
+      /* accumulate the method totals. */
+      tot.ticks += sum.ticks;
+      tot.ncall += sum.ncall;
+      tot.nprune += sum.nprune;
+
+      /* get the atom/residue indices and names. */
+      const unsigned int ai = E->G->order[lev];
+      const unsigned int ri = E->P->atoms[ai].res_id;
+      const char *atomi = E->P->atoms[ai].name;
+      const char *resi = peptide_get_resname(E->P, ri);
+
+      /* output the statistics of the level. */
+      char label[32];
+      snprintf(label, sizeof(label), "%3s%-4u %-4s", resi, ri + 1, atomi);
+      prof_row(stdout, label, &sum, hz, logl[lev + 1]);
+    }
+
+    /* output the method totals. */
+    prof_row(stdout, "total", &tot, hz, -1.0);
+  }
+
+  /* open the profile file. */
+  fh = fopen(E->fname_prof, "w");
+  if (!fh) {
+    free(logl);
+    free(names);
+    throw("unable to open profile file '%s'", E->fname_prof);
+  }
+
+  /* write the header and the counters of every closure. */
+  fprintf(fh, "# ibp-ng pruning profile\n"
+              "# ticks_per_us %.6le\n"
+              "# level\tresidue\tatom\tmethod\tclosure\tcalls\tprunes"
+              "\tticks\tus\tprunes_per_us\tlog10_leaves_per_prune\n", hz);
+
+  for (lev = 0; lev < len; lev++) {
+    /* get the atom/residue indices and names. */
+    const unsigned int ai = E->G->order[lev];
+    const unsigned int ri = E->P->atoms[ai].res_id;
+    const char *atomi = E->P->atoms[ai].name;
+    const char *resi = peptide_get_resname(E->P, ri);
+
+    for (i = 0, k = E->prof_off[lev]; i < E->prune_sz[lev]; i++, k++) {
+      enum_prof_sum(E, k, &cl);
+      fprintf(fh, "%u\t%s%u\t%s\t%s\t%u\t%lu\t%lu\t%llu"
+                  "\t%.3lf\t%.6le\t%.6lf\n",
+              lev, resi, ri + 1, atomi, E->prune_name[lev][i], i,
+              cl.ncall, cl.nprune, cl.ticks, (double) cl.ticks / hz,
+              cl.ticks ? (double) cl.nprune * hz / (double) cl.ticks : 0.0,
+              logl[lev + 1]);
+    }
+  }
+
+  /* close the file and free the report arrays. */
+  fclose(fh);
+  free(logl);
+  free(names);
+
+  /* output an informational message. */
+  info("pruning profile written to '%s'", E->fname_prof);
+
+  /* return success. */
+  return 1;
+}
+
+/* enum_prof_free(): free the profile counters of an enumerator.
+ *
+ * arguments:
+ *  @E: pointer to the enumerator structure to modify.
+ */
+void enum_prof_free (enum_t *E) {
+  /* free the counters of every thread. */
+  for (unsigned int tid = 0; E->threads && tid < E->nthreads; tid++) {
+    free(E->threads[tid].prof);
+    E->threads[tid].prof = NULL;
+  }
+
+  /* free the closure offsets. */
+  free(E->prof_off);
+  E->prof_off = NULL;
+}
@@ -4,6 +4,21 @@
 #include "enum-thread.h"
 #include "enum-prune.h"
 
+/* ENUM_DDF_BLOCK: number of preceeding levels that are checked at once
+ * by the dense test, which the compiler is able to vectorize.
+ */
+#define ENUM_DDF_BLOCK  8
+
+/* ENUM_DDF_SAMPLE: inverse rate of the dense test calls that count the
+ * tests and prunes of every preceeding level, with each counted call
+ * standing for ENUM_DDF_SAMPLE calls. calls are drawn by the leading
+ * ENUM_DDF_SAMPLE_BITS bits of a golden-ratio sequence of the call
+ * count, so that the draws do not follow the periodic order of the
+ * branches of a level.
+ */
+#define ENUM_DDF_SAMPLE_BITS  4
+#define ENUM_DDF_SAMPLE       (1U << ENUM_DDF_SAMPLE_BITS)
+
 /* enum_prune_ddf_t: structure for holding information required for
  * direct distance feasibility pruning closures.
  */
@@ -12,6 +27,28 @@ typedef struct {
    * @nprune: number of prunes performed for each preceeding atom.
    */
   unsigned int *ntest, *nprune;
+
+  /* @lv: preceeding levels that have distance bounds to the level of the
+   *      closure, from the nearest to the farthest.
+   * @l2, @u2: squared lower and upper bounds of each level in @lv, with
+   *           the error tolerance folded in. in dense closures, the bounds
+   *           are instead indexed by level, and @lv is unused.
+   * @n: number of levels in @lv.
+   */
+  unsigned int *lv, n;
+  double *l2, *u2;
+
+  /* @dense: whether or not nearly every preceeding level is bounded, as
+   *         in completed graphs, so that blocks of levels are checked at
+   *         once against bounds indexed by level.
+   * @ncall: number of calls of the dense test, for sampling its counts.
+   */
+  int dense;
+  unsigned int ncall;
+
+  /* @kernel: compiled kernel that replaces the generic test, if any.
+   */
+  enum_prune_kernel_fn kernel;
 }
 enum_prune_ddf_t;
 
@@ -21,25 +58,74 @@ int enum_prune_ddf_init (enum_t *E, unsigned int lev) {
   /* declare required variables:
    *  @data: closure data pointer.
    *  @sz: closure memory footprint.
+   *  @bound: distance bound between a preceeding level and @lev.
+   *  @l, @u: lower and upper bounds, including tolerance.
+   *  @n: number of bounded preceeding levels.
    */
   enum_prune_ddf_t *data;
-  unsigned int sz;
+  unsigned int sz, ib, n;
+  value_t bound;
+  double l, u;
 
-  /* allocate the closure payload. */
-  sz = sizeof(enum_prune_ddf_t) + 2 * lev * sizeof(unsigned int);
+  /* count the preceeding levels whose bounds are able to prune. */
+  for (ib = lev - 1, n = 0; ib < lev; ib--) {
+    bound = graph_get_edge(E->G, E->G->order[ib], E->G->order[lev]);
+    if (!E->G->orig[ib] && !value_is_undefined(bound) &&
+        (bound.l - E->ddf_tol > 0.0 || isfinite(bound.u)))
+      n++;
+  }
+
+  /* allocate the closure payload. dense closures hold bounds for every
+   * preceeding level.
+   */
+  const int dense = (lev >= 2 * ENUM_DDF_BLOCK && 4 * n >= 3 * lev);
+  const unsigned int nb = (dense ? lev : n);
+  sz = sizeof(enum_prune_ddf_t) + 2 * lev * sizeof(unsigned int)
+     + nb * (sizeof(unsigned int) + 2 * sizeof(double));
   data = (enum_prune_ddf_t*) malloc(sz);
   if (!data)
     return 0;
 
   /* initialize the payload array pointers. */
-  data->ntest = (unsigned int*)
-    (((char*) data) + sizeof(enum_prune_ddf_t));
-  data->nprune = (unsigned int*)
-    (((char*) data->ntest) + lev * sizeof(unsigned int));
+  data->l2 = (double*) (((char*) data) + sizeof(enum_prune_ddf_t));
+  data->u2 = data->l2 + nb;
+  data->ntest = (unsigned int*) (data->u2 + nb);
+  data->nprune = data->ntest + lev;
+  data->lv = data->nprune + lev;
+  data->n = n;
+  data->dense = dense;
+  data->ncall = 0;
 
   /* initialize the payload array contents. */
   memset(data->ntest, 0, lev * sizeof(unsigned int));
   memset(data->nprune, 0, lev * sizeof(unsigned int));
+  data->kernel = NULL;
+
+  /* initialize the bounds of dense closures to bounds that never prune,
+   * which remain in place for duplicate and unbounded levels.
+   */
+  for (ib = 0; dense && ib < lev; ib++) {
+    data->l2[ib] = 0.0;
+    data->u2[ib] = INFINITY;
+  }
+
+  /* store the squared bounds of the preceeding levels, nearest first.
+   * trivial lower bounds become zero and missing upper bounds become
+   * infinite, so neither one is able to prune.
+   */
+  for (ib = lev - 1, n = 0; ib < lev; ib--) {
+    bound = graph_get_edge(E->G, E->G->order[ib], E->G->order[lev]);
+    if (E->G->orig[ib] || value_is_undefined(bound) ||
+        !(bound.l - E->ddf_tol > 0.0 || isfinite(bound.u)))
+      continue;
+
+    l = bound.l - E->ddf_tol;
+    u = bound.u + E->ddf_tol;
+    data->lv[n] = ib;
+    data->l2[dense ? ib : n] = (l > 0.0 ? l * l : 0.0);
+    data->u2[dense ? ib : n] = u * u;
+    n++;
+  }
 
   /* register a closure. */
   if (!enum_prune_add_closure(E, lev, enum_prune_ddf, data))
@@ -49,44 +135,128 @@ int enum_prune_ddf_init (enum_t *E, unsigned int lev) {
   return 1;
 }
 
+/* ddf_dense(): check the bounds of a dense ddf closure in blocks of
+ * preceeding levels, from the nearest block to the farthest. the levels
+ * of each block are checked without branches, and the tests and prunes
+ * of every level are only counted in one of every ENUM_DDF_SAMPLE calls,
+ * so that both counts are sampled from the same calls.
+ *
+ * arguments:
+ *  @ddf_data: pointer to the closure payload.
+ *  @state: state of the thread to check.
+ *  @lev: level of the closure.
+ *
+ * returns:
+ *  integer indicating whether (1) or not (0) the node should be pruned.
+ */
+static inline int ddf_dense (enum_prune_ddf_t *ddf_data,
+                             const enum_thread_node_t *state,
+                             const unsigned int lev) {
+  /* declare required variables:
+   *  @d2: squared distances of the levels of a block.
+   *  @lo, @hi: first and one-past-last levels of a block.
+   *  @stop: farthest level tested, for counting.
+   *  @v, @vmax: bound violations of a level and of a block, which are
+   *             positive for levels that are out of bounds.
+   */
+  double d2[ENUM_DDF_BLOCK], v, vmax = 0.0;
+  unsigned int lo, hi, j, stop = 0;
+
+  /* locally store the bounds and the end position. */
+  const double *l2 = ddf_data->l2;
+  const double *u2 = ddf_data->u2;
+  const vector_t a = state[lev].pos;
+
+  /* loop over the blocks of preceeding levels. the farthest block holds
+   * the remaining levels, and may be partial.
+   */
+  for (hi = lev; hi > 0; hi = lo) {
+    lo = (hi > ENUM_DDF_BLOCK ? hi - ENUM_DDF_BLOCK : 0);
+
+    /* compute the squared distances of the block. */
+    for (j = 0; j < ENUM_DDF_BLOCK && lo + j < hi; j++) {
+      const vector_t *b = &state[lo + j].pos;
+      d2[j] = (a.x - b->x) * (a.x - b->x) +
+              (a.y - b->y) * (a.y - b->y) +
+              (a.z - b->z) * (a.z - b->z);
+    }
+
+    /* compute the largest bound violation of the block. */
+    for (j = 0; j < ENUM_DDF_BLOCK && lo + j < hi; j++) {
+      v = (l2[lo + j] - d2[j] > d2[j] - u2[lo + j] ?
+           l2[lo + j] - d2[j] : d2[j] - u2[lo + j]);
+      vmax = (v > vmax ? v : vmax);
+    }
+
+    /* stop at the first block that is out of bounds. */
+    if (vmax > 0.0)
+      break;
+  }
+
+  /* return unless the call is sampled. */
+  if ((++ddf_data->ncall * 0x9e3779b9U) >> (32 - ENUM_DDF_SAMPLE_BITS))
+    return (vmax > 0.0);
+
+  /* attribute a prune to the nearest level that is out of bounds. */
+  if (vmax > 0.0) {
+    for (j = hi - lo - 1; j < ENUM_DDF_BLOCK; j--) {
+      if (d2[j] < l2[lo + j] || d2[j] > u2[lo + j]) {
+        stop = lo + j;
+        ddf_data->nprune[stop] += ENUM_DDF_SAMPLE;
+        break;
+      }
+    }
+  }
+
+  /* count the tests of the sampled call, down to the pruning level. */
+  for (j = stop; j < lev; j++)
+    ddf_data->ntest[j] += ENUM_DDF_SAMPLE;
+
+  /* prune if any level was out of bounds. */
+  return (vmax > 0.0);
+}
+
 /* enum_prune_ddf(): determine whether an enumerator tree may be pruned
  * at a given node based on direct distance feasibility (DDF).
  */
 int enum_prune_ddf (enum_t *E, enum_thread_t *th, void *data) {
   /* declare required variables:
-   *  @bound: distance bound between upstream and end.
-   *  @dist: computed distance between upstream and end.
+   *  @d2: squared distance between upstream and end.
    */
-  value_t bound;
-  double dist;
+  double d2;
 
   /* get the payload. */
   enum_prune_ddf_t *ddf_data = (enum_prune_ddf_t*) data;
 
-  /* locally store the level, thread length, and originality array. */
-  const unsigned int n = E->G->n_order;
-  const unsigned int *dup = E->G->orig;
-  const unsigned int ia = th->level;
+  /* use the compiled kernel of the level, if available. */
+  if (ddf_data->kernel)
+    return ddf_data->kernel(th->state, ddf_data->ntest, ddf_data->nprune);
 
-  /* locally store the end position. */
-  vector_t *thpos = &th->state[ia].pos;
+  /* use the block test for dense closures. */
+  if (ddf_data->dense)
+    return ddf_dense(ddf_data, th->state, th->level);
 
-  /* loop over all upstream embedded atoms. */
-  for (unsigned int ib = ia - 1; ib < n; ib--) {
-    /* skip duplicate atoms. */
-    if (dup[ib]) continue;
+  /* locally store the bounded levels and their squared bounds. */
+  const unsigned int *lv = ddf_data->lv;
+  const double *l2 = ddf_data->l2;
+  const double *u2 = ddf_data->u2;
+  const unsigned int n = ddf_data->n;
 
-    /* obtain the distance bound on the two nodes. */
-    bound = graph_get_edge(E->G, E->G->order[ib],
-                                 E->G->order[ia]);
+  /* locally store the end position. */
+  const vector_t a = th->state[th->level].pos;
 
-    /* compute the distance between the two nodes. */
-    dist = vector_dist(&th->state[ib].pos, thpos);
+  /* loop over the bounded upstream embedded atoms. */
+  for (unsigned int k = 0; k < n; k++) {
+    /* compute the squared distance between the two nodes. */
+    const vector_t *b = &th->state[lv[k]].pos;
+    d2 = (a.x - b->x) * (a.x - b->x) +
+         (a.y - b->y) * (a.y - b->y) +
+         (a.z - b->z) * (a.z - b->z);
 
     /* prune if the distance is out of the bound. */
-    ddf_data->ntest[ib]++;
-    if (bound.l - dist > E->ddf_tol || dist - bound.u > E->ddf_tol) {
-      ddf_data->nprune[ib]++;
+    ddf_data->ntest[lv[k]]++;
+    if (d2 < l2[k] || d2 > u2[k]) {
+      ddf_data->nprune[lv[k]]++;
       return 1;
     }
   }
@@ -95,10 +265,64 @@ int enum_prune_ddf (enum_t *E, enum_thread_t *th, void *data) {
   return 0;
 }
 
+/* enum_prune_ddf_valid(): check the node at the current level of a thread
+ * against the distance bounds of every ddf closure of the level, without
+ * counting any tests or prunes. this validates nodes that have already
+ * been counted once, such as leaves re-embedded in double precision.
+ *
+ * arguments:
+ *  @E: pointer to the enumerator holding the closures.
+ *  @th: pointer to the thread to check.
+ *
+ * returns:
+ *  integer indicating whether (1) or not (0) the node is within bounds.
+ */
+int enum_prune_ddf_valid (enum_t *E, enum_thread_t *th) {
+  /* get the level and the end position of the thread. */
+  const unsigned int lev = th->level;
+  const vector_t a = th->state[lev].pos;
+  double d2;
+
+  /* loop over the ddf closures of the level. */
+  for (unsigned int i = 0; i < E->prune_sz[lev]; i++) {
+    if (E->prune[lev][i] != enum_prune_ddf)
+      continue;
+
+    /* get the payload. dense closures index their bounds by level. */
+    const enum_prune_ddf_t *ddf_data =
+      (const enum_prune_ddf_t*) E->prune_data[lev][i];
+    const unsigned int n = (ddf_data->dense ? lev : ddf_data->n);
+
+    /* check every bounded preceeding level. */
+    for (unsigned int k = 0; k < n; k++) {
+      const unsigned int ib = (ddf_data->dense ? k : ddf_data->lv[k]);
+      const vector_t *b = &th->state[ib].pos;
+      d2 = (a.x - b->x) * (a.x - b->x) +
+           (a.y - b->y) * (a.y - b->y) +
+           (a.z - b->z) * (a.z - b->z);
+
+      if (d2 < ddf_data->l2[k] || d2 > ddf_data->u2[k])
+        return 0;
+    }
+  }
+
+  /* return valid. */
+  return 1;
+}
+
+/* enum_prune_ddf_kernel(): replace the generic test of a direct distance
+ * feasibility (DDF) pruning closure by a compiled kernel.
+ */
+void enum_prune_ddf_kernel (void *data, enum_prune_kernel_fn kernel) {
+  /* store the kernel in the closure payload. */
+  ((enum_prune_ddf_t*) data)->kernel = kernel;
+}
+
 /* enum_prune_ddf_report(): output a report for the direct distance
  * feasbility (DDF) pruning closure.
  */
-void enum_prune_ddf_report (enum_t *E, unsigned int lev, void *data) {
+void enum_prune_ddf_report (enum_t *E, FILE *fh,
+                            unsigned int lev, void *data) {
   /* get the closure payload. */
   enum_prune_ddf_t *ddf_data = (enum_prune_ddf_t*) data;
 
@@ -112,8 +336,9 @@ void enum_prune_ddf_report (enum_t *E, unsigned int lev, void *data) {
 
   /* loop over all tested predecessors. */
   for (unsigned int j = lev - 1; j < E->G->n_order; j--) {
-    /* skip duplicates and non-pruned predecessors. */
-    if (E->G->orig[j] || !ddf_data->nprune[j]) continue;
+    /* skip duplicates, and non-pruned or untested predecessors. */
+    if (E->G->orig[j] || !ddf_data->nprune[j] || !ddf_data->ntest[j])
+      continue;
 
     /* get the second atom/residue indices. */
     unsigned int aj = E->G->order[j];
@@ -128,11 +353,11 @@ void enum_prune_ddf_report (enum_t *E, unsigned int lev, void *data) {
                ((double) ddf_data->ntest[j]) * 100.0;
 
     /* output the statistics. */
-    printf("  %3s%-4u %-4s | %3s%-4u %-4s : "
-           "%16u/%-16u  %6.2lf%%\n",
-           resi, ri + 1, atomi,
-           resj, rj + 1, atomj,
-           ddf_data->nprune[j], ddf_data->ntest[j], f);
+    fprintf(fh, "  %3s%-4u %-4s | %3s%-4u %-4s : "
+                "%16u/%-16u  %6.2lf%%\n",
+                resi, ri + 1, atomi,
+                resj, rj + 1, atomj,
+                ddf_data->nprune[j], ddf_data->ntest[j], f);
   }
 }
 
@@ -4,307 +4,513 @@
 #include "enum-thread.h"
 #include "enum-prune.h"
 
-/* define constants to represent pruning closure @type.
+/* define constants to represent the types of energy terms, in the order
+ * in which they are evaluated.
  */
 #define ENERGY_BOND     0
 #define ENERGY_ANGLE    1
 #define ENERGY_DIHEDRAL 2
 #define ENERGY_DISTANCE 3
 #define ENERGY_CONTACT  4
+#define ENERGY_TYPES    5
+
+/* ENERGY_SLACK: relative amount by which lower bounds on the energy of
+ * future levels are reduced, to absorb rounding in the embedding.
+ */
+#define ENERGY_SLACK  1.0e-9
+
+/* enum_prune_energy_terms_t: structure for holding the contiguous term
+ * arrays of a single type of energy term.
+ */
+typedef struct {
+  /* @n: number of terms of the type.
+   * @lv: graph levels of the atoms of each term, four per term.
+   * @mu, @kappa: precomputed constants of each term. see the evaluation
+   *              loops in enum_prune_energy() for their meaning.
+   */
+  unsigned int n, *lv;
+  double *mu, *kappa;
+}
+enum_prune_energy_terms_t;
 
 /* enum_prune_energy_t: structure for holding information
  * required for energetic pruning closures.
  */
-typedef struct enum_prune_energy enum_prune_energy_t;
-struct enum_prune_energy {
-  /* @type: type of energy term to be feasibility checked.
+typedef struct {
+  /* @terms: term arrays of each type of energy term.
    */
-  unsigned int type;
+  enum_prune_energy_terms_t terms[ENERGY_TYPES];
 
-  /* @ntest, @nprune: test and prune counts of the current closure.
-   * @mu, @kappa: mean and precision force field parameters.
-   * @n: backward step-counts for the prior atoms.
+  /* @lb: lower bound on the energy of the terms of the closure.
+   * @rest: lower bound on the energy of the terms of all later levels.
    */
-  unsigned int ntest, nprune;
-  unsigned int n[4];
-  double mu, kappa;
+  double lb, rest;
 
-  /* @next: pointer to the next energy term structure.
+  /* @ntest, @nprune: test and prune counts of each type of term.
    */
-  enum_prune_energy_t *next;
-};
+  unsigned int ntest[ENERGY_TYPES], nprune[ENERGY_TYPES];
+}
+enum_prune_energy_t;
+
+/* energy_exact(): get the distance between the atoms at two levels, if
+ * every embedding places them at an exact distance. this holds within
+ * the initial frame, and between each atom and the two atoms that it is
+ * embedded from.
+ *
+ * arguments:
+ *  @E: pointer to the enumerator structure to access.
+ *  @a, @b: graph levels of the two atoms.
+ *  @d: pointer to the output distance.
+ *
+ * returns:
+ *  integer indicating whether (1) or not (0) the distance is exact.
+ */
+static int energy_exact (enum_t *E, unsigned int a, unsigned int b,
+                         double *d) {
+  /* get references to the graph and the originality array. */
+  graph_t *G = E->G;
+  const unsigned int *dup = G->orig;
+
+  /* get the later and earlier levels. */
+  const unsigned int hi = (a > b ? a : b);
+  const unsigned int lo = (a > b ? b : a);
+
+  /* check that the earlier atom places the later one. */
+  if (hi == lo || (hi > 2 && lo != hi - 1 - dup[hi - 1] &&
+                             lo != hi - 2 - dup[hi - 2]))
+    return 0;
 
-/* enum_prune_energy_init(): initialize the energy enumerator.
+  /* get the distance from the graph. */
+  const value_t e = graph_get_edge(G, G->order[lo], G->order[hi]);
+  if (!value_is_scalar(e))
+    return 0;
+
+  *d = e.l;
+  return 1;
+}
+
+/* energy_bound(): compute a lower bound on the energy of the terms of
+ * an energetic closure, from the distances that are exact in every
+ * embedding. terms without exact distances are bounded by zero.
+ *
+ * arguments:
+ *  @E: pointer to the enumerator structure to access.
+ *  @data: pointer to the closure data to access.
+ *
+ * returns:
+ *  lower bound on the energy of the closure.
  */
-int enum_prune_energy_init (enum_t *E, unsigned int lev) {
+static double energy_bound (enum_t *E, const enum_prune_energy_t *data) {
   /* declare required variables:
-   *  @i: peptide bond/angle/torsion/improper array index.
-   *  @k: atoms array index.
-   *  @n_data: number of linked closure data structures.
-   *  @id: atom index that has just been embedded.
-   *  @ids: atom indices in each energetic term.
-   *  @levs: reorder indices of each atom.
-   *  @data: closure data pointer.
+   *  @t: term arrays of each type.
+   *  @lv: levels of the atoms of each term.
+   *  @dab, @dac, @dbc: exact distances between the atoms of a term.
+   *  @x: deviation of each term.
+   *  @lb: lower bound on the energy.
    */
-  unsigned int i, k, n, n_data, id, *ids, levs[4];
-  enum_prune_energy_t *data;
-
-  /* define a contact force constant scale factor. */
-  const double Z = 3.84147997;
+  const enum_prune_energy_terms_t *t;
+  double dab, dac, dbc, x, lb;
+  const unsigned int *lv;
+  unsigned int i;
+
+  /* bonded distances. */
+  t = data->terms + ENERGY_BOND;
+  for (i = 0, lb = 0.0, lv = t->lv; i < t->n; i++, lv += 4) {
+    if (!energy_exact(E, lv[0], lv[1], &dab)) continue;
+    x = dab - t->mu[i];
+    lb += t->kappa[i] * x * x;
+  }
 
-  /* get the current atom index. */
-  id = E->G->order[lev];
+  /* two-bond angles, from the distances between all three atoms. */
+  t = data->terms + ENERGY_ANGLE;
+  for (i = 0, lv = t->lv; i < t->n; i++, lv += 4) {
+    if (!energy_exact(E, lv[0], lv[1], &dab) ||
+        !energy_exact(E, lv[0], lv[2], &dac) ||
+        !energy_exact(E, lv[1], lv[2], &dbc))
+      continue;
 
-  /* initialize the closure data. */
-  data = NULL;
-  n_data = 0;
+    x = distances_to_angle(dab, dac, dbc);
+    x = acos(x < -1.0 ? -1.0 : x > 1.0 ? 1.0 : x) - t->mu[i];
+    lb += t->kappa[i] * x * x;
+  }
 
-  /* loop over the bonds. */
-  for (i = 0, n = 2; i < E->P->n_bonds; i++) {
-    /* get the atom indices. */
-    ids = E->P->bonds[i].atom_id;
+  /* non-bonded distances. */
+  t = data->terms + ENERGY_DISTANCE;
+  for (i = 0, lv = t->lv; i < t->n; i++, lv += 4) {
+    if (!energy_exact(E, lv[0], lv[1], &dab)) continue;
+    x = log(dab) - t->mu[i];
+    lb += t->kappa[i] * x * x;
+  }
 
-    /* skip if the last-embedded atom is not in the bond. */
-    if (id != ids[0] && id != ids[1])
+  /* close contacts, unless the cutoff neglects them. */
+  t = data->terms + ENERGY_CONTACT;
+  for (i = 0, lv = t->lv; i < t->n; i++, lv += 4) {
+    if (!energy_exact(E, lv[0], lv[1], &dab) ||
+        (E->cutoff > 0.0 && dab >= E->cutoff))
       continue;
 
-    /* get the graph level of each atom. */
-    levs[0] = levs[1] = levs[2] = levs[3] = lev;
-    for (k = 0; k < n; k++)
-      levs[k] = enum_prune_get_level(E->G->order, lev, ids[k]);
+    dab = dab * dab;
+    lb += t->kappa[i] / (dab * dab * dab);
+  }
 
-    /* skip if all other atoms in the order have not been embedded. */
-    if (levs[0] > lev ||
-        levs[1] > lev)
-      continue;
+  /* dihedrals are not bounded, as the discretized dihedrals of the tree
+   * are not known to the energetic closures.
+   */
+  return lb * (1.0 - ENERGY_SLACK);
+}
 
-    /* reallocate the closure payload. */
-    n_data++;
-    data = (enum_prune_energy_t*)
-      realloc(data, n_data * sizeof(enum_prune_energy_t));
-
-    /* check for allocation failures. */
-    if (!data)
-      return 0;
-
-    /* store the term type. */
-    data[n_data - 1].type = (E->P->bonds[i].is_virtual
-                              ? ENERGY_DISTANCE
-                              : ENERGY_BOND);
-
-    /* initialize the counters. */
-    data[n_data - 1].ntest = data[n_data - 1].nprune = 0;
-
-    /* store the offsets. */
-    data[n_data - 1].n[0] = 0;
-    data[n_data - 1].n[1] = 0;
-    data[n_data - 1].n[2] = 0;
-    data[n_data - 1].n[3] = 0;
-    for (k = 0; k < n; k++)
-      data[n_data - 1].n[k] = lev - levs[k];
-
-    /* store the term parameters. */
-    data[n_data - 1].mu = E->P->bonds[i].mu;
-    data[n_data - 1].kappa = E->P->bonds[i].kappa;
-
-    /* initialize the next-payload pointer. */
-    data[n_data - 1].next = NULL;
+/* energy_rest(): store into every energetic closure of an enumerator
+ * the lower bound on the energy of all later levels.
+ *
+ * arguments:
+ *  @E: pointer to the enumerator structure to modify.
+ */
+static void energy_rest (enum_t *E) {
+  /* declare required variables:
+   *  @rest: lower bound on the energy of the levels visited so far.
+   */
+  enum_prune_energy_t *data;
+  double rest = 0.0;
+
+  /* loop backwards over the levels of the order. */
+  for (unsigned int lev = E->G->n_order - 1; lev < E->G->n_order; lev--) {
+    for (unsigned int i = 0; i < E->prune_sz[lev]; i++) {
+      /* skip closures of other pruning methods. */
+      if (E->prune[lev][i] != enum_prune_energy) continue;
+
+      /* store and accumulate the bounds. */
+      data = (enum_prune_energy_t*) E->prune_data[lev][i];
+      data->rest = rest;
+      rest += data->lb;
+    }
   }
 
-  /* loop over the angles. */
-  for (i = 0, n = 3; i < E->P->n_angles; i++) {
-    /* get the atom indices. */
-    ids = E->P->angles[i].atom_id;
+  /* output an informational message about the bound. */
+  info("energy of any structure is at least %.3le", rest);
+}
 
-    /* skip if the last-embedded atom is not in the angle. */
-    if (id != ids[0] && id != ids[1] && id != ids[2])
-      continue;
+/* energy_levels(): get the graph levels of the atoms of a bonded energy
+ * term that is completed at a given level.
+ *
+ * arguments:
+ *  @E: pointer to the enumerator structure to access.
+ *  @lev: graph level that completes the term.
+ *  @ids: atom indices of the term.
+ *  @n: number of atoms in the term.
+ *  @levs: output array of four graph levels.
+ */
+static inline void energy_levels (enum_t *E, unsigned int lev,
+                                  const unsigned int *ids, unsigned int n,
+                                  unsigned int *levs) {
+  /* look up the first level of each atom, and pad the unused levels. */
+  levs[0] = levs[1] = levs[2] = levs[3] = lev;
+  for (unsigned int k = 0; k < n; k++)
+    levs[k] = E->G->ordrev[ids[k]];
+}
 
-    /* get the graph level of each atom. */
-    levs[0] = levs[1] = levs[2] = levs[3] = lev;
-    for (k = 0; k < n; k++)
-      levs[k] = enum_prune_get_level(E->G->order, lev, ids[k]);
+/* energy_add(): append a term to the arrays of one type of energy term,
+ * which have been allocated to hold every term of the type.
+ *
+ * arguments:
+ *  @terms: pointer to the term arrays to modify.
+ *  @levs: graph levels of the four atoms of the new term.
+ *  @mu, @kappa: precomputed constants of the new term.
+ */
+static inline void energy_add (enum_prune_energy_terms_t *terms,
+                               const unsigned int *levs,
+                               double mu, double kappa) {
+  /* get the new term index. */
+  const unsigned int i = terms->n++;
+
+  /* store the levels and constants of the term. */
+  memcpy(terms->lv + 4 * i, levs, 4 * sizeof(unsigned int));
+  terms->mu[i] = mu;
+  terms->kappa[i] = kappa;
+}
 
-    /* skip if all other atoms in the order have not been embedded. */
-    if (levs[0] > lev ||
-        levs[1] > lev ||
-        levs[2] > lev)
-      continue;
+/* energy_key(): compute the hashed cell of a contact grid that holds a
+ * given set of cell coordinates.
+ *
+ * arguments:
+ *  @E: pointer to the enumerator structure to access.
+ *  @c: integer cell coordinates.
+ *
+ * returns:
+ *  index of the hashed cell.
+ */
+static inline int energy_key (const enum_t *E, const int *c) {
+  /* mix the coordinates with large odd multipliers. */
+  return (int) (((unsigned int) c[0] * 73856093U ^
+                 (unsigned int) c[1] * 19349663U ^
+                 (unsigned int) c[2] * 83492791U) & (E->grid_sz - 1));
+}
 
-    /* reallocate the closure payload. */
-    n_data++;
-    data = (enum_prune_energy_t*)
-      realloc(data, n_data * sizeof(enum_prune_energy_t));
-
-    /* check for allocation failures. */
-    if (!data)
-      return 0;
-
-    /* store the term type and initialize the counters. */
-    data[n_data - 1].type = ENERGY_ANGLE;
-    data[n_data - 1].ntest = data[n_data - 1].nprune = 0;
-
-    /* store the offsets. */
-    data[n_data - 1].n[0] = 0;
-    data[n_data - 1].n[1] = 0;
-    data[n_data - 1].n[2] = 0;
-    data[n_data - 1].n[3] = 0;
-    for (k = 0; k < n; k++)
-      data[n_data - 1].n[k] = lev - levs[k];
-
-    /* store the term parameters. */
-    data[n_data - 1].mu = E->P->angles[i].mu;
-    data[n_data - 1].kappa = E->P->angles[i].kappa;
-
-    /* initialize the next-payload pointer. */
-    data[n_data - 1].next = NULL;
+/* energy_grid(): sum the contact energies of the atom at the current
+ * level of a thread over the atoms within the cutoff distance, which are
+ * found from the contact grid of the thread.
+ *
+ * the grid files the atoms of the leading levels of the thread in cells
+ * whose sides equal the cutoff. filed levels form a stack: the atoms of
+ * levels at or above the current level, and of levels that have moved,
+ * are first removed from the heads of their cells, and the levels below
+ * the current level are then filed, so that the grid follows the descent
+ * and backtracking of the traversal.
+ *
+ * arguments:
+ *  @E: pointer to the enumerator structure to access.
+ *  @th: pointer to the thread to access.
+ *  @c6: contact constant of every preceeding level.
+ *
+ * returns:
+ *  contact energy of the atom within the cutoff.
+ */
+static double energy_grid (enum_t *E, enum_thread_t *th,
+                           const double *c6) {
+  /* declare required variables:
+   *  @c, @q: cell coordinates of the atom and of each neighboring cell.
+   *  @l: level of each filed atom.
+   *  @d2: squared distance of each filed atom.
+   *  @U: contact energy within the cutoff.
+   */
+  const enum_thread_node_t *state = th->state;
+  const unsigned int *dup = E->G->orig;
+  const unsigned int lev = th->level;
+  const unsigned int empty = E->G->n_order;
+  const double h = E->cutoff, rc2 = h * h;
+  unsigned int l, lim;
+  int c[3], q[4], *cl;
+  double d2, U;
+
+  /* remove the filed levels at or above the current level, and above
+   * the lowest moved level, from the heads of their cells.
+   */
+  lim = (th->grid_lim < lev ? th->grid_lim : lev);
+  while (th->grid_n > lim) {
+    l = --th->grid_n;
+    if (!dup[l])
+      th->grid_head[th->grid_cell[4 * l + 3]] = th->grid_next[l];
   }
 
-  /* loop over the torsions. */
-  for (i = 0, n = 4; i < E->P->n_torsions; i++) {
-    /* get the atom indices. */
-    ids = E->P->torsions[i].atom_id;
+  /* file the atoms of the levels below the current level. */
+  for (l = th->grid_n; l < lev; l++) {
+    if (dup[l]) continue;
+
+    cl = th->grid_cell + 4 * l;
+    cl[0] = (int) floor(state[l].pos.x / h);
+    cl[1] = (int) floor(state[l].pos.y / h);
+    cl[2] = (int) floor(state[l].pos.z / h);
+    cl[3] = energy_key(E, cl);
+    th->grid_next[l] = th->grid_head[cl[3]];
+    th->grid_head[cl[3]] = l;
+  }
 
-    /* skip if the last-embedded atom is not in the torsion. */
-    if (id != ids[0] && id != ids[1] && id != ids[2] && id != ids[3])
-      continue;
+  th->grid_n = lev;
+  th->grid_lim = empty;
+
+  /* get the cell of the current atom. */
+  const vector_t x = state[lev].pos;
+  c[0] = (int) floor(x.x / h);
+  c[1] = (int) floor(x.y / h);
+  c[2] = (int) floor(x.z / h);
+
+  /* loop over the neighboring cells. */
+  U = 0.0;
+  for (q[0] = c[0] - 1; q[0] <= c[0] + 1; q[0]++) {
+    for (q[1] = c[1] - 1; q[1] <= c[1] + 1; q[1]++) {
+      for (q[2] = c[2] - 1; q[2] <= c[2] + 1; q[2]++) {
+        /* loop over the atoms filed in the hashed cell, skipping atoms
+         * of other cells that share it.
+         */
+        q[3] = energy_key(E, q);
+        for (l = th->grid_head[q[3]]; l != empty; l = th->grid_next[l]) {
+          cl = th->grid_cell + 4 * l;
+          if (cl[0] != q[0] || cl[1] != q[1] || cl[2] != q[2])
+            continue;
+
+          /* sum the contact if it lies within the cutoff. */
+          const vector_t *y = &state[l].pos;
+          d2 = (x.x - y->x) * (x.x - y->x) +
+               (x.y - y->y) * (x.y - y->y) +
+               (x.z - y->z) * (x.z - y->z);
+          if (d2 < rc2)
+            U += c6[l] / (d2 * d2 * d2);
+        }
+      }
+    }
+  }
 
-    /* get the graph level of each atom. */
-    levs[0] = levs[1] = levs[2] = levs[3] = lev;
-    for (k = 0; k < n; k++)
-      levs[k] = enum_prune_get_level(E->G->order, lev, ids[k]);
+  /* return the contact energy. */
+  return U;
+}
 
-    /* skip if all other atoms in the order have not been embedded. */
-    if (levs[0] > lev ||
-        levs[1] > lev ||
-        levs[2] > lev ||
-        levs[3] > lev)
-      continue;
+/* energy_alloc(): allocate an energetic closure and its term arrays in
+ * a single memory block, so that the closure is released by a single
+ * call to free(), like every other closure payload.
+ *
+ * arguments:
+ *  @n: number of terms of each type.
+ *
+ * returns:
+ *  pointer to the closure with empty term arrays, or null on allocation
+ *  failure.
+ */
+static enum_prune_energy_t *energy_alloc (const unsigned int *n) {
+  /* declare required variables:
+   *  @data: closure data pointer.
+   *  @sz: closure memory footprint.
+   *  @ptr: current position within the term arrays.
+   */
+  enum_prune_energy_t *data;
+  unsigned int k;
+  size_t sz;
+  char *ptr;
+
+  /* compute the closure size. constants precede the levels, to keep
+   * every array aligned.
+   */
+  for (k = 0, sz = sizeof(enum_prune_energy_t); k < ENERGY_TYPES; k++)
+    sz += n[k] * (2 * sizeof(double) + 4 * sizeof(unsigned int));
+
+  /* allocate the closure. */
+  data = (enum_prune_energy_t*) malloc(sz);
+  if (!data)
+    return NULL;
+
+  /* initialize the closure contents. */
+  memset(data, 0, sizeof(enum_prune_energy_t));
+  ptr = ((char*) data) + sizeof(enum_prune_energy_t);
+
+  /* lay out the term constants. */
+  for (k = 0; k < ENERGY_TYPES; k++) {
+    data->terms[k].mu = (double*) ptr;
+    data->terms[k].kappa = data->terms[k].mu + n[k];
+    ptr += 2 * n[k] * sizeof(double);
+  }
 
-    /* reallocate the closure payload. */
-    n_data++;
-    data = (enum_prune_energy_t*)
-      realloc(data, n_data * sizeof(enum_prune_energy_t));
-
-    /* check for allocation failures. */
-    if (!data)
-      return 0;
-
-    /* store the term type and initialize the counters. */
-    data[n_data - 1].type = ENERGY_DIHEDRAL;
-    data[n_data - 1].ntest = data[n_data - 1].nprune = 0;
-
-    /* store the offsets. */
-    data[n_data - 1].n[0] = 0;
-    data[n_data - 1].n[1] = 0;
-    data[n_data - 1].n[2] = 0;
-    data[n_data - 1].n[3] = 0;
-    for (k = 0; k < n; k++)
-      data[n_data - 1].n[k] = lev - levs[k];
-
-    /* store the term parameters. */
-    data[n_data - 1].mu = E->P->torsions[i].mu;
-    data[n_data - 1].kappa = E->P->torsions[i].kappa;
-
-    /* initialize the next-payload pointer. */
-    data[n_data - 1].next = NULL;
+  /* lay out the term levels. */
+  for (k = 0; k < ENERGY_TYPES; k++) {
+    data->terms[k].lv = (unsigned int*) ptr;
+    ptr += 4 * n[k] * sizeof(unsigned int);
   }
 
-  /* loop over the impropers. */
-  for (i = 0, n = 4; i < E->P->n_impropers; i++) {
-    /* get the atom indices. */
-    ids = E->P->impropers[i].atom_id;
+  /* return the closure. */
+  return data;
+}
 
-    /* skip if the last-embedded atom is not in the improper. */
-    if (id != ids[0] && id != ids[1] && id != ids[2] && id != ids[3])
-      continue;
+/* enum_prune_energy_init(): initialize the energy enumerator.
+ *
+ * only the bonded terms completed at the level are visited, from the
+ * term indices of the enumerator, and the term arrays are allocated
+ * once at their final sizes.
+ */
+int enum_prune_energy_init (enum_t *E, unsigned int lev) {
+  /* declare required variables:
+   *  @i: peptide bond/angle/torsion/improper array index.
+   *  @j: term index position.
+   *  @id: atom index that has just been embedded.
+   *  @levs: reorder indices of each atom.
+   *  @n: number of terms of each type.
+   *  @data: closure data pointer.
+   *  @r: contact radius and constant of each term.
+   */
+  unsigned int i, j, id, levs[4], n[ENERGY_TYPES], n_terms;
+  enum_prune_energy_t *data;
+  peptide_t *P = E->P;
+  double r;
 
-    /* get the graph level of each atom. */
-    levs[0] = levs[1] = levs[2] = levs[3] = lev;
-    for (k = 0; k < n; k++)
-      levs[k] = enum_prune_get_level(E->G->order, lev, ids[k]);
+  /* get the term indices of the level. */
+  const enum_terms_t *B = &E->bonds, *A = &E->angles;
+  const enum_terms_t *T = &E->torsions, *I = &E->impropers;
+  const unsigned int *dup = E->G->orig;
 
-    /* skip if all other atoms in the order have not been embedded. */
-    if (levs[0] > lev ||
-        levs[1] > lev ||
-        levs[2] > lev ||
-        levs[3] > lev)
-      continue;
+  /* define a contact force constant scale factor. */
+  const double Z = 3.84147997;
 
-    /* reallocate the closure payload. */
-    n_data++;
-    data = (enum_prune_energy_t*)
-      realloc(data, n_data * sizeof(enum_prune_energy_t));
-
-    /* check for allocation failures. */
-    if (!data)
-      return 0;
-
-    /* store the term type and initialize the counters. */
-    data[n_data - 1].type = ENERGY_DIHEDRAL;
-    data[n_data - 1].ntest = data[n_data - 1].nprune = 0;
-
-    /* store the offsets. */
-    data[n_data - 1].n[0] = 0;
-    data[n_data - 1].n[1] = 0;
-    data[n_data - 1].n[2] = 0;
-    data[n_data - 1].n[3] = 0;
-    for (k = 0; k < n; k++)
-      data[n_data - 1].n[k] = lev - levs[k];
-
-    /* store the term parameters. */
-    data[n_data - 1].mu = E->P->impropers[i].mu;
-    data[n_data - 1].kappa = E->P->impropers[i].kappa;
-
-    /* initialize the next-payload pointer. */
-    data[n_data - 1].next = NULL;
-  }
+  /* get the current atom index. */
+  id = E->G->order[lev];
 
-  /* loop over van der waals contacts. */
-  for (i = 0, n = 4; i < lev; i++) {
-    /* skip duplicate atoms. */
-    if (E->G->orig[i]) continue;
+  /* count the terms of each type. with a cutoff, contacts are looked up
+   * by level from the contact grid, so every preceeding level holds a
+   * contact, and duplicates hold empty ones.
+   */
+  memset(n, 0, ENERGY_TYPES * sizeof(unsigned int));
+  for (j = B->start[lev]; j < B->start[lev + 1]; j++)
+    n[P->bonds[B->id[j]].is_virtual ? ENERGY_DISTANCE : ENERGY_BOND]++;
 
-    /* get the other atom index. */
-    unsigned int jd = E->G->order[i];
+  n[ENERGY_ANGLE] = A->start[lev + 1] - A->start[lev];
+  n[ENERGY_DIHEDRAL] = T->start[lev + 1] - T->start[lev]
+                     + I->start[lev + 1] - I->start[lev];
 
-    /* reallocate the closure payload. */
-    n_data++;
-    data = (enum_prune_energy_t*)
-      realloc(data, n_data * sizeof(enum_prune_energy_t));
+  for (i = 0; i < lev; i++)
+    n[ENERGY_CONTACT] += (!dup[i] || E->cutoff > 0.0);
 
-    /* check for allocation failures. */
-    if (!data)
-      return 0;
+  /* return if no terms will be created. */
+  for (i = 0, n_terms = 0; i < ENERGY_TYPES; i++)
+    n_terms += n[i];
 
-    /* store the term type. */
-    data[n_data - 1].type = ENERGY_CONTACT;
+  if (!n_terms)
+    return 1;
+
+  /* allocate the closure data. */
+  data = energy_alloc(n);
+  if (!data)
+    return 0;
 
-    /* initialize the counters. */
-    data[n_data - 1].ntest = data[n_data - 1].nprune = 0;
+  /* add the bonds. bonds store half their force constant, and virtual
+   * bonds store the logarithm of their mean.
+   */
+  for (j = B->start[lev]; j < B->start[lev + 1]; j++) {
+    const peptide_bond_t *b = P->bonds + B->id[j];
+    energy_levels(E, lev, b->atom_id, 2, levs);
+    if (b->is_virtual)
+      energy_add(data->terms + ENERGY_DISTANCE, levs,
+                 log(b->mu), 0.5 * b->kappa);
+    else
+      energy_add(data->terms + ENERGY_BOND, levs, b->mu, 0.5 * b->kappa);
+  }
 
-    /* store the offsets. */
-    data[n_data - 1].n[0] = 0;
-    data[n_data - 1].n[1] = lev - i;
-    data[n_data - 1].n[2] = 0;
-    data[n_data - 1].n[3] = 0;
+  /* add the angles, which store half their force constant. */
+  for (j = A->start[lev]; j < A->start[lev + 1]; j++) {
+    const peptide_angle_t *a = P->angles + A->id[j];
+    energy_levels(E, lev, a->atom_id, 3, levs);
+    energy_add(data->terms + ENERGY_ANGLE, levs, a->mu, 0.5 * a->kappa);
+  }
 
-    /* store the term parameters. */
-    data[n_data - 1].kappa = Z * pow(E->ddf_tol, -2.0);
-    data[n_data - 1].mu =
-      E->P->atoms[id].radius + E->P->atoms[jd].radius;
+  /* add the torsions, which store half their force constant. */
+  for (j = T->start[lev]; j < T->start[lev + 1]; j++) {
+    const peptide_dihed_t *d = P->torsions + T->id[j];
+    energy_levels(E, lev, d->atom_id, 4, levs);
+    energy_add(data->terms + ENERGY_DIHEDRAL, levs, d->mu, 0.5 * d->kappa);
+  }
 
-    /* initialize the next-payload pointer. */
-    data[n_data - 1].next = NULL;
+  /* add the impropers, which store half their force constant. */
+  for (j = I->start[lev]; j < I->start[lev + 1]; j++) {
+    const peptide_dihed_t *d = P->impropers + I->id[j];
+    energy_levels(E, lev, d->atom_id, 4, levs);
+    energy_add(data->terms + ENERGY_DIHEDRAL, levs, d->mu, 0.5 * d->kappa);
   }
 
-  /* return if no closures were created. */
-  if (!n_data)
-    return 1;
+  /* add the van der waals contacts, which store the numerator of their
+   * inverse sixth power of the squared distance.
+   */
+  for (i = 0; i < lev; i++) {
+    /* skip duplicate atoms. */
+    if (dup[i] && !(E->cutoff > 0.0)) continue;
+
+    /* compute the contact constant. */
+    r = P->atoms[id].radius + P->atoms[E->G->order[i]].radius;
+    r = r * r * r;
+    r = (dup[i] ? 0.0 : 0.5 * Z / (E->ddf_tol * E->ddf_tol) * r * r);
+
+    /* store the contact level and constant. */
+    levs[0] = levs[2] = levs[3] = lev;
+    levs[1] = i;
+    energy_add(data->terms + ENERGY_CONTACT, levs, 0.0, r);
+  }
 
-  /* link up the chain of energy structures. */
-  for (i = 0; i < n_data - 1; i++)
-    data[i].next = data + (i + 1);
+  /* bound the energy of the closure. */
+  data->lb = energy_bound(E, data);
+  data->rest = 0.0;
 
   /* register the closure with the enumerator. */
   if (!enum_prune_add_closure(E, lev, enum_prune_energy, data))
@@ -314,90 +520,156 @@ int enum_prune_energy_init (enum_t *E, unsigned int lev) {
   return 1;
 }
 
+/* enum_prune_energy_done(): finish the initialization of the energetic
+ * closures of an enumerator, once every level holds its closure.
+ */
+void enum_prune_energy_done (enum_t *E) {
+  /* declare required variables:
+   *  @t: contact term arrays of each closure.
+   *  @data: closure data pointer.
+   *  @c6max: largest contact constant of each closure.
+   */
+  const enum_prune_energy_terms_t *t;
+  enum_prune_energy_t *data;
+  unsigned int lev, i, k;
+  double c6max;
+
+  /* every contact neglected by the cutoff lies beyond it. */
+  for (lev = 0; E->cutoff > 0.0 && lev < E->G->n_order; lev++) {
+    for (i = 0; i < E->prune_sz[lev]; i++) {
+      /* skip closures of other pruning methods. */
+      if (E->prune[lev][i] != enum_prune_energy) continue;
+
+      /* sum the largest contact energy beyond the cutoff. */
+      data = (enum_prune_energy_t*) E->prune_data[lev][i];
+      t = data->terms + ENERGY_CONTACT;
+      for (k = 0, c6max = 0.0; k < t->n; k++)
+        c6max = (t->kappa[k] > c6max ? t->kappa[k] : c6max);
+
+      E->cutoff_err += (double) t->n * c6max / pow(E->cutoff, 6.0);
+    }
+  }
+
+  /* bound the energy that remains below every level. */
+  energy_rest(E);
+}
+
 /* enum_prune_energy(): determine whether an enumerator tree may
  * be pruned at a given node based on energetic feasibility.
+ *
+ * the terms of each type are summed in a single loop, and the bound is
+ * checked once after all bonded terms and once after the contacts. as
+ * every term is non-negative, this prunes exactly the nodes that a check
+ * after every term would prune. the bound is lowered by the energy that
+ * every later level is certain to add, which prunes subtrees whose leaves
+ * would all exceed it.
  */
 int enum_prune_energy (enum_t *E, enum_thread_t *th, void *data) {
   /* declare required variables:
-   *  @energy_data: payload for energetic pruning terms.
-   *  @Eterm: energy contribution of the current term.
+   *  @Etype: energy contribution of each type of term.
    *  @Enew: total energy contribution of the embedded atom.
-   *  @mu: mean parameter of the current term.
-   *  @kappa: precision parameter of the current term.
    *  @obs: observed value of the current term.
-   *  @x: array of atoms involved in the current term.
+   *  @d2: squared distance of the current term.
    */
-  enum_prune_energy_t *energy_data;
-  double Eterm, Enew, mu, kappa, obs;
-  unsigned int k;
-  vector_t x[4];
-
-  /* get the payload and initialize the energy contribution. */
-  energy_data = (enum_prune_energy_t*) data;
-  Enew = 0.0;
-
-  /* loop over each term in the new energy contribution. */
-  while (energy_data) {
-    /* extract the term parameters. */
-    Eterm = 0.0;
-    mu = energy_data->mu;
-    kappa = energy_data->kappa;
-
-    /* extract all atom positions. */
-    for (k = 0; k < 4; k++)
-      x[k] = th->state[th->level - energy_data->n[k]].pos;
-
-    /* compute the current term. */
-    switch (energy_data->type) {
-      /* bonded distance. */
-      case ENERGY_BOND:
-        obs = vector_dist(&x[0], &x[1]);
-        Eterm = 0.5 * kappa * pow(obs - mu, 2.0);
-        break;
-
-      /* two-bond angle. */
-      case ENERGY_ANGLE:
-        obs = vector_angle(&x[0], &x[1], &x[2]);
-        Eterm = 0.5 * kappa * pow(obs - mu, 2.0);
-        break;
-
-      /* dihedral angle. */
-      case ENERGY_DIHEDRAL:
-        obs = vector_dihedral(&x[0], &x[1], &x[2], &x[3]);
-        Eterm = 0.5 * kappa * pow(obs - mu, 2.0);
-        break;
-
-      /* non-bonded distance. */
-      case ENERGY_DISTANCE:
-        obs = vector_dist(&x[0], &x[1]);
-        Eterm = 0.5 * kappa * pow(log(obs / mu), 2.0);
-        break;
-
-      /* close contacts (vdw repulsion). */
-      case ENERGY_CONTACT:
-        obs = vector_dist(&x[0], &x[1]);
-        Eterm = 0.5 * kappa * pow(mu / obs, 6.0);
-        break;
-
-      /* otherwise, do nothing. */
-      default: break;
-    }
+  double Etype[ENERGY_TYPES], Enew, obs, d2;
+  unsigned int i, k;
 
-    /* sum the energy term into the new contribution. */
-    Enew += Eterm;
+  /* get the payload and the thread state. */
+  enum_prune_energy_t *energy_data = (enum_prune_energy_t*) data;
+  const enum_prune_energy_terms_t *t = energy_data->terms;
+  enum_thread_node_t *state = th->state;
 
-    /* update the energy at the current node. */
-    th->state[th->level].energy = th->state[th->level - 1].energy + Enew;
+  /* get the previous non-duplicate level. duplicate levels do not hold
+   * energies, and their originals lack the energy of the levels between.
+   */
+  unsigned int prev = th->level - 1;
+  while (prev && E->G->orig[prev])
+    prev--;
+
+  const double U = E->energy_tol - state[prev].energy - energy_data->rest;
+
+  /* bonded distances: (kappa/2) (d - mu)^2. */
+  const unsigned int *lv = t[ENERGY_BOND].lv;
+  for (i = 0, Etype[ENERGY_BOND] = 0.0; i < t[ENERGY_BOND].n; i++) {
+    obs = vector_dist(&state[lv[4 * i]].pos, &state[lv[4 * i + 1]].pos)
+        - t[ENERGY_BOND].mu[i];
+    Etype[ENERGY_BOND] += t[ENERGY_BOND].kappa[i] * obs * obs;
+  }
+
+  /* two-bond angles: (kappa/2) (theta - mu)^2. */
+  lv = t[ENERGY_ANGLE].lv;
+  for (i = 0, Etype[ENERGY_ANGLE] = 0.0; i < t[ENERGY_ANGLE].n; i++) {
+    obs = vector_angle(&state[lv[4 * i]].pos,
+                       &state[lv[4 * i + 1]].pos,
+                       &state[lv[4 * i + 2]].pos)
+        - t[ENERGY_ANGLE].mu[i];
+    Etype[ENERGY_ANGLE] += t[ENERGY_ANGLE].kappa[i] * obs * obs;
+  }
 
-    /* check if the node should be pruned. */
-    energy_data->ntest++;
-    if (th->state[th->level].energy > E->energy_tol) {
-      energy_data->nprune++;
+  /* dihedral angles: (kappa/2) (omega - mu)^2. */
+  lv = t[ENERGY_DIHEDRAL].lv;
+  for (i = 0, Etype[ENERGY_DIHEDRAL] = 0.0; i < t[ENERGY_DIHEDRAL].n; i++) {
+    obs = vector_dihedral(&state[lv[4 * i]].pos,
+                          &state[lv[4 * i + 1]].pos,
+                          &state[lv[4 * i + 2]].pos,
+                          &state[lv[4 * i + 3]].pos)
+        - t[ENERGY_DIHEDRAL].mu[i];
+    Etype[ENERGY_DIHEDRAL] += t[ENERGY_DIHEDRAL].kappa[i] * obs * obs;
+  }
+
+  /* non-bonded distances: (kappa/2) log(d/mu)^2, where the term holds
+   * log(mu) and log(d) is taken from the squared distance.
+   */
+  lv = t[ENERGY_DISTANCE].lv;
+  for (i = 0, Etype[ENERGY_DISTANCE] = 0.0; i < t[ENERGY_DISTANCE].n; i++) {
+    d2 = vector_sqdist(&state[lv[4 * i]].pos, &state[lv[4 * i + 1]].pos);
+    obs = 0.5 * log(d2) - t[ENERGY_DISTANCE].mu[i];
+    Etype[ENERGY_DISTANCE] += t[ENERGY_DISTANCE].kappa[i] * obs * obs;
+  }
+
+  /* check the bonded terms before evaluating contacts. */
+  for (k = 0, Enew = 0.0; k < ENERGY_CONTACT; k++) {
+    if (!t[k].n) continue;
+
+    Enew += Etype[k];
+    energy_data->ntest[k]++;
+    if (Enew > U) {
+      energy_data->nprune[k]++;
       return 1;
     }
+  }
+
+  /* close contacts (vdw repulsion): (kappa/2) (mu/d)^6, where the term
+   * holds (kappa/2) mu^6 in place of its force constant. with a cutoff,
+   * only the contacts found in the contact grid are summed.
+   */
+  const vector_t x = state[th->level].pos;
+  const double *c6 = t[ENERGY_CONTACT].kappa;
+  lv = t[ENERGY_CONTACT].lv;
+  if (E->cutoff > 0.0) {
+    Etype[ENERGY_CONTACT] = energy_grid(E, th, c6);
+  }
+  else {
+    for (i = 0, Etype[ENERGY_CONTACT] = 0.0; i < t[ENERGY_CONTACT].n; i++) {
+      const vector_t *y = &state[lv[4 * i + 1]].pos;
+      d2 = (x.x - y->x) * (x.x - y->x) +
+           (x.y - y->y) * (x.y - y->y) +
+           (x.z - y->z) * (x.z - y->z);
+      Etype[ENERGY_CONTACT] += c6[i] / (d2 * d2 * d2);
+    }
+  }
 
-    /* move to the next energy term. */
-    energy_data = energy_data->next;
+  /* update the energy at the current node. */
+  Enew += Etype[ENERGY_CONTACT];
+  state[th->level].energy = state[prev].energy + Enew;
+
+  /* check if the node should be pruned. */
+  if (t[ENERGY_CONTACT].n) {
+    energy_data->ntest[ENERGY_CONTACT]++;
+    if (Enew > U) {
+      energy_data->nprune[ENERGY_CONTACT]++;
+      return 1;
+    }
   }
 
   /* do not prune. */
@@ -407,7 +679,39 @@ int enum_prune_energy (enum_t *E, enum_thread_t *th, void *data) {
 /* enum_prune_energy_report(): output a report for the energetic feasibility
  * pruning closure.
  */
-void enum_prune_energy_report (enum_t *E, unsigned int lev, void *data) {
-  /* FIXME: implement enum_prune_energy_report() */
+void enum_prune_energy_report (enum_t *E, FILE *fh,
+                               unsigned int lev, void *data) {
+  /* get the closure payload. */
+  enum_prune_energy_t *energy_data = (enum_prune_energy_t*) data;
+
+  /* declare the names of each type of energy term. */
+  static const char *names[ENERGY_TYPES] = {
+    "bond", "angle", "dihedral", "distance", "contact"
+  };
+
+  /* get the atom/residue indices. */
+  unsigned int ai = E->G->order[lev];
+  unsigned int ri = E->P->atoms[ai].res_id;
+
+  /* get the atom/residue names. */
+  const char *atomi = E->P->atoms[ai].name;
+  const char *resi = peptide_get_resname(E->P, ri);
+
+  /* loop over the types of energy terms. */
+  for (unsigned int k = 0; k < ENERGY_TYPES; k++) {
+    /* skip non-pruning term types. */
+    if (!energy_data->nprune[k]) continue;
+
+    /* compute the percentage of the nodes whose energy was checked after
+     * the terms of the type, which were pruned at that check.
+     */
+    double f = ((double) energy_data->nprune[k]) /
+               ((double) energy_data->ntest[k]) * 100.0;
+
+    /* output the statistics. */
+    fprintf(fh, "  %3s%-4u %-4s %-8s : %16u/%-16u  %6.2lf%%\n",
+            resi, ri + 1, atomi, names[k],
+            energy_data->nprune[k], energy_data->ntest[k], f);
+  }
 }
 
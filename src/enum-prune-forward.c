@@ -0,0 +1,249 @@
+
+/* include the enumerator header. */
+#include "enum.h"
+#include "enum-thread.h"
+#include "enum-prune.h"
+
+/* enum_prune_forward_t: structure for holding information required for
+ * one-step forward checking pruning closures.
+ */
+typedef struct {
+  /* @m: level of the next atom, which is checked by the closure.
+   * @f1, @f2: levels that hold the two nearest predecessors of the next
+   *           atom, which fix the axis of its circle.
+   * @t: distance from the atom at @f1 to the center of the circle.
+   * @r: radius of the circle.
+   */
+  unsigned int m, f1, f2;
+  double t, r;
+
+  /* @lv: preceeding levels that have distance bounds to the next atom,
+   *      from the nearest to the farthest.
+   * @l2, @u2: squared lower and upper bounds of each level in @lv, with
+   *           the error tolerance folded in.
+   * @n: number of levels in @lv.
+   */
+  unsigned int *lv, n;
+  double *l2, *u2;
+
+  /* @ntest: number of calls made for each preceeding level.
+   * @nprune: number of prunes performed for each preceeding level.
+   */
+  unsigned int *ntest, *nprune;
+}
+enum_prune_forward_t;
+
+/* enum_prune_forward_init(): initialize the forward checking pruner.
+ */
+int enum_prune_forward_init (enum_t *E, unsigned int lev) {
+  /* declare required variables:
+   *  @data: closure data pointer.
+   *  @sz: closure memory footprint.
+   *  @bound: distance bound between a preceeding level and the next atom.
+   *  @l, @u: lower and upper bounds, including tolerance.
+   *  @d12, @d13, @d23: exact distances that fix the circle.
+   *  @n: number of bounded preceeding levels.
+   */
+  enum_prune_forward_t *data;
+  unsigned int sz, ib, n, m, f0, f1, f2;
+  double l, u, d12, d13, d23, t;
+  graph_t *G = E->G;
+  const unsigned int *order = G->order;
+  const unsigned int *dup = G->orig;
+  value_t bound;
+
+  /* only check next atoms that are embedded from their predecessors. */
+  m = lev + 1;
+  if (lev < 2 || m >= G->n_order || dup[m])
+    return 1;
+
+  /* resolve the predecessors of the next atom to their original levels,
+   * and get the exact distances that place it on a circle.
+   */
+  f0 = m - 3 - dup[m - 3];
+  f1 = m - 2 - dup[m - 2];
+  f2 = m - 1 - dup[m - 1];
+  d12 = graph_get_edge_exact(G, order[m - 2], order[m - 1]);
+  d13 = graph_get_edge_exact(G, order[m - 2], order[m]);
+  d23 = graph_get_edge_exact(G, order[m - 1], order[m]);
+
+  /* compute the center and radius of the circle, and skip degenerate
+   * circles.
+   */
+  t = (d12 * d12 + d13 * d13 - d23 * d23) / (2.0 * d12);
+  if (!(d12 > 0.0) || !(d13 * d13 - t * t >= 0.0))
+    return 1;
+
+  /* count the preceeding levels whose bounds are able to prune. the
+   * predecessors of the next atom are always satisfied by its children.
+   */
+  for (ib = m - 1, n = 0; ib < m; ib--) {
+    if (dup[ib] || ib == f0 || ib == f1 || ib == f2) continue;
+    bound = graph_get_edge(G, order[ib], order[m]);
+    if (!value_is_undefined(bound) &&
+        (bound.l - E->ddf_tol > 0.0 || isfinite(bound.u)))
+      n++;
+  }
+
+  /* without bounded levels, the closure would never prune. */
+  if (!n)
+    return 1;
+
+  /* allocate the closure payload. */
+  sz = sizeof(enum_prune_forward_t)
+     + n * (sizeof(unsigned int) + 2 * sizeof(double))
+     + 2 * m * sizeof(unsigned int);
+  data = (enum_prune_forward_t*) malloc(sz);
+  if (!data)
+    return 0;
+
+  /* initialize the payload array pointers. */
+  data->l2 = (double*) (((char*) data) + sizeof(enum_prune_forward_t));
+  data->u2 = data->l2 + n;
+  data->lv = (unsigned int*) (data->u2 + n);
+  data->ntest = data->lv + n;
+  data->nprune = data->ntest + m;
+  data->n = n;
+
+  /* initialize the circle of the next atom. */
+  data->m = m;
+  data->f1 = f1;
+  data->f2 = f2;
+  data->t = t;
+  data->r = sqrt(d13 * d13 - t * t);
+
+  /* initialize the statistics. */
+  memset(data->ntest, 0, m * sizeof(unsigned int));
+  memset(data->nprune, 0, m * sizeof(unsigned int));
+
+  /* store the squared bounds of the preceeding levels, nearest first. */
+  for (ib = m - 1, n = 0; ib < m; ib--) {
+    if (dup[ib] || ib == f0 || ib == f1 || ib == f2) continue;
+    bound = graph_get_edge(G, order[ib], order[m]);
+    if (value_is_undefined(bound) ||
+        !(bound.l - E->ddf_tol > 0.0 || isfinite(bound.u)))
+      continue;
+
+    l = bound.l - E->ddf_tol;
+    u = bound.u + E->ddf_tol;
+    data->lv[n] = ib;
+    data->l2[n] = (l > 0.0 ? l * l : 0.0);
+    data->u2[n] = u * u;
+    n++;
+  }
+
+  /* register a closure. */
+  if (!enum_prune_add_closure(E, lev, enum_prune_forward, data))
+    return 0;
+
+  /* return success. */
+  return 1;
+}
+
+/* enum_prune_forward(): determine whether an enumerator tree may be
+ * pruned at a given node because no child at the next level is able
+ * to satisfy its distance bounds to the atoms embedded so far.
+ *
+ * every child of the node lies on a circle around the axis through its
+ * second and third predecessors. the distances from a point to the
+ * circle span a closed range, and the node is pruned when that range
+ * does not meet the bounds between the point and the next atom.
+ */
+int enum_prune_forward (enum_t *E, enum_thread_t *th, void *data) {
+  /* declare required variables:
+   *  @lo, @hi: squared distance range from each point to the circle.
+   *  @e, @c: unit axis and center of the circle.
+   */
+  double lo, hi;
+  vector_t e, c;
+
+  /* get the payload. */
+  enum_prune_forward_t *fwd_data = (enum_prune_forward_t*) data;
+  const enum_thread_node_t *state = th->state;
+
+  /* locally store the bounded levels and their squared bounds. */
+  const unsigned int *lv = fwd_data->lv;
+  const double *l2 = fwd_data->l2;
+  const double *u2 = fwd_data->u2;
+  const unsigned int n = fwd_data->n;
+  const double r = fwd_data->r;
+
+  /* compute the unit axis and the center of the circle. */
+  const vector_t x1 = state[fwd_data->f1].pos;
+  const vector_t x2 = state[fwd_data->f2].pos;
+  vector_set(&e, x2.x - x1.x, x2.y - x1.y, x2.z - x1.z);
+  vector_normalize(&e);
+  c.x = x1.x + fwd_data->t * e.x;
+  c.y = x1.y + fwd_data->t * e.y;
+  c.z = x1.z + fwd_data->t * e.z;
+
+  /* loop over the bounded upstream embedded atoms. */
+  for (unsigned int k = 0; k < n; k++) {
+    /* compute the squared distance range from the atom to the circle. */
+    vector_circle_range(&c, &e, r, &state[lv[k]].pos, &lo, &hi);
+
+    /* prune if no point of the circle is within the bound. */
+    fwd_data->ntest[lv[k]]++;
+    if (lo > u2[k] || hi < l2[k]) {
+      fwd_data->nprune[lv[k]]++;
+      return 1;
+    }
+  }
+
+  /* do not prune. */
+  return 0;
+}
+
+/* enum_prune_forward_report(): output a report for the forward checking
+ * pruning closure.
+ */
+void enum_prune_forward_report (enum_t *E, FILE *fh,
+                                unsigned int lev, void *data) {
+  /* get the closure payload. */
+  enum_prune_forward_t *fwd_data = (enum_prune_forward_t*) data;
+
+  /* get the current atom/residue indices. */
+  unsigned int aj = E->G->order[lev];
+  unsigned int rj = E->P->atoms[aj].res_id;
+
+  /* get the current atom/residue names. */
+  const char *atomj = E->P->atoms[aj].name;
+  const char *resj = peptide_get_resname(E->P, rj);
+
+  /* get the next atom/residue indices. */
+  unsigned int ak = E->G->order[fwd_data->m];
+  unsigned int rk = E->P->atoms[ak].res_id;
+
+  /* get the next atom/residue names. */
+  const char *atomk = E->P->atoms[ak].name;
+  const char *resk = peptide_get_resname(E->P, rk);
+
+  /* loop over the bounded preceeding levels. */
+  for (unsigned int n = 0; n < fwd_data->n; n++) {
+    /* skip non-pruned preceeding atoms. */
+    const unsigned int i = fwd_data->lv[n];
+    if (!fwd_data->nprune[i]) continue;
+
+    /* get the preceeding atom/residue indices. */
+    unsigned int ai = E->G->order[i];
+    unsigned int ri = E->P->atoms[ai].res_id;
+
+    /* get the preceeding atom/residue names. */
+    const char *atomi = E->P->atoms[ai].name;
+    const char *resi = peptide_get_resname(E->P, ri);
+
+    /* compute the percentage. */
+    unsigned int np = fwd_data->nprune[i];
+    unsigned int nt = fwd_data->ntest[i];
+    double f = ((double) np) / ((double) nt) * 100.0;
+
+    /* output the statistics. */
+    fprintf(fh, "  %3s%-4u %-4s | %3s%-4u %-4s | %3s%-4u %-4s : "
+                "%16u/%-16u  %6.2lf%%\n",
+                resj, rj + 1, atomj,
+                resk, rk + 1, atomk,
+                resi, ri + 1, atomi,
+                np, nt, f);
+  }
+}
+
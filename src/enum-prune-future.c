@@ -92,9 +92,9 @@ int enum_prune_future_init (enum_t *E, unsigned int lev) {
 
     /* initialize the payload contents. */
     data->ntest = data->nprune = 0;
-    data->i = order[i];
-    data->j = order[j];
-    data->k = order[klim];
+    data->i = i;
+    data->j = j;
+    data->k = klim;
     data->limit = lim;
 
     /* register the closure with the enumerator. */
@@ -135,7 +135,8 @@ int enum_prune_future (enum_t *E, enum_thread_t *th, void *data) {
 /* enum_prune_future_report(): output a report for the future distance
  * feasibility pruning closure.
  */
-void enum_prune_future_report (enum_t *E, unsigned int lev, void *data) {
+void enum_prune_future_report (enum_t *E, FILE *fh,
+                               unsigned int lev, void *data) {
   /* get the closure payload. */
   enum_prune_future_t *future_data = (enum_prune_future_t*) data;
 
@@ -143,9 +144,9 @@ void enum_prune_future_report (enum_t *E, unsigned int lev, void *data) {
   if (!future_data->nprune) return;
 
   /* get the atom indices. */
-  unsigned int a0 = future_data->i;
-  unsigned int a1 = future_data->j;
-  unsigned int a2 = future_data->k;
+  unsigned int a0 = E->G->order[future_data->i];
+  unsigned int a1 = E->G->order[future_data->j];
+  unsigned int a2 = E->G->order[future_data->k];
 
   /* get the residue indices. */
   unsigned int r0 = E->P->atoms[a0].res_id;
@@ -167,11 +168,11 @@ void enum_prune_future_report (enum_t *E, unsigned int lev, void *data) {
              ((double) future_data->ntest) * 100.0;
 
   /* output the statistics. */
-  printf("  %3s%-4u %-4s | %3s%-4u %-4s | %3s%-4u %-4s : "
-         "%16u/%-16u  %6.2lf%%\n",
-         res0, r0 + 1, atom0,
-         res1, r1 + 1, atom1,
-         res2, r2 + 1, atom2,
-         future_data->nprune, future_data->ntest, f);
+  fprintf(fh, "  %3s%-4u %-4s | %3s%-4u %-4s | %3s%-4u %-4s : "
+              "%16u/%-16u  %6.2lf%%\n",
+              res0, r0 + 1, atom0,
+              res1, r1 + 1, atom1,
+              res2, r2 + 1, atom2,
+              future_data->nprune, future_data->ntest, f);
 }
 
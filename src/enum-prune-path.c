@@ -8,10 +8,20 @@
  * shortest path feasibility pruning closures.
  */
 typedef struct {
-  /* @ntest: number of calls made or each neighbor pair.
-   * @nprune: number of prunes performed for each neighbor pair.
+  /* @lv: preceeding levels that are able to prune, from the nearest to
+   *      the farthest.
+   * @lk: future level that limits the path bound of each level in @lv.
+   * @m2: squared shortest path bound of each level in @lv, which is the
+   *      smallest sum of upper bounds through any future level.
+   * @n: number of levels in @lv.
    */
-  unsigned int **ntest, **nprune;
+  unsigned int *lv, *lk, n;
+  double *m2;
+
+  /* @ntest: number of calls made for each preceeding level.
+   * @nprune: number of prunes performed for each preceeding level.
+   */
+  unsigned int *ntest, *nprune;
 }
 enum_prune_path_t;
 
@@ -21,48 +31,81 @@ int enum_prune_path_init (enum_t *E, unsigned int lev) {
   /* declare required variables:
    *  @data: closure data pointer.
    *  @sz: closure memory footprint.
-   *  @na, @nb: row and column counts.
+   *  @dik: distance bound from x(i) to x(k).
+   *  @djk: distance bound from x(j) to x(k).
+   *  @m, @mk: shortest path bound of each level, and its limiting level.
+   *  @n: number of preceeding levels that are able to prune.
    */
   enum_prune_path_t *data;
-  unsigned int sz, na, nb;
-  char *rtest, *rprune;
-
-  /* compute the number of table rows and columns. */
-  na = lev;
-  nb = E->G->n_order - lev - 1;
+  unsigned int sz, i, k, mk, n;
+  graph_t *G = E->G;
+  const unsigned int *dup = G->orig;
+  value_t dik, djk;
+  double m;
 
-  /* compute the closure memory block size. */
+  /* compute the closure memory block size. the level arrays are sized
+   * for every preceeding level, as the number that are able to prune is
+   * not known until their bounds are computed.
+   */
   sz = sizeof(enum_prune_path_t)
-     + 2 * na * sizeof(unsigned int*)
-     + 2 * na * nb * sizeof(unsigned int);
+     + lev * (sizeof(double) + 4 * sizeof(unsigned int));
 
   /* allocate the closure payload. */
   data = (enum_prune_path_t*) malloc(sz);
   if (!data)
     return 0;
 
-  /* initialize the first array pointer. */
-  sz = sizeof(enum_prune_path_t);
-  data->ntest = (unsigned int**) (((char*) data) + sz);
-
-  /* initialize the second array pointer. */
-  sz += na * (nb * sizeof(unsigned int) + sizeof(unsigned int*));
-  data->nprune = (unsigned int**) (((char*) data) + sz);
-
-  /* initialize the array row pointers. */
-  rtest  = ((char*) data->ntest)  + (na * sizeof(unsigned int*));
-  rprune = ((char*) data->nprune) + (na * sizeof(unsigned int*));
-  sz  = nb * sizeof(unsigned int);
-  for (unsigned int i = 0; i < na; i++) {
-    /* set the row pointers. */
-    data->ntest[i]  = (unsigned int*) (rtest  + (i * sz));
-    data->nprune[i] = (unsigned int*) (rprune + (i * sz));
-
-    /* initialize the row contents. */
-    for (unsigned int k = 0; k < nb; k++)
-      data->ntest[i][k] = data->nprune[i][k] = 0;
+  /* initialize the payload array pointers. */
+  data->m2 = (double*) (((char*) data) + sizeof(enum_prune_path_t));
+  data->lv = (unsigned int*) (data->m2 + lev);
+  data->lk = data->lv + lev;
+  data->ntest = data->lk + lev;
+  data->nprune = data->ntest + lev;
+
+  /* initialize the statistics. */
+  memset(data->ntest, 0, lev * sizeof(unsigned int));
+  memset(data->nprune, 0, lev * sizeof(unsigned int));
+
+  /* compute the shortest path bound of each preceeding level through
+   * all future levels, nearest preceeding level first.
+   */
+  for (i = lev - 1, n = 0; i < lev; i--) {
+    /* skip duplicate atoms. */
+    if (dup[i]) continue;
+
+    /* find the future atom that gives the shortest path. */
+    for (k = lev + 1, m = INFINITY, mk = 0; k < G->n_order; k++) {
+      /* skip duplicate atoms. */
+      if (dup[k]) continue;
+
+      /* obtain the distance bounds to the future atom. */
+      dik = graph_get_edge(G, G->order[i], G->order[k]);
+      djk = graph_get_edge(G, G->order[lev], G->order[k]);
+
+      /* skip future atoms without defined bounds. */
+      if (dik.type == VALUE_TYPE_UNDEFINED ||
+          djk.type == VALUE_TYPE_UNDEFINED)
+        continue;
+
+      /* keep the shortest path. */
+      if (dik.u + djk.u < m) {
+        m = dik.u + djk.u;
+        mk = k;
+      }
+    }
+
+    /* store levels with a finite bound, which are able to prune. */
+    if (isfinite(m)) {
+      data->lv[n] = i;
+      data->lk[n] = mk;
+      data->m2[n] = m * m;
+      n++;
+    }
   }
 
+  /* store the number of levels that are able to prune. */
+  data->n = n;
+
   /* register a closure. */
   if (!enum_prune_add_closure(E, lev, enum_prune_path, data))
     return 0;
@@ -76,52 +119,34 @@ int enum_prune_path_init (enum_t *E, unsigned int lev) {
  */
 int enum_prune_path (enum_t *E, enum_thread_t *th, void *data) {
   /* declare required variables:
-   *  @dik: distance bound from x(i) to x(k).
-   *  @djk: distance bound from x(j) to x(k).
-   *  @dij: current distance between x(i) and x(j).
+   *  @d2: current squared distance between x(i) and x(j).
    */
-  value_t dik, djk;
-  double dij;
+  double d2;
 
   /* get the payload. */
   enum_prune_path_t *path_data = (enum_prune_path_t*) data;
 
-  /* locally store the level, thread length, and originality array. */
-  const unsigned int n = E->G->n_order;
-  const unsigned int *dup = E->G->orig;
-  const unsigned int j = th->level;
+  /* locally store the preceeding levels and their path bounds. */
+  const unsigned int *lv = path_data->lv;
+  const double *m2 = path_data->m2;
+  const unsigned int n = path_data->n;
 
   /* locally store the end position. */
-  vector_t *thpos = &th->state[j].pos;
-
-  /* loop over all upstream embedded atoms. */
-  for (unsigned int i = j - 1; i < n; i--) {
-    /* skip duplicate atoms. */
-    if (dup[i]) continue;
-
-    /* compute the distance between the two nodes. */
-    dij = vector_dist(&th->state[i].pos, thpos);
-
-    /* loop over all future (un-embedded) atoms. */
-    for (unsigned int k = j + 1; k < n; k++) {
-      /* skip duplicate atoms. */
-      if (dup[k]) continue;
-
-      /* obtain the distance bounds to the future atom. */
-      dik = graph_get_edge(E->G, E->G->order[i], E->G->order[k]);
-      djk = graph_get_edge(E->G, E->G->order[j], E->G->order[k]);
-
-      /* skip future atoms without defined bounds. */
-      if (dik.type == VALUE_TYPE_UNDEFINED ||
-          djk.type == VALUE_TYPE_UNDEFINED)
-        continue;
-
-      /* prune if the future atom is unreachable. */
-      path_data->ntest[i][k - j - 1]++;
-      if (dij - dik.u > djk.u) {
-        path_data->nprune[i][k - j - 1]++;
-        return 1;
-      }
+  const vector_t a = th->state[th->level].pos;
+
+  /* loop over the upstream embedded atoms that are able to prune. */
+  for (unsigned int k = 0; k < n; k++) {
+    /* compute the squared distance between the two nodes. */
+    const vector_t *b = &th->state[lv[k]].pos;
+    d2 = (a.x - b->x) * (a.x - b->x) +
+         (a.y - b->y) * (a.y - b->y) +
+         (a.z - b->z) * (a.z - b->z);
+
+    /* prune if some future atom is unreachable. */
+    path_data->ntest[lv[k]]++;
+    if (d2 > m2[k]) {
+      path_data->nprune[lv[k]]++;
+      return 1;
     }
   }
 
@@ -132,7 +157,8 @@ int enum_prune_path (enum_t *E, enum_thread_t *th, void *data) {
 /* enum_prune_path_report(): output a report for the shortest path
  * feasbility (i.e. DSP) pruning closure.
  */
-void enum_prune_path_report (enum_t *E, unsigned int lev, void *data) {
+void enum_prune_path_report (enum_t *E, FILE *fh,
+                             unsigned int lev, void *data) {
   /* get the closure payload. */
   enum_prune_path_t *path_data = (enum_prune_path_t*) data;
 
@@ -145,10 +171,11 @@ void enum_prune_path_report (enum_t *E, unsigned int lev, void *data) {
   const char *atomj = E->P->atoms[aj].name;
   const char *resj = peptide_get_resname(E->P, rj);
 
-  /* loop over all tested prior neighbors. */
-  for (unsigned int i = j - 1; i < E->G->n_order; i--) {
-    /* skip duplicate prior atoms. */
-    if (E->G->orig[i]) continue;
+  /* loop over the preceeding levels that are able to prune. */
+  for (unsigned int n = 0; n < path_data->n; n++) {
+    /* skip non-pruned prior atoms. */
+    const unsigned int i = path_data->lv[n];
+    if (!path_data->nprune[i]) continue;
 
     /* get the first atom/residue indices. */
     unsigned int ai = E->G->order[i];
@@ -158,32 +185,25 @@ void enum_prune_path_report (enum_t *E, unsigned int lev, void *data) {
     const char *atomi = E->P->atoms[ai].name;
     const char *resi = peptide_get_resname(E->P, ri);
 
-    /* loop over all tested posterior neighbors. */
-    for (unsigned int k = j + 1; k < E->G->n_order; k++) {
-      /* skip duplicates and non-pruned posteriors. */
-      if (E->G->orig[k] || !path_data->nprune[i][k - j - 1]) continue;
-
-      /* get the last atom/residue indices. */
-      unsigned int ak = E->G->order[k];
-      unsigned int rk = E->P->atoms[ak].res_id;
-
-      /* get the last atom/residue names. */
-      const char *atomk = E->P->atoms[ak].name;
-      const char *resk = peptide_get_resname(E->P, rk);
-
-      /* compute the percentage. */
-      unsigned int np = path_data->nprune[i][k - j - 1];
-      unsigned int nt = path_data->ntest[i][k - j - 1];
-      double f = ((double) np) / ((double) nt) * 100.0;
-
-      /* output the statistics. */
-      printf("  %3s%-4u %-4s | %3s%-4u %-4s | %3s%-4u %-4s : "
-             "%16u/%-16u  %6.2lf%%\n",
-             resi, ri + 1, atomi,
-             resj, rj + 1, atomj,
-             resk, rk + 1, atomk,
-             np, nt, f);
-    }
+    /* get the limiting posterior atom/residue indices. */
+    unsigned int ak = E->G->order[path_data->lk[n]];
+    unsigned int rk = E->P->atoms[ak].res_id;
+
+    /* get the limiting posterior atom/residue names. */
+    const char *atomk = E->P->atoms[ak].name;
+    const char *resk = peptide_get_resname(E->P, rk);
+
+    /* compute the percentage. */
+    unsigned int np = path_data->nprune[i];
+    unsigned int nt = path_data->ntest[i];
+    double f = ((double) np) / ((double) nt) * 100.0;
+
+    /* output the statistics. */
+    fprintf(fh, "  %3s%-4u %-4s | %3s%-4u %-4s | %3s%-4u %-4s : "
+                "%16u/%-16u  %6.2lf%%\n",
+                resi, ri + 1, atomi,
+                resj, rj + 1, atomj,
+                resk, rk + 1, atomk,
+                np, nt, f);
   }
 }
-
@@ -10,52 +10,52 @@
 typedef struct {
   /* @ntest, @nprune: test and prune counts of the current closure.
    * @n: array of backward step-counts for the prior atoms.
-   * @bound: angle bound to check.
+   * @cl, @sl: cosine and sine of the lower end of the angle bound.
+   * @cu, @su: cosine and sine of the upper end of the angle bound.
+   * @wide: whether the angle bound spans more than a half-turn.
+   * @d12: fixed length of the central bond, or zero if it may vary.
    */
   unsigned int ntest, nprune;
   peptide_dihed_t *arr;
   unsigned int n[4];
-  value_t bound;
+  double cl, sl, cu, su, d12;
+  int wide;
 }
 enum_prune_taf_t;
 
 /* taf_init(): function utilized by:
  *  - enum_prune_dihe_init()
  *  - enum_prune_impr_init()
+ *
+ * only the dihedrals completed at the level are visited, from the term
+ * index of the enumerator.
  */
-static int taf_init (enum_t *E, peptide_dihed_t *arr, unsigned int n_arr,
-                     unsigned int lev) {
+static int taf_init (enum_t *E, peptide_dihed_t *arr,
+                     const enum_terms_t *T, unsigned int lev) {
   /* declare required variables:
    *  @i: peptide torsion/improper array index.
+   *  @j: term index position.
    *  @k: atoms array index.
-   *  @id: atom index that has just been embedded.
    *  @ids: atom indices in each torsion/improper.
    *  @data: closure data pointer.
    */
-  unsigned int i, k, id, *ids, levs[4];
+  unsigned int i, j, k, *ids;
   enum_prune_taf_t *data;
+  value_t bond;
+  double L, U;
 
-  /* get the current atom index. */
-  id = E->G->order[lev];
-
-  /* loop over all torsions. */
-  for (i = 0; i < n_arr; i++) {
+  /* loop over the torsions completed at the current level. */
+  for (j = T->start[lev]; j < T->start[lev + 1]; j++) {
     /* get the atom indices. */
+    i = T->id[j];
     ids = arr[i].atom_id;
 
-    /* skip if the last-embedded atom is not in the torsion. */
-    if (id != ids[0] && id != ids[1] && id != ids[2] && id != ids[3])
-      continue;
-
-    /* get the graph level of each atom. */
-    for (k = 0; k < 4; k++)
-      levs[k] = enum_prune_get_level(E->G->order, lev, ids[k]);
-
-    /* skip if all other atoms in the order have not been embedded. */
-    if (levs[0] > lev ||
-        levs[1] > lev ||
-        levs[2] > lev ||
-        levs[3] > lev)
+    /* get the angle bound, including tolerance, and skip bounds that
+     * admit every angle.
+     */
+    L = arr[i].ang.l * M_PI / 180.0 - E->ddf_tol;
+    U = arr[i].ang.u * M_PI / 180.0 + E->ddf_tol;
+    if (U - L >= 2.0 * M_PI)
       continue;
 
     /* allocate the closure payload. */
@@ -69,10 +69,21 @@ static int taf_init (enum_t *E, peptide_dihed_t *arr, unsigned int n_arr,
 
     /* store the offsets. */
     for (k = 0; k < 4; k++)
-      data->n[k] = lev - levs[k];
-
-    /* store the angle bound. */
-    data->bound = value_scal(arr[i].ang, M_PI / 180.0);
+      data->n[k] = lev - E->G->ordrev[ids[k]];
+
+    /* store the directions of the ends of the angle bound. */
+    data->cl = cos(L);
+    data->sl = sin(L);
+    data->cu = cos(U);
+    data->su = sin(U);
+    data->wide = (U - L > M_PI);
+
+    /* store the length of the central bond if it is exact, so that the
+     * test needs no square root at levels of fixed geometry.
+     */
+    bond = graph_get_edge(E->G, ids[1], ids[2]);
+    data->d12 = (value_is_scalar(bond) && !value_is_dihedral(bond) ?
+                 bond.l : 0.0);
 
     /* set the payload value and register the closure. */
     if (!enum_prune_add_closure(E, lev, enum_prune_taf, data))
@@ -87,55 +98,76 @@ static int taf_init (enum_t *E, peptide_dihed_t *arr, unsigned int n_arr,
  */
 int enum_prune_dihe_init (enum_t *E, unsigned int lev) {
   /* initialize using the array of torsional dihedrals. */
-  return taf_init(E, E->P->torsions, E->P->n_torsions, lev);
+  return taf_init(E, E->P->torsions, &E->torsions, lev);
 }
 
 /* enum_prune_impr_init(): initialize the improper feasibility pruner.
  */
 int enum_prune_impr_init (enum_t *E, unsigned int lev) {
   /* initialize using the array of improper dihedrals. */
-  return taf_init(E, E->P->impropers, E->P->n_impropers, lev);
+  return taf_init(E, E->P->impropers, &E->impropers, lev);
 }
 
 /* enum_prune_taf(): determine whether an enumerator tree may be pruned
  * at a given node based on torsion angle feasibility.
+ *
+ * the dihedral angle is never computed. instead, its unnormalized cosine
+ * and sine are tested against the half-planes bounded by the ends of the
+ * angle bound: bounds up to a half-turn admit the intersection of the two
+ * half-planes, and wider bounds admit their union.
  */
 int enum_prune_taf (enum_t *E, enum_thread_t *th, void *data) {
   /* declare required variables:
-   *  @taf_data: payload for dihe/impr closures.
+   *  @b1, @b2, @b3: bond vectors of the dihedral.
+   *  @n1, @n2: normals of the two planes of the dihedral.
+   *  @x, @y: cosine and sine of the dihedral, scaled by a common factor.
+   *  @ccw, @cw: whether the dihedral lies counterclockwise from the lower
+   *             end, and clockwise from the upper end of the bound.
    */
-  enum_prune_taf_t *taf_data;
+  vector_t b1, b2, b3, n1, n2;
+  double x, y, b22;
+  int ccw, cw;
 
   /* get the payload. */
-  taf_data = (enum_prune_taf_t*) data;
+  enum_prune_taf_t *taf_data = (enum_prune_taf_t*) data;
+  const enum_thread_node_t *state = th->state;
 
   /* extract pretty handles to the atom positions. */
-  vector_t x1 = th->state[th->level - taf_data->n[0]].pos;
-  vector_t x2 = th->state[th->level - taf_data->n[1]].pos;
-  vector_t x3 = th->state[th->level - taf_data->n[2]].pos;
-  vector_t x4 = th->state[th->level - taf_data->n[3]].pos;
+  const vector_t *x1 = &state[th->level - taf_data->n[0]].pos;
+  const vector_t *x2 = &state[th->level - taf_data->n[1]].pos;
+  const vector_t *x3 = &state[th->level - taf_data->n[2]].pos;
+  const vector_t *x4 = &state[th->level - taf_data->n[3]].pos;
+
+  /* compute the bond vectors. */
+  vector_set(&b1, x1->x - x2->x, x1->y - x2->y, x1->z - x2->z);
+  vector_set(&b2, x2->x - x3->x, x2->y - x3->y, x2->z - x3->z);
+  vector_set(&b3, x3->x - x4->x, x3->y - x4->y, x3->z - x4->z);
+
+  /* compute the plane normals. */
+  vector_cross(&b1, &b2, &n1);
+  vector_cross(&b2, &b3, &n2);
+
+  /* compute the cosine and sine of the dihedral, both scaled by the
+   * product of the normal lengths. an exact central bond is taken at its
+   * bound, which the embedded positions meet within the ddf tolerance.
+   */
+  vector_dot(&n1, &n2, &x);
+  vector_dot(&b1, &n2, &y);
+  if (taf_data->d12 > 0.0) {
+    y *= -taf_data->d12;
+  }
+  else {
+    vector_dot(&b2, &b2, &b22);
+    y *= -sqrt(b22);
+  }
 
-  /* compute the dihedral angle. */
-  const double omega = vector_dihedral(&x1, &x2, &x3, &x4);
+  /* test the dihedral against the ends of the angle bound. */
+  ccw = (taf_data->cl * y - taf_data->sl * x >= 0.0);
+  cw = (taf_data->cu * y - taf_data->su * x <= 0.0);
 
-  /* check if the computed dihedral angle is in bounds. */
+  /* prune if the dihedral lies outside of the angle bound. */
   taf_data->ntest++;
-  int feasible = 0;
-  for (int n = -2; n <= 2; n += 2) {
-    /* compute the shifted feasibility boundary. */
-    const double shift = (double) n * M_PI;
-    const double L = taf_data->bound.l - E->ddf_tol + shift;
-    const double U = taf_data->bound.u + E->ddf_tol + shift;
-
-    /* check the dihedral angle against the shifted boundary. */
-    if (omega >= L && omega <= U) {
-      feasible = 1;
-      break;
-    }
-  }
-
-  /* if all three boundaries fail to contain the angle, prune. */
-  if (!feasible) {
+  if (taf_data->wide ? !(ccw || cw) : !(ccw && cw)) {
     taf_data->nprune++;
     return 1;
   }
@@ -148,7 +180,7 @@ int enum_prune_taf (enum_t *E, enum_thread_t *th, void *data) {
  *  - enum_prune_dihe_init()
  *  - enum_prune_impr_init()
  */
-void enum_prune_taf_report (enum_t *E, peptide_dihed_t *arr,
+void enum_prune_taf_report (enum_t *E, FILE *fh, peptide_dihed_t *arr,
                             unsigned int lev, void *data) {
   /* get the closure payload. */
   enum_prune_taf_t *taf_data = (enum_prune_taf_t*) data;
@@ -187,29 +219,31 @@ void enum_prune_taf_report (enum_t *E, peptide_dihed_t *arr,
              ((double) taf_data->ntest) * 100.0;
 
   /* output the statistics. */
-  printf("  %3s%-4u %-4s | %3s%-4u %-4s | "
-         "%3s%-4u %-4s | %3s%-4u %-4s : "
-         "%16u/%-16u  %6.2lf%%\n",
-         res0, r0 + 1, atom0,
-         res1, r1 + 1, atom1,
-         res2, r2 + 1, atom2,
-         res3, r3 + 1, atom3,
-         taf_data->nprune, taf_data->ntest, f);
+  fprintf(fh, "  %3s%-4u %-4s | %3s%-4u %-4s | "
+              "%3s%-4u %-4s | %3s%-4u %-4s : "
+              "%16u/%-16u  %6.2lf%%\n",
+              res0, r0 + 1, atom0,
+              res1, r1 + 1, atom1,
+              res2, r2 + 1, atom2,
+              res3, r3 + 1, atom3,
+              taf_data->nprune, taf_data->ntest, f);
 }
 
 /* enum_prune_dihe_report(): output a report for the dihedral angle
  * feasbility (DIHE) pruning closure.
  */
-void enum_prune_dihe_report (enum_t *E, unsigned int lev, void *data) {
+void enum_prune_dihe_report (enum_t *E, FILE *fh,
+                             unsigned int lev, void *data) {
   /* report using the array of proper dihedrals. */
-  enum_prune_taf_report(E, E->P->torsions, lev, data);
+  enum_prune_taf_report(E, fh, E->P->torsions, lev, data);
 }
 
 /* enum_prune_impr_report(): output a report for the improper angle
  * feasbility (IMPR) pruning closure.
  */
-void enum_prune_impr_report (enum_t *E, unsigned int lev, void *data) {
+void enum_prune_impr_report (enum_t *E, FILE *fh,
+                             unsigned int lev, void *data) {
   /* report using the array of improper dihedrals. */
-  enum_prune_taf_report(E, E->P->impropers, lev, data);
+  enum_prune_taf_report(E, fh, E->P->impropers, lev, data);
 }
 
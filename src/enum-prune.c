@@ -45,45 +45,138 @@ int enum_prune_add_closure (enum_t *E, unsigned int lev,
   E->prune_data[lev] = (void**)
     realloc(E->prune_data[lev], E->prune_sz[lev] * sizeof(void*));
 
-  /* check if either reallocation failed. */
-  if (!E->prune[lev] || !E->prune_data[lev])
+  /* reallocate the method name array. */
+  E->prune_name[lev] = (const char**)
+    realloc(E->prune_name[lev], E->prune_sz[lev] * sizeof(const char*));
+
+  /* check if any reallocation failed. */
+  if (!E->prune[lev] || !E->prune_data[lev] || !E->prune_name[lev])
     throw("unable to reallocate pruning method arrays");
 
-  /* store the closure. */
+  /* store the closure and the method that registered it. */
   E->prune[lev][E->prune_sz[lev] - 1] = func;
   E->prune_data[lev][E->prune_sz[lev] - 1] = data;
+  E->prune_name[lev][E->prune_sz[lev] - 1] = E->prune_cur;
 
   /* return success. */
   return 1;
 }
 
-/* enum_prune_get_level(): function utilized by pruning initialization
- * functions to check whether all atoms in a given entry have been embedded.
+/* prune_terms_index(): index the terms of a peptide array by the graph
+ * level that embeds the last of their atoms, which is the only level at
+ * which a pruning initializer is able to register closures for them.
  *
  * arguments:
- *  @order: graph order.
- *  @lev: current order level.
- *  @id: atom index to check.
+ *  @E: pointer to the enumerator structure to access.
+ *  @T: pointer to the term index to fill.
+ *  @ids: atom indices of the first term.
+ *  @stride: number of bytes between the atom indices of each term.
+ *  @n_ids: number of atoms in each term.
+ *  @n: number of terms in the array.
  *
  * returns:
- *  graph order level (i.e. comparable to @lev) of the specified
- *  atom index.
+ *  integer indicating whether (1) or not (0) the operation succeeded.
  */
-unsigned int enum_prune_get_level (unsigned int *order,
-                                   unsigned int lev,
-                                   unsigned int id) {
+static int prune_terms_index (enum_t *E, enum_terms_t *T,
+                              const unsigned int *ids, size_t stride,
+                              unsigned int n_ids, unsigned int n) {
   /* declare required variables:
-   *  @i: order loop counter.
+   *  @lev: graph level of the last atom of each term.
+   *  @id: atom indices of each term.
+   */
+  const unsigned int *ordrev = E->G->ordrev;
+  const unsigned int len = E->G->n_order;
+  const unsigned int *id;
+  unsigned int i, k, lev;
+
+  /* allocate the level offsets and the term indices. */
+  T->start = (unsigned int*) calloc(len + 1, sizeof(unsigned int));
+  T->id = (unsigned int*) malloc((n ? n : 1) * sizeof(unsigned int));
+  if (!T->start || !T->id)
+    throw("unable to allocate term index");
+
+  /* count the terms completed at each level, skipping terms that hold
+   * atoms missing from the order.
    */
-  unsigned int i;
+  for (i = 0; i < n; i++) {
+    id = (const unsigned int*) ((const char*) ids + i * stride);
+    for (k = 0, lev = 0; k < n_ids && lev < len; k++)
+      lev = (ordrev[id[k]] > lev ? ordrev[id[k]] : lev);
 
-  /* check for a match in the order prior to @lev. */
-  for (i = 0; i <= lev; i++) {
-    if (order[i] == id)
-      return i;
+    if (lev < len)
+      T->start[lev + 1]++;
   }
 
-  /* return the index, which is now (@lev+1). */
-  return i;
+  /* convert the counts into offsets. */
+  for (lev = 0; lev < len; lev++)
+    T->start[lev + 1] += T->start[lev];
+
+  /* file the terms under their levels, using the offsets as cursors
+   * that are shifted back afterwards.
+   */
+  for (i = 0; i < n; i++) {
+    id = (const unsigned int*) ((const char*) ids + i * stride);
+    for (k = 0, lev = 0; k < n_ids && lev < len; k++)
+      lev = (ordrev[id[k]] > lev ? ordrev[id[k]] : lev);
+
+    if (lev < len)
+      T->id[T->start[lev]++] = i;
+  }
+
+  for (lev = len; lev > 0; lev--)
+    T->start[lev] = T->start[lev - 1];
+
+  T->start[0] = 0;
+
+  /* return success. */
+  return 1;
+}
+
+/* enum_prune_terms_init(): index the bonds, angles, torsions and
+ * impropers of the peptide of an enumerator by the graph level at which
+ * they are completed, so that each pruning initializer only visits the
+ * terms of its own level.
+ *
+ * arguments:
+ *  @E: pointer to the enumerator structure to modify.
+ *
+ * returns:
+ *  integer indicating whether (1) or not (0) the operation succeeded.
+ */
+int enum_prune_terms_init (enum_t *E) {
+  /* get a reference to the peptide. */
+  peptide_t *P = E->P;
+
+  /* index each array of terms. */
+  if (!prune_terms_index(E, &E->bonds, P->bonds ? P->bonds->atom_id : NULL,
+                         sizeof(peptide_bond_t), 2, P->n_bonds) ||
+      !prune_terms_index(E, &E->angles,
+                         P->angles ? P->angles->atom_id : NULL,
+                         sizeof(peptide_angle_t), 3, P->n_angles) ||
+      !prune_terms_index(E, &E->torsions,
+                         P->torsions ? P->torsions->atom_id : NULL,
+                         sizeof(peptide_dihed_t), 4, P->n_torsions) ||
+      !prune_terms_index(E, &E->impropers,
+                         P->impropers ? P->impropers->atom_id : NULL,
+                         sizeof(peptide_dihed_t), 4, P->n_impropers))
+    throw("unable to index peptide terms");
+
+  /* return success. */
+  return 1;
+}
+
+/* enum_prune_terms_free(): release the term indices of an enumerator.
+ *
+ * arguments:
+ *  @E: pointer to the enumerator structure to modify.
+ */
+void enum_prune_terms_free (enum_t *E) {
+  /* free each index. */
+  enum_terms_t *T[4] = { &E->bonds, &E->angles, &E->torsions, &E->impropers };
+  for (unsigned int i = 0; i < 4; i++) {
+    free(T[i]->start);
+    free(T[i]->id);
+    T[i]->start = T[i]->id = NULL;
+  }
 }
 
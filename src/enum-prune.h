@@ -2,15 +2,31 @@
 /* ensure once-only inclusion. */
 #pragma once
 
+/* enum_prune_kernel_fn: function pointer specification for compiled
+ * pruning kernels, which test the node at a single level of a thread
+ * state against constants specific to that level.
+ *
+ * arguments:
+ *  @state: pointer to the state array of the thread to test.
+ *  @ntest: array of test counts of each preceeding level.
+ *  @nprune: array of prune counts of each preceeding level.
+ *
+ * returns:
+ *  integer indicating whether (1) or not (0) the tree may be pruned.
+ */
+typedef int (*enum_prune_kernel_fn) (const void *state,
+                                     unsigned int *ntest,
+                                     unsigned int *nprune);
+
 /* function declarations (enum-prune.c): */
 
 int enum_prune_add_closure (enum_t *E, unsigned int lev,
                             enum_prune_test_fn func,
                             void *data);
 
-unsigned int enum_prune_get_level (unsigned int *order,
-                                   unsigned int lev,
-                                   unsigned int id);
+int enum_prune_terms_init (enum_t *E);
+
+void enum_prune_terms_free (enum_t *E);
 
 /* function declarations (enum-prune-ddf.c): */
 
@@ -18,7 +34,12 @@ int enum_prune_ddf_init (enum_t *E, unsigned int lev);
 
 int enum_prune_ddf (enum_t *E, enum_thread_t *th, void *data);
 
-void enum_prune_ddf_report (enum_t *E, unsigned int lev, void *data);
+void enum_prune_ddf_report (enum_t *E, FILE *fh,
+                            unsigned int lev, void *data);
+
+void enum_prune_ddf_kernel (void *data, enum_prune_kernel_fn kernel);
+
+int enum_prune_ddf_valid (enum_t *E, enum_thread_t *th);
 
 /* function declarations (enum-prune-taf.c): */
 
@@ -28,9 +49,11 @@ int enum_prune_impr_init (enum_t *E, unsigned int lev);
 
 int enum_prune_taf (enum_t *E, enum_thread_t *th, void *data);
 
-void enum_prune_dihe_report (enum_t *E, unsigned int lev, void *data);
+void enum_prune_dihe_report (enum_t *E, FILE *fh,
+                             unsigned int lev, void *data);
 
-void enum_prune_impr_report (enum_t *E, unsigned int lev, void *data);
+void enum_prune_impr_report (enum_t *E, FILE *fh,
+                             unsigned int lev, void *data);
 
 /* function declarations (enum-prune-path.c): */
 
@@ -38,7 +61,8 @@ int enum_prune_path_init (enum_t *E, unsigned int lev);
 
 int enum_prune_path (enum_t *E, enum_thread_t *th, void *data);
 
-void enum_prune_path_report (enum_t *E, unsigned int lev, void *data);
+void enum_prune_path_report (enum_t *E, FILE *fh,
+                             unsigned int lev, void *data);
 
 /* function declarations (enum-prune-future.c): */
 
@@ -46,13 +70,26 @@ int enum_prune_future_init (enum_t *E, unsigned int lev);
 
 int enum_prune_future (enum_t *E, enum_thread_t *th, void *data);
 
-void enum_prune_future_report (enum_t *E, unsigned int lev, void *data);
+void enum_prune_future_report (enum_t *E, FILE *fh,
+                               unsigned int lev, void *data);
+
+/* function declarations (enum-prune-forward.c): */
+
+int enum_prune_forward_init (enum_t *E, unsigned int lev);
+
+int enum_prune_forward (enum_t *E, enum_thread_t *th, void *data);
+
+void enum_prune_forward_report (enum_t *E, FILE *fh,
+                                unsigned int lev, void *data);
 
 /* function declarations (enum-prune-energy.c): */
 
 int enum_prune_energy_init (enum_t *E, unsigned int lev);
 
+void enum_prune_energy_done (enum_t *E);
+
 int enum_prune_energy (enum_t *E, enum_thread_t *th, void *data);
 
-void enum_prune_energy_report (enum_t *E, unsigned int lev, void *data);
+void enum_prune_energy_report (enum_t *E, FILE *fh,
+                               unsigned int lev, void *data);
 
@@ -0,0 +1,222 @@
+
+/* include the enumerator headers. */
+#include "enum.h"
+#include "enum-thread.h"
+#include "enum-write.h"
+
+/* solutions written in the path output format are reconstructed by
+ * restoring the state indices of their branching levels and embedding
+ * the single path that they describe, using the same embedding and
+ * pruning code as the enumeration that wrote them. the reconstructed
+ * solutions are written through the output system of the enumerator.
+ *
+ * for more details, consult:
+ *  - enum_write_path() in enum-write.c
+ *  - enum_thread_path() in enum-thread.c
+ */
+
+/* enum_replay_selected(): determine whether a solution index lies within a
+ * selection of comma-separated indices and index ranges, e.g. "1-10,42".
+ *
+ * arguments:
+ *  @sel: selection string, or null to select every solution.
+ *  @i: one-based solution index to check.
+ *
+ * returns:
+ *  integer indicating whether (1) or not (0) the solution is selected.
+ */
+int enum_replay_selected (const char *sel, const unsigned int i) {
+  /* declare required variables:
+   *  @a, @b: first and last indices of each range.
+   *  @end: end pointer of each parsed index.
+   */
+  unsigned long a, b;
+  char *end;
+
+  /* select every solution if no selection was given. */
+  if (!sel)
+    return 1;
+
+  /* loop over the ranges of the selection. */
+  while (*sel) {
+    /* parse the first and last indices of the range. */
+    a = b = strtoul(sel, &end, 10);
+    if (*end == '-')
+      b = strtoul(end + 1, &end, 10);
+
+    /* check if the index lies within the range. */
+    if (i >= a && i <= b)
+      return 1;
+
+    /* move to the next range. */
+    if (*end != ',')
+      break;
+
+    sel = end + 1;
+  }
+
+  /* the index is not selected. */
+  return 0;
+}
+
+/* enum_replay_init(): open the path output file that an enumerator will
+ * reconstruct solutions from, and check that its header matches the tree
+ * of the enumerator.
+ *
+ * arguments:
+ *  @E: pointer to the enumerator structure to modify.
+ *
+ * returns:
+ *  integer indicating whether (1) or not (0) the operation succeeded.
+ */
+int enum_replay_init (enum_t *E) {
+  /* declare required variables:
+   *  @magic: magic string buffer.
+   *  @ibuf: integer data buffer.
+   *  @k: branching level index.
+   */
+  char magic[8];
+  int ibuf[3];
+  unsigned int k;
+
+  /* open the path output file. */
+  E->replay_fh = fopen(E->fname_replay, "rb");
+  if (!E->replay_fh)
+    throw("unable to open path file '%s'", E->fname_replay);
+
+  /* read and check the magic string. */
+  if (fread(magic, sizeof(char), 8, E->replay_fh) != 8 ||
+      memcmp(magic, ENUM_PATH_MAGIC, 8))
+    throw("'%s' is not a path file", E->fname_replay);
+
+  /* read and check the tree dimensions. */
+  if (fread(ibuf, sizeof(int), 3, E->replay_fh) != 3 ||
+      ibuf[0] != (int) E->G->n_order ||
+      ibuf[1] != (int) E->G->n_orig ||
+      ibuf[2] != (int) E->n_levels)
+    throw("path file '%s' does not match the graph order",
+          E->fname_replay);
+
+  /* read and check the branching levels and their branch counts. */
+  for (k = 0; k < E->n_levels; k++) {
+    if (fread(ibuf, sizeof(int), 2, E->replay_fh) != 2 ||
+        ibuf[0] != (int) E->levels[k] ||
+        ibuf[1] != (int) E->threads[0].state[E->levels[k]].nb)
+      throw("path file '%s' does not match the tree at level %u",
+            E->fname_replay, k);
+  }
+
+  /* return success. */
+  return 1;
+}
+
+/* enum_thread_replay(): thread function for reconstructing solutions
+ * from a path output file. only the first thread reads the file.
+ *
+ * arguments:
+ *  @pdata: pointer to the current enumerator thread data structure.
+ */
+void *enum_thread_replay (void *pdata) {
+  /* get references to the current thread data. */
+  enum_thread_t *thread = (enum_thread_t*) pdata;
+  enum_thread_node_t *state = thread->state;
+  enum_t *E = thread->E;
+
+  /* declare required variables:
+   *  @bits: number of bits of the state index of each branching level.
+   *  @idx: unpacked state indices of each solution.
+   *  @buf: packed state indices of each solution.
+   *  @sz: number of bytes of each packed path.
+   *  @i: one-based index of each solution in the file.
+   *  @xf: stored energy of each solution.
+   */
+  unsigned int *bits, *idx, sz, i, k;
+  unsigned char *buf;
+  float xf;
+
+  /* only the first thread reconstructs solutions. */
+  if (thread != E->threads)
+    return NULL;
+
+  /* allocate the bit counts and the unpacked indices. */
+  bits = (unsigned int*) malloc(2 * (E->n_levels + 1) *
+                                sizeof(unsigned int));
+  if (!bits) {
+    raise("unable to allocate path bit counts");
+    return NULL;
+  }
+
+  idx = bits + (E->n_levels + 1);
+
+  /* compute the bit counts and the size of each packed path. */
+  for (k = 0, sz = 0; k < E->n_levels; k++) {
+    bits[k] = 0;
+    while ((1U << bits[k]) < state[E->levels[k]].nb)
+      bits[k]++;
+
+    sz += bits[k];
+  }
+  sz = (sz + 7) / 8;
+
+  /* allocate the path buffer. */
+  buf = (unsigned char*) malloc(sz + 1);
+  if (!buf) {
+    raise("unable to allocate path buffer");
+    free(bits);
+    return NULL;
+  }
+
+  /* loop over the solutions stored in the file. */
+  for (i = 1; fread(buf, 1, sz, E->replay_fh) == sz &&
+              fread(&xf, sizeof(float), 1, E->replay_fh) == 1; i++) {
+    /* check if we should terminate reconstruction. */
+    if (E->term || (E->nmax && E->nsol >= E->nmax))
+      break;
+
+    /* publish the state into any requested snapshot. */
+    if (thread->snap_seen != E->snap)
+      enum_snap_publish(thread);
+
+    /* skip unselected solutions. */
+    if (!enum_replay_selected(E->select, i))
+      continue;
+
+    /* unpack the state indices of the branching levels. */
+    enum_write_path_unpack(buf, bits, E->n_levels, idx);
+    for (k = 0; k < E->n_levels; k++)
+      state[E->levels[k]].idx = idx[k];
+
+    /* stored solutions have already passed the rmsd and energy checks of
+     * the enumeration, so neither the previous solution nor the energy
+     * tolerance of earlier solutions may reject them.
+     */
+    for (k = 0; k < E->G->n_order; k++)
+      vector_set(&state[k].prev, 1.0e6, 1.0e6, 1.0e6);
+
+    E->energy_tol = INFINITY;
+
+    /* embed the path and hand the solution to the output system. */
+    if (!enum_thread_path(thread)) {
+      warn("solution %u of '%s' is infeasible", i, E->fname_replay);
+      continue;
+    }
+
+    if (!enum_thread_solution(thread)) {
+      raise("failed to handle solution");
+      break;
+    }
+  }
+
+  /* output an informational message. */
+  info("reconstructed %u solutions from '%s'", E->nsol, E->fname_replay);
+
+  /* close the file and free the buffers. */
+  fclose(E->replay_fh);
+  E->replay_fh = NULL;
+  free(bits);
+  free(buf);
+
+  /* end thread execution. */
+  return NULL;
+}
+
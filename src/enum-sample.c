@@ -0,0 +1,542 @@
+
+/* include the enumerator headers. */
+#include "enum.h"
+#include "enum-thread.h"
+
+/* ENUM_SAMPLE_WINDOW: number of branching levels above the deepest level
+ * reached by a probe into which the probe may backtrack before it is
+ * abandoned and restarted from the root.
+ */
+#define ENUM_SAMPLE_WINDOW  4
+
+/* ENUM_SAMPLE_MAX_FAILS: number of consecutive abandoned probes after
+ * which a sampling thread stops looking for feasible leaves.
+ */
+#define ENUM_SAMPLE_MAX_FAILS  100000
+
+/* ENUM_SAMPLE_MAX_DRAWN: number of branch indices that the drawn leaves
+ * may hold in total, which bounds their memory at 256 MiB. leaves drawn
+ * once the bound is reached are still checked against the stored ones,
+ * but are not stored themselves, and may therefore be drawn again.
+ */
+#define ENUM_SAMPLE_MAX_DRAWN  (1UL << 26)
+
+/* ENUM_RESTART_UNIT: number of nodes tested by a randomized restart run
+ * per unit of the luby sequence.
+ */
+#define ENUM_RESTART_UNIT  1024
+
+/* ENUM_RESTART_DEPTH: number of branching levels, counted from the root,
+ * whose branches are visited in random order by a randomized restart run.
+ */
+#define ENUM_RESTART_DEPTH  8
+
+/* sample_hash(): compute the hash of the branch path of a leaf.
+ *
+ * arguments:
+ *  @path: branch indices at every branching level of the leaf.
+ *  @m: number of branching levels.
+ *
+ * returns:
+ *  hash value of the branch path.
+ */
+static inline unsigned int sample_hash (const unsigned int *path,
+                                        const unsigned int m) {
+  /* compute the fnv-1a hash of the branch indices. */
+  unsigned int h = 2166136261u;
+  for (unsigned int k = 0; k < m; k++) {
+    h ^= path[k];
+    h *= 16777619u;
+  }
+
+  /* return the hash. */
+  return h;
+}
+
+/* sample_find(): locate the hash table slot of the branch path of a leaf,
+ * which either holds the same path or is empty.
+ *
+ * arguments:
+ *  @E: pointer to the enumerator structure to access.
+ *  @path: branch indices at every branching level of the leaf.
+ *
+ * returns:
+ *  index of the hash table slot.
+ */
+static unsigned int sample_find (enum_t *E, const unsigned int *path) {
+  /* get the number of branching levels and the slot mask. */
+  const unsigned int m = E->n_levels;
+  const unsigned int mask = E->drawn_sz - 1;
+
+  /* probe linearly from the home slot of the path. */
+  unsigned int s = sample_hash(path, m) & mask;
+  while (E->drawn_tab[s] &&
+         memcmp(E->drawn + (E->drawn_tab[s] - 1) * m, path,
+                m * sizeof(unsigned int)))
+    s = (s + 1) & mask;
+
+  /* return the slot. */
+  return s;
+}
+
+/* sample_mark(): mark the current leaf of a thread as drawn.
+ *
+ * arguments:
+ *  @th: pointer to the thread holding the leaf.
+ *  @fresh: pointer to the output flag, set when the leaf was not drawn
+ *          before.
+ *
+ * returns:
+ *  integer indicating whether (1) or not (0) the operation succeeded.
+ */
+static int sample_mark (enum_thread_t *th, int *fresh) {
+  /* get references to the enumerator and the branching levels. */
+  enum_t *E = th->E;
+  const unsigned int m = E->n_levels;
+  unsigned int *path, s, i;
+
+  /* determine whether the drawn leaves may grow any further. */
+  const int full = ((unsigned long) (E->n_drawn + 1) * m >
+                    ENUM_SAMPLE_MAX_DRAWN);
+
+  /* grow the leaf array if required. */
+  if (E->n_drawn == E->cap_drawn && !full) {
+    E->cap_drawn = (E->cap_drawn ? 2 * E->cap_drawn : 256);
+    E->drawn = (unsigned int*)
+      realloc(E->drawn, (E->cap_drawn + 1) * m * sizeof(unsigned int));
+    if (!E->drawn)
+      throw("unable to store drawn leaves");
+  }
+
+  /* store the branch path of the leaf after the drawn leaves. */
+  path = E->drawn + E->n_drawn * m;
+  for (i = 0; i < m; i++)
+    path[i] = th->state[E->levels[i]].idx;
+
+  /* grow and rebuild the hash table if it is half full. */
+  if (2 * (E->n_drawn + 1) > E->drawn_sz && !full) {
+    free(E->drawn_tab);
+    E->drawn_sz = (E->drawn_sz ? 2 * E->drawn_sz : 512);
+    E->drawn_tab = (unsigned int*)
+      calloc(E->drawn_sz, sizeof(unsigned int));
+    if (!E->drawn_tab)
+      throw("unable to allocate drawn leaf table");
+
+    for (i = 0; i < E->n_drawn; i++)
+      E->drawn_tab[sample_find(E, E->drawn + i * m)] = i + 1;
+  }
+
+  /* add the leaf unless it has been drawn before, or the drawn leaves
+   * are full.
+   */
+  s = sample_find(E, path);
+  *fresh = !E->drawn_tab[s];
+  if (!*fresh || full)
+    return 1;
+
+  E->drawn_tab[s] = ++E->n_drawn;
+
+  /* warn once the drawn leaves reach their bound. */
+  if ((unsigned long) (E->n_drawn + 1) * m > ENUM_SAMPLE_MAX_DRAWN)
+    warn("stored %u drawn leaves, later leaves may repeat", E->n_drawn);
+
+  /* return success. */
+  return 1;
+}
+
+/* sample_level_init(): prepare a level of a probe for drawing branches
+ * in random order without replacement.
+ *
+ * arguments:
+ *  @perm: branch permutation array of the level.
+ *  @ntry: pointer to the number of branches drawn at the level.
+ *  @nb: number of branches at the level.
+ */
+static inline void sample_level_init (unsigned int *perm,
+                                      unsigned int *ntry,
+                                      const unsigned int nb) {
+  /* reset the permutation and the draw count. */
+  for (unsigned int k = 0; k < nb; k++)
+    perm[k] = k;
+
+  *ntry = 0;
+}
+
+/* sample_level_draw(): draw the next branch of a level of a probe,
+ * using one step of a lazy fisher-yates shuffle.
+ *
+ * arguments:
+ *  @th: pointer to the thread that owns the random number generator.
+ *  @perm: branch permutation array of the level.
+ *  @ntry: pointer to the number of branches drawn at the level.
+ *  @nb: number of branches at the level.
+ *
+ * returns:
+ *  index of the drawn branch.
+ */
+static inline unsigned int sample_level_draw (enum_thread_t *th,
+                                              unsigned int *perm,
+                                              unsigned int *ntry,
+                                              const unsigned int nb) {
+  /* choose a random branch among those not yet drawn. */
+  const unsigned int i = *ntry;
+  const unsigned int j = i + enum_thread_random(th, nb - i);
+
+  /* swap it into the drawn part of the permutation. */
+  const unsigned int k = perm[j];
+  perm[j] = perm[i];
+  perm[i] = k;
+
+  /* increment the draw count and return the branch. */
+  (*ntry)++;
+  return k;
+}
+
+/* enum_thread_sample(): thread function for enumerator threads that
+ * draw solutions by random probing instead of depth-first traversal.
+ *
+ * each probe descends from the root by choosing a random branch at every
+ * branching level, and embeds each branch along with the single-choice
+ * atoms that follow it, as in the depth-first traversal. when a branch is
+ * pruned, the probe tries the remaining branches of its level in random
+ * order, and backtracks into at most a few of the branching levels above
+ * it before being abandoned. feasible leaves are handled as in the
+ * depth-first traversal, unless they have been drawn before, and probing
+ * continues until the sample size has been reached.
+ *
+ * arguments:
+ *  @pdata: pointer to the current enumerator thread data structure.
+ */
+void *enum_thread_sample (void *pdata) {
+  /* get references to the current thread data. */
+  enum_thread_t *thread = (enum_thread_t*) pdata;
+  enum_thread_node_t *state = thread->state;
+  enum_t *E = thread->E;
+
+  /* get references to the branching levels. */
+  const unsigned int *lv = E->levels;
+  const unsigned int m = E->n_levels;
+
+  /* declare required variables:
+   *  @offs: offsets of each branching level into the permutation array.
+   *  @ntry: number of branches drawn at each branching level of the probe.
+   *  @perm: branch permutations of every branching level.
+   *  @k: current branching level index of the probe.
+   *  @deep: deepest branching level index reached by the probe.
+   *  @floor: shallowest branching level index that the probe may
+   *          backtrack into.
+   *  @nfail: number of consecutive abandoned probes.
+   *  @leaf: whether the probe reached a feasible leaf.
+   *  @fresh: whether the leaf of the probe was not drawn before.
+   */
+  unsigned int *offs, *ntry, *perm;
+  unsigned int k, deep, floor, nfail, sz;
+  int leaf, fresh, ok;
+
+  /* embed the single-choice atoms that precede all branching. trees
+   * without branching hold a single leaf, which is handled by the first
+   * thread only.
+   */
+  if (!enum_thread_step(thread, 3, lv[0]) ||
+      (m == 0 && (thread != E->threads || E->G->n_order <= 3)))
+    return NULL;
+
+  if (m == 0) {
+    if (!enum_thread_solution(thread))
+      raise("failed to handle solution");
+
+    return NULL;
+  }
+
+  /* compute the size of the permutation array. */
+  for (k = 0, sz = 0; k < m; k++)
+    sz += state[lv[k]].nb;
+
+  /* allocate the probe arrays. */
+  offs = (unsigned int*) malloc((2 * m + sz) * sizeof(unsigned int));
+  if (!offs) {
+    raise("unable to allocate sampling arrays");
+    return NULL;
+  }
+
+  /* initialize the probe array pointers and level offsets. */
+  ntry = offs + m;
+  perm = ntry + m;
+  for (k = 0, sz = 0; k < m; k++) {
+    offs[k] = sz;
+    sz += state[lv[k]].nb;
+  }
+
+  /* loop until enough solutions have been drawn. */
+  nfail = 0;
+  while (!E->term && nfail < ENUM_SAMPLE_MAX_FAILS &&
+         !(E->nmax && E->nsol >= E->nmax)) {
+    /* publish the state into any requested snapshot. */
+    if (thread->snap_seen != E->snap)
+      enum_snap_publish(thread);
+
+    /* start a new probe from the root. */
+    k = deep = floor = 0;
+    leaf = 0;
+    fresh = 1;
+    sample_level_init(perm + offs[k], ntry + k, state[lv[k]].nb);
+
+    /* descend until a leaf is reached or the probe is abandoned. */
+    while (1) {
+      /* backtrack if every branch at this level has been drawn, and
+       * abandon the probe below the backtracking window.
+       */
+      if (ntry[k] >= state[lv[k]].nb) {
+        if (k == floor)
+          break;
+
+        k--;
+        continue;
+      }
+
+      /* draw a branch, and embed and check the atoms of the step. */
+      state[lv[k]].idx = sample_level_draw(thread, perm + offs[k],
+                                           ntry + k, state[lv[k]].nb);
+      if (!enum_thread_step(thread, lv[k], lv[k + 1]))
+        continue;
+
+      /* check if the step is terminal. */
+      if (k == m - 1) {
+#ifdef __IBP_HAVE_PTHREAD
+        /* mark the leaf as drawn. */
+        pthread_mutex_lock(&E->write_mutex);
+        ok = sample_mark(thread, &fresh);
+        pthread_mutex_unlock(&E->write_mutex);
+#else
+        ok = sample_mark(thread, &fresh);
+#endif
+
+        /* handle the solution if it is new, and end the probe. */
+        if (!ok || (fresh && !enum_thread_solution(thread))) {
+          raise("failed to handle solution");
+          E->term = 1;
+          free(offs);
+          return NULL;
+        }
+
+        leaf = 1;
+        break;
+      }
+
+      /* move down a level, narrowing the backtracking window. */
+      k++;
+      if (k > deep) {
+        deep = k;
+        floor = (deep > ENUM_SAMPLE_WINDOW ? deep - ENUM_SAMPLE_WINDOW : 0);
+      }
+
+      /* prepare the new level for drawing. */
+      sample_level_init(perm + offs[k], ntry + k, state[lv[k]].nb);
+    }
+
+    /* count consecutive abandoned probes and repeated leaves. */
+    nfail = (leaf && fresh ? 0 : nfail + 1);
+  }
+
+  /* warn if the thread gave up before reaching the sample size. */
+  if (nfail >= ENUM_SAMPLE_MAX_FAILS)
+    warn("thread %u abandoned %u consecutive probes",
+         (unsigned int) (thread - E->threads) + 1, nfail);
+
+  /* free the probe arrays and end thread execution. */
+  free(offs);
+  return NULL;
+}
+
+/* restart_luby(): compute a term of the luby sequence
+ * (1, 1, 2, 1, 1, 2, 4, 1, 1, 2, ...).
+ *
+ * arguments:
+ *  @i: one-based index of the term.
+ *
+ * returns:
+ *  value of the term.
+ */
+static inline unsigned int restart_luby (unsigned int i) {
+  /* declare required variables. */
+  unsigned int k;
+
+  /* strip complete subsequences until the term ends one. */
+  while (1) {
+    for (k = 1; (1u << k) - 1 < i; k++);
+    if ((1u << k) - 1 == i)
+      return 1u << (k - 1);
+
+    i -= (1u << (k - 1)) - 1;
+  }
+}
+
+/* restart_leaf(): handle a feasible leaf of a randomized restart run,
+ * unless an earlier run has found it.
+ *
+ * arguments:
+ *  @th: pointer to the thread holding the leaf.
+ *
+ * returns:
+ *  integer indicating whether (1) or not (0) the leaf was handled without
+ *  errors.
+ */
+static int restart_leaf (enum_thread_t *th) {
+  /* declare required variables. */
+  int fresh, ok;
+
+#ifdef __IBP_HAVE_PTHREAD
+  /* mark the leaf as found. */
+  pthread_mutex_lock(&th->E->write_mutex);
+  ok = sample_mark(th, &fresh);
+  pthread_mutex_unlock(&th->E->write_mutex);
+#else
+  ok = sample_mark(th, &fresh);
+#endif
+
+  /* handle the solution if it was not found by an earlier run. */
+  return (ok && (!fresh || enum_thread_solution(th)));
+}
+
+/* enum_thread_restart(): thread function for enumerator threads that
+ * search for solutions by randomized restarts of the depth-first
+ * traversal.
+ *
+ * each run visits the branches of the first few branching levels in
+ * random order, and traverses the subtree below every feasible prefix
+ * depth-first. a run is cut off and restarted from the root once it has
+ * tested a number of nodes that follows the luby sequence. runs therefore
+ * escape large infeasible subtrees near the root, while the growing
+ * budgets ensure that a run will eventually complete. feasible leaves are
+ * handled as in random probing, and runs continue until the solution
+ * limit has been reached.
+ *
+ * arguments:
+ *  @pdata: pointer to the current enumerator thread data structure.
+ */
+void *enum_thread_restart (void *pdata) {
+  /* get references to the current thread data. */
+  enum_thread_t *thread = (enum_thread_t*) pdata;
+  enum_thread_node_t *state = thread->state;
+  enum_t *E = thread->E;
+
+  /* get references to the branching levels. */
+  const unsigned int *lv = E->levels;
+  const unsigned int m = E->n_levels;
+
+  /* declare required variables:
+   *  @offs: offsets of each shuffled level into the permutation array.
+   *  @ntry: number of branches visited at each shuffled level of the run.
+   *  @perm: branch permutations of the shuffled levels.
+   *  @k: current shuffled level index of the run.
+   *  @mix: number of shuffled branching levels.
+   *  @run: one-based index of the current run.
+   */
+  unsigned int *offs, *ntry, *perm;
+  unsigned int k, i, mix, run, sz;
+
+  /* embed the single-choice atoms that precede all branching. trees
+   * without branching hold a single leaf, which is handled by the first
+   * thread only.
+   */
+  if (!enum_thread_step(thread, 3, lv[0]) ||
+      (m == 0 && (thread != E->threads || E->G->n_order <= 3)))
+    return NULL;
+
+  if (m == 0) {
+    if (!enum_thread_solution(thread))
+      raise("failed to handle solution");
+
+    return NULL;
+  }
+
+  /* count the shuffled branching levels. */
+  mix = (m > ENUM_RESTART_DEPTH ? ENUM_RESTART_DEPTH : m);
+
+  /* compute the size of the permutation array. */
+  for (k = 0, sz = 0; k < mix; k++)
+    sz += state[lv[k]].nb;
+
+  /* allocate the run arrays. */
+  offs = (unsigned int*) malloc((2 * mix + sz) * sizeof(unsigned int));
+  if (!offs) {
+    raise("unable to allocate restart arrays");
+    return NULL;
+  }
+
+  /* initialize the run array pointers and level offsets. */
+  ntry = offs + mix;
+  perm = ntry + mix;
+  for (k = 0, sz = 0; k < mix; k++) {
+    offs[k] = sz;
+    sz += state[lv[k]].nb;
+  }
+
+  /* loop until enough solutions have been found. */
+  for (run = 1; !E->term && !(E->nmax && E->nsol >= E->nmax); run++) {
+    /* start a new run from the root, with the node budget of the run. */
+    thread->nlim = thread->ntest +
+      (unsigned long) restart_luby(run) * ENUM_RESTART_UNIT;
+    k = 0;
+    sample_level_init(perm + offs[k], ntry + k, state[lv[k]].nb);
+
+    /* visit the shuffled levels until the tree or the budget is spent. */
+    while (thread->ntest < thread->nlim && !E->term &&
+           !(E->nmax && E->nsol >= E->nmax)) {
+      /* publish the state into any requested snapshot. */
+      if (thread->snap_seen != E->snap)
+        enum_snap_publish(thread);
+
+      /* backtrack if every branch at this level has been visited. */
+      if (ntry[k] >= state[lv[k]].nb) {
+        if (k == 0)
+          break;
+
+        k--;
+        continue;
+      }
+
+      /* choose the next branch, and embed and check the atoms of the
+       * step.
+       */
+      state[lv[k]].idx = sample_level_draw(thread, perm + offs[k],
+                                           ntry + k, state[lv[k]].nb);
+      if (!enum_thread_step(thread, lv[k], lv[k + 1]))
+        continue;
+
+      /* move down the shuffled levels. */
+      if (k < mix - 1) {
+        k++;
+        sample_level_init(perm + offs[k], ntry + k, state[lv[k]].nb);
+        continue;
+      }
+
+      /* traverse the whole subtree below the prefix, if any. */
+      for (i = mix; i < m; i++)
+        state[lv[i]].idx = state[lv[i]].end = 0;
+
+      if (mix < m)
+        state[lv[mix]].end = state[lv[mix]].nb;
+
+      if (!(mix < m ? enum_thread_traverse(thread, lv + mix, m - mix,
+                                           lv[mix], restart_leaf)
+                    : restart_leaf(thread))) {
+        raise("failed to handle solution");
+        E->term = 1;
+      }
+    }
+
+    /* a run that exhausted the tree has found every solution. */
+    if (k == 0 && ntry[0] >= state[lv[0]].nb &&
+        thread->ntest < thread->nlim) {
+      info("thread %u exhausted the tree in run %u",
+           (unsigned int) (thread - E->threads) + 1, run);
+      E->term = 1;
+    }
+  }
+
+  /* free the run arrays and end thread execution. */
+  thread->nlim = 0;
+  free(offs);
+  return NULL;
+}
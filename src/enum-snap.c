@@ -0,0 +1,287 @@
+
+/* include the enumerator headers. */
+#include "enum.h"
+#include "enum-thread.h"
+
+/* snapshots are requested asynchronously by incrementing the request
+ * counter of an enumerator, usually from a signal handler. every thread
+ * compares the counter against the last value it has seen at each safe
+ * point of its traversal, and publishes its state into the pending
+ * snapshot file when the values differ. the file is completed with the
+ * current pruning report once every live thread has published, and any
+ * requests received while a file is pending are merged into that file.
+ *
+ * for more details, consult:
+ *  - enum_thread_traverse() in enum-thread.c
+ *  - main_snapshot() in ibp-ng.c
+ */
+
+/* snap_finish(): complete the pending snapshot file of an enumerator.
+ * the caller must hold the write mutex.
+ *
+ * arguments:
+ *  @E: pointer to the enumerator structure to modify.
+ */
+static void snap_finish (enum_t *E) {
+  /* append the current pruning report. */
+  fprintf(E->snap_fh, "\n# pruning report\n");
+  enum_report(E, E->snap_fh);
+
+  /* close the file and merge all requests received until now. */
+  fclose(E->snap_fh);
+  E->snap_fh = NULL;
+  E->snap_cover = E->snap;
+  E->snap_done++;
+
+  /* output an informational message. */
+  info("snapshot %u written to '%s.snap'", E->snap_done, E->fname);
+}
+
+/* snap_open(): open a new snapshot file and write its header. the caller
+ * must hold the write mutex.
+ *
+ * arguments:
+ *  @E: pointer to the enumerator structure to modify.
+ *
+ * returns:
+ *  integer indicating whether (1) or not (0) the file was opened.
+ */
+static int snap_open (enum_t *E) {
+  /* declare required variables:
+   *  @fname: snapshot filename string.
+   */
+  char *fname;
+  unsigned int k;
+
+  /* build the snapshot filename. */
+  fname = (char*) malloc(strlen(E->fname) + 6);
+  if (!fname)
+    return 0;
+
+  /* open the snapshot file. */
+  sprintf(fname, "%s.snap", E->fname);
+  E->snap_fh = fopen(fname, "w");
+  free(fname);
+  if (!E->snap_fh)
+    return 0;
+
+  /* write the header, branching levels and solution counts. */
+  fprintf(E->snap_fh, "# ibp-ng snapshot\n"
+                      "mode %s\nthreads %u\nlevels %u",
+          E->thread_fn == enum_thread_execute ? "dfs" : "other",
+          E->nthreads, E->n_levels);
+
+  for (k = 0; k < E->n_levels; k++)
+    fprintf(E->snap_fh, " %u", E->levels[k]);
+
+  fprintf(E->snap_fh, "\nsolutions %u %u\n", E->nsol, E->nrej);
+
+  /* every live thread must publish into the file. */
+  E->snap_wait = E->nlive;
+
+  /* return success. */
+  return 1;
+}
+
+/* enum_snap_publish(): publish the state of a thread into the pending
+ * snapshot of its enumerator, opening a new snapshot if required.
+ *
+ * arguments:
+ *  @th: pointer to the thread to publish.
+ */
+void enum_snap_publish (enum_thread_t *th) {
+  /* get references to the enumerator and the thread state. */
+  enum_t *E = th->E;
+  enum_thread_node_t *state = th->state;
+  unsigned int k;
+
+#ifdef __IBP_HAVE_PTHREAD
+  /* obtain a lock on the write mutex. */
+  pthread_mutex_lock(&E->write_mutex);
+#endif
+
+  /* mark the current requests as seen by the thread. */
+  th->snap_seen = E->snap;
+
+  /* open a new snapshot for requests that no file has covered. */
+  if (!E->snap_fh && E->snap_cover != th->snap_seen &&
+      !snap_open(E)) {
+    warn("unable to open snapshot file");
+    E->snap_cover = th->snap_seen;
+  }
+
+  /* publish the thread, unless it has already published. */
+  if (E->snap_fh && th->snap != E->snap_done + 1) {
+    /* write the level, energy and node count of the thread. */
+    fprintf(E->snap_fh, "thread %u level %u energy %.17le nodes %lu\nidx",
+            (unsigned int) (th - E->threads) + 1, th->level,
+            state[th->level].energy, th->ntest);
+
+    /* write the state and end indices of the branching levels. */
+    for (k = 0; k < E->n_levels; k++)
+      fprintf(E->snap_fh, " %u", state[E->levels[k]].idx);
+
+    fprintf(E->snap_fh, "\nend");
+    for (k = 0; k < E->n_levels; k++)
+      fprintf(E->snap_fh, " %u", state[E->levels[k]].end);
+
+    fprintf(E->snap_fh, "\n");
+
+    /* complete the snapshot once every live thread has published. */
+    th->snap = E->snap_done + 1;
+    if (--E->snap_wait == 0)
+      snap_finish(E);
+  }
+
+#ifdef __IBP_HAVE_PTHREAD
+  /* unlock the write mutex. */
+  pthread_mutex_unlock(&E->write_mutex);
+#endif
+}
+
+/* enum_snap_leave(): remove a thread that has finished its traversal from
+ * the set of threads that must publish into snapshots.
+ *
+ * arguments:
+ *  @th: pointer to the finished thread.
+ */
+void enum_snap_leave (enum_thread_t *th) {
+  /* get a reference to the enumerator. */
+  enum_t *E = th->E;
+
+#ifdef __IBP_HAVE_PTHREAD
+  /* obtain a lock on the write mutex. */
+  pthread_mutex_lock(&E->write_mutex);
+#endif
+
+  /* remove the thread from the live threads. */
+  E->nlive--;
+
+  /* stop waiting for the thread if it has not yet published. */
+  if (E->snap_fh && th->snap != E->snap_done + 1 &&
+      --E->snap_wait == 0)
+    snap_finish(E);
+
+#ifdef __IBP_HAVE_PTHREAD
+  /* unlock the write mutex. */
+  pthread_mutex_unlock(&E->write_mutex);
+#endif
+}
+
+/* enum_snap_resume(): restore the state and end indices of every thread
+ * of an enumerator from a snapshot of an earlier depth-first traversal.
+ * threads without a record in the snapshot had finished their traversal,
+ * and are given an empty range.
+ *
+ * arguments:
+ *  @E: pointer to the enumerator structure to modify.
+ *  @fname: snapshot filename string.
+ *
+ * returns:
+ *  integer indicating whether (1) or not (0) the operation succeeded.
+ */
+int enum_snap_resume (enum_t *E, const char *fname) {
+  /* declare required variables:
+   *  @fh: snapshot file handle.
+   *  @key: keyword buffer.
+   *  @t, @k, @n, @v: thread, level index, count and value.
+   *  @nsol, @nrej: accepted and rejected solution counts.
+   *  @seen: whether each thread has a record in the snapshot.
+   */
+  enum_thread_node_t *state;
+  unsigned int t, k, n, v, nsol = 0, nrej = 0;
+  char key[16], mode[16];
+  unsigned int *seen;
+  FILE *fh;
+
+  /* open the snapshot file. */
+  fh = fopen(fname, "r");
+  if (!fh)
+    throw("unable to open snapshot '%s'", fname);
+
+  /* read and check the header. */
+  if (fscanf(fh, " # ibp-ng snapshot mode %15s threads %u levels %u",
+             mode, &t, &n) != 3 || strcmp(mode, "dfs") ||
+      t != E->nthreads || n != E->n_levels) {
+    fclose(fh);
+    throw("snapshot '%s' does not match the enumeration", fname);
+  }
+
+  /* check the branching levels. */
+  for (k = 0; k < n; k++) {
+    if (fscanf(fh, "%u", &v) != 1 || v != E->levels[k]) {
+      fclose(fh);
+      throw("snapshot '%s' has different branching levels", fname);
+    }
+  }
+
+  /* allocate the record flags. */
+  seen = (unsigned int*) calloc(E->nthreads, sizeof(unsigned int));
+  if (!seen) {
+    fclose(fh);
+    throw("unable to allocate snapshot records");
+  }
+
+  /* read the thread records until the end of the state section. */
+  while (fscanf(fh, " %15s", key) == 1 && strcmp(key, "#")) {
+    /* read the solution counts of the interrupted traversal. */
+    if (!strcmp(key, "solutions")) {
+      if (fscanf(fh, "%u %u", &nsol, &nrej) != 2)
+        break;
+
+      continue;
+    }
+
+    /* skip the remainder of the header. */
+    if (strcmp(key, "thread")) {
+      fscanf(fh, "%*[^\n]");
+      continue;
+    }
+
+    /* read the thread index and skip its level, energy and counters. */
+    if (fscanf(fh, "%u%*[^\n]", &t) != 1 || t < 1 || t > E->nthreads)
+      break;
+
+    /* read the state and end indices of the thread. */
+    state = E->threads[t - 1].state;
+    if (fscanf(fh, " idx") != 0)
+      break;
+
+    for (k = 0; k < n && fscanf(fh, "%u", &v) == 1; k++)
+      state[E->levels[k]].idx = state[E->levels[k]].start = v;
+
+    if (k < n || fscanf(fh, " end") != 0)
+      break;
+
+    for (k = 0; k < n && fscanf(fh, "%u", &v) == 1; k++)
+      state[E->levels[k]].end = v;
+
+    if (k < n)
+      break;
+
+    seen[t - 1] = 1;
+  }
+
+  /* close the snapshot file. */
+  fclose(fh);
+
+  /* give the threads without records an empty range. */
+  for (t = 0; t < E->nthreads; t++) {
+    for (k = 0; k < n && !seen[t]; k++) {
+      state = E->threads[t].state;
+      state[E->levels[k]].idx = state[E->levels[k]].start =
+        state[E->levels[k]].end;
+    }
+  }
+
+  /* continue counting from the solutions of the snapshot. */
+  E->nsol = nsol;
+  E->nrej = nrej;
+
+  /* free the record flags and return success. */
+  free(seen);
+  info("resuming %u threads from snapshot '%s' after %u solutions",
+       E->nthreads, fname, E->nsol);
+  return 1;
+}
+
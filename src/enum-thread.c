@@ -3,142 +3,108 @@
 #include "enum.h"
 #include "enum-thread.h"
 #include "enum-write.h"
+#include "enum-prune.h"
 
-/* state_div(): divide the size of a thread state into uniform pieces,
- * storing the result into the index of the thread state.
+/* state_digits(): store a leaf offset into the indices of the leading
+ * branching levels of a thread state, as a mixed-radix number whose
+ * digits are bounded by the branch counts of each level.
  *
- * arguments:
- *  @state: thread state to operate on.
- *  @len: number of elements in the state.
- *  @n: value to divide the state size by.
- */
-static void state_div (enum_thread_node_t *state,
-                       unsigned int len,
-                       unsigned int n) {
-  /* @bN: base-2 log of the tree size/leaf count.
-   * @bn: base-2 log of the division value.
-   * @bs: base-2 log of the quotient.
-   * @i: general-purpose loop counter.
-   */
-  double bN, bn, bs;
-  unsigned int i;
-
-  /* compute the tree size. */
-  for (i = 0, bN = 0.0; i < len; i++)
-    bN += log2((double) state[i].nb);
-
-  /* compute the quotient. */
-  bn = bN - log2((double) n);
-
-  /* loop to compute the division result. */
-  for (i = len - 1, bs = 0.0; i < len; i--) {
-    /* sum the current node size into the "stride". */
-    bs += log2((double) state[i].nb);
-
-    /* check if the "stride" is sufficiently large. */
-    if (bs == bn) {
-      /* equal: amounts to one step of the parent node index. */
-      state[i - 1].end = 1;
-      break;
-    }
-    else if (bs > bn) {
-      /* larger: compute the closest integer step amount based
-       * on the required amount of bits in the quotient.
-       */
-      bs -= log2((double) state[i].nb);
-      state[i].end = 1 << (unsigned int) floor(bn - bs);
-      break;
-    }
-  }
-}
-
-/* state_add(): add the indices of two states, storing the result into
- * the index of the destination (first) state.
+ * the most significant digit is not reduced, so an offset equal to the
+ * number of leaves under the leading levels is also representable.
  *
  * arguments:
- *  @dest: destination state in the sum.
- *  @src1: source state in the sum.
- *  @len: number of elements in each state.
+ *  @state: thread state to operate on.
+ *  @lv: array of branching levels of the state.
+ *  @r: number of leading branching levels to store into.
+ *  @x: leaf offset to store.
+ *  @end: whether to store into the end (1) or current (0) indices.
  */
-static void state_add (enum_thread_node_t *dest,
-                       enum_thread_node_t *src,
-                       unsigned int len) {
-  /* initialize the output values. */
-  for (unsigned int i = 0; i < len; i++)
-    dest[i].end = 0;
-
-  /* loop over each index of the result. */
-  for (unsigned int i = len - 1; i < len; i--) {
-    /* compute the current term of the sum. */
-    dest[i].end += dest[i].idx + src[i].end;
-
-    /* perform any required carries. */
-    while (i && dest[i].nb && dest[i].end >= dest[i].nb) {
-      dest[i].end -= dest[i].nb;
-      dest[i - 1].end++;
-    }
+static void state_digits (enum_thread_node_t *state,
+                          const unsigned int *lv,
+                          const unsigned int r,
+                          unsigned long long x,
+                          const int end) {
+  /* loop from the least significant digit upwards. */
+  for (unsigned int k = r - 1; k < r; k--) {
+    /* compute the digit of the current level. */
+    const unsigned long long nb = state[lv[k]].nb;
+    const unsigned int d = (unsigned int) (k ? x % nb : x);
+    x = (k ? x / nb : 0);
+
+    /* store the digit. */
+    if (end)
+      state[lv[k]].end = d;
+    else
+      state[lv[k]].idx = d;
   }
 }
 
 /* state_valid(): check whether a state is "valid", meaning that its index
- * has not yet reached its end.
+ * has not yet reached its (exclusive) end.
  *
  * arguments:
  *  @state: state to check for validity.
- *  @len: number of nodes in the state.
+ *  @lv: array of branching levels of the state.
+ *  @m: number of branching levels in the state.
  *
  * returns:
  *  integer indicating state validity (1) or non-validity (0).
  */
 static inline int state_valid (enum_thread_node_t *state,
-                               unsigned int len) {
-  /* if any one index has passed the end value, return false. */
-  for (unsigned int i = 0; i < len; i++) {
-    if (state[i].idx > state[i].end)
-      return 0;
+                               const unsigned int *lv,
+                               const unsigned int m) {
+  /* compare the indices against the end lexicographically. */
+  for (unsigned int k = 0; k < m; k++) {
+    const unsigned int idx = state[lv[k]].idx;
+    const unsigned int end = state[lv[k]].end;
+    if (idx != end)
+      return (idx < end);
   }
 
-  /* return true. */
-  return 1;
+  /* the end has been reached. */
+  return 0;
 }
 
 /* state_increment(): increment the index of a state.
  *
  * arguments:
  *  @state: state to increment.
- *  @len: number of nodes in the state.
- *  @lev: level at which to begin incrementation.
+ *  @lv: array of branching levels of the state.
+ *  @m: number of branching levels in the state.
+ *  @k: branching level at which to begin incrementation.
  *
  * returns:
- *  index of the most upstream node that was modified by the increment.
+ *  index into @lv of the most upstream node that was modified by the
+ *  increment.
  */
 static inline unsigned int state_increment (enum_thread_node_t *state,
-                                            const unsigned int len,
-                                            const unsigned int lev) {
+                                            const unsigned int *lv,
+                                            const unsigned int m,
+                                            const unsigned int k) {
   /* declare required variables:
-   *  @imod: index of the highest modified parent node.
+   *  @kmod: index of the highest modified parent node.
    */
-  unsigned int imod = lev;
+  unsigned int kmod = k;
 
-  /* loop over the skipped state indices (when lev < len - 1). */
-  for (unsigned int i = lev + 1; i < len; i++)
-    state[i].idx = 0;
+  /* loop over the skipped state indices (when k < m - 1). */
+  for (unsigned int i = k + 1; i < m; i++)
+    state[lv[i]].idx = 0;
 
   /* loop over the state indices. */
-  for (unsigned int i = lev; i < len; i--) {
+  for (unsigned int i = k; i < m; i--) {
     /* increment the current index. */
-    state[i].idx++;
-    imod = i;
+    state[lv[i]].idx++;
+    kmod = i;
 
     /* check for overflow. */
-    if (i && state[i].idx >= state[i].nb)
-      state[i].idx = 0;
+    if (i && state[lv[i]].idx >= state[lv[i]].nb)
+      state[lv[i]].idx = 0;
     else
       break;
   }
 
   /* return the highest modified node index. */
-  return imod;
+  return kmod;
 }
 
 /* state_widths(): compute the number of leaf nodes in the implicit
@@ -316,6 +282,96 @@ static inline double state_rmsd (graph_t *G, enum_thread_node_t *state) {
   return 2.0 * (E0 - E);
 }
 
+/* fragments_init(): locate the rigid fragments of an enumerator, which
+ * are maximal runs of original levels having a single branch that does
+ * not depend on the rotamer chosen at an earlier level. the atoms
+ * of a fragment are fully determined by the three levels that precede
+ * it, so their coordinates in the frame of those levels are computed
+ * once here, and each visit places the whole fragment by one rigid
+ * transformation instead of embedding its atoms one by one.
+ *
+ * arguments:
+ *  @E: pointer to the enumerator to modify.
+ *
+ * returns:
+ *  integer indicating whether (1) or not (0) the operation succeeded.
+ */
+static int fragments_init (enum_t *E) {
+  /* get references to the graph and the order length. */
+  graph_t *G = E->G;
+  const unsigned int len = G->n_order;
+  const unsigned int *dup = G->orig;
+
+  /* declare required variables:
+   *  @tmp: scratch thread used to embed each fragment.
+   *  @u, @v, @w: basis of the frame preceding a fragment.
+   */
+  enum_thread_t tmp = E->threads[0];
+  vector_t u, v, w;
+  unsigned int a, b, lev;
+
+  /* allocate the fragment arrays. */
+  free(E->frag);
+  free(E->frag_pos);
+  E->frag = (unsigned int*) calloc(len, sizeof(unsigned int));
+  E->frag_pos = (vector_t*) calloc(len, sizeof(vector_t));
+  if (!E->frag || !E->frag_pos)
+    throw("unable to allocate rigid fragments");
+
+  /* allocate a scratch copy of the first thread state. */
+  tmp.state = (enum_thread_node_t*)
+    malloc(len * sizeof(enum_thread_node_t));
+  if (!tmp.state)
+    throw("unable to allocate scratch thread state");
+
+  memcpy(tmp.state, E->threads[0].state, len * sizeof(enum_thread_node_t));
+
+  /* loop over the runs of single-branch original levels. */
+  for (a = 3; a < len; a = (b > a ? b : a + 1)) {
+    for (b = a; b < len && !dup[b] && tmp.state[b].nb == 1 &&
+                !(E->n_rot && E->n_rot[b] > 1); b++);
+    if (b == a)
+      continue;
+
+    /* place the preceding frame, resolving duplicates to the levels
+     * that the embedding reads from.
+     */
+    enum_thread_frame(&tmp, a - 3);
+    for (lev = a - 3; lev < a; lev++)
+      tmp.state[lev - dup[lev]].pos = tmp.state[lev].pos;
+
+    /* embed the atoms of the fragment. */
+    for (lev = a; lev < b; lev++) {
+      tmp.state[lev].idx = 0;
+      enum_thread_embed(&tmp, lev);
+    }
+
+    /* store the atom coordinates in the frame basis. */
+    const vector_t x0 = tmp.state[a - 3].pos;
+    enum_thread_basis(&x0, &tmp.state[a - 2].pos, &tmp.state[a - 1].pos,
+                      &u, &v, &w);
+
+    for (lev = a; lev < b; lev++) {
+      const vector_t dx = {
+        tmp.state[lev].pos.x - x0.x,
+        tmp.state[lev].pos.y - x0.y,
+        tmp.state[lev].pos.z - x0.z
+      };
+
+      E->frag_pos[lev].x = dx.x * u.x + dx.y * u.y + dx.z * u.z;
+      E->frag_pos[lev].y = dx.x * v.x + dx.y * v.y + dx.z * v.z;
+      E->frag_pos[lev].z = dx.x * w.x + dx.y * w.y + dx.z * w.z;
+    }
+
+    /* mark the start of the fragment. */
+    E->frag[a] = b;
+  }
+
+  /* free the scratch state and return success. */
+  free(tmp.state);
+  return 1;
+}
+
 /* enum_threads_init(): initialize a set of threads prior to use.
  *
  * arguments:
@@ -333,6 +389,14 @@ int enum_threads_init (enum_t *E) {
       continue;
     }
 
+    /* the first rotamer level of a sidechain branches over its rotamers,
+     * which fix the dihedrals of the later levels of the sidechain.
+     */
+    if (E->n_rot && E->n_rot[i]) {
+      E->threads[0].state[i].nb = (E->rot_lead[i] == i ? E->n_rot[i] : 1);
+      continue;
+    }
+
     /* get the d(i,i-3) edge weight. */
     const unsigned int i0 = E->G->order[i - 3];
     const unsigned int i3 = E->G->order[i];
@@ -367,33 +431,59 @@ int enum_threads_init (enum_t *E) {
     for (unsigned int i = 0; i < E->G->n_order; i++)
       E->threads[t].state[i].nb = E->threads[0].state[i].nb;
 
-  /* check if more than one thread will be executed. */
-  if (E->nthreads > 1) {
-    /* determine the division of labor. */
-    state_div(E->threads[0].state, E->G->n_order, E->nthreads);
-
-    /* set up the threads based on the computed division. */
-    for (unsigned int t = 1; t < E->nthreads; t++) {
-      /* compute the state start. */
-      for (unsigned int i = 0; i < E->G->n_order; i++)
-        E->threads[t].state[i].idx = E->threads[t - 1].state[i].end;
-
-      /* compute the state end. */
-      state_add(E->threads[t].state,
-                E->threads[0].state,
-                E->G->n_order);
-    }
+  /* count the branching levels of the tree. */
+  unsigned int m = 0;
+  for (unsigned int i = 3; i < E->G->n_order; i++)
+    m += (E->threads[0].state[i].nb > 1 ? 1 : 0);
 
-    /* set the end state. */
-    for (unsigned int t = 1; t < E->nthreads; t++)
-      for (unsigned int i = 0; i < E->G->n_order; i++)
-        E->threads[t - 1].state[i].end = E->threads[t].state[i].idx;
+  /* allocate the branching level array, with room for a sentinel. */
+  free(E->levels);
+  E->levels = (unsigned int*) malloc((m + 1) * sizeof(unsigned int));
+  if (!E->levels)
+    throw("unable to allocate array of %u branching levels", m);
+
+  /* store the branching levels. the atoms of all other levels are either
+   * single-choice atoms that are embedded along with the nearest branching
+   * level above them, or duplicates that are never embedded at all.
+   */
+  E->n_levels = 0;
+  for (unsigned int i = 3; i < E->G->n_order; i++) {
+    if (E->threads[0].state[i].nb > 1)
+      E->levels[E->n_levels++] = i;
   }
 
-  /* set the end state to the problem size. */
-  for (unsigned int i = 0; i < E->G->n_order; i++) {
-    E->threads[E->nthreads - 1].state[i].end =
-    E->threads[E->nthreads - 1].state[i].nb - 1;
+  /* terminate the branching levels with the length of the order. */
+  E->levels[m] = E->G->n_order;
+
+  /* precompute the embedding constants of levels of fixed geometry. */
+  if (!enum_thread_geometry(E))
+    throw("unable to initialize embedding constants");
+
+  /* precompute the rigid fragments between the branching levels. */
+  if (!fragments_init(E))
+    throw("unable to initialize rigid fragments");
+
+  /* determine the number of leading branching levels (at least one)
+   * required to give every thread a sub-tree, and the sub-tree count.
+   */
+  unsigned long long ntree = 1;
+  unsigned int r = 0;
+  while (r < m && (!r || ntree < E->nthreads))
+    ntree *= E->threads[0].state[E->levels[r++]].nb;
+
+  E->n_split = r;
+
+  /* divide the sub-trees as evenly as possible among the threads. */
+  for (unsigned int t = 0; t < E->nthreads; t++) {
+    /* initialize the state indices. */
+    for (unsigned int i = 0; i < E->G->n_order; i++)
+      E->threads[t].state[i].idx = E->threads[t].state[i].end = 0;
+
+    /* store the first and one-past-last sub-trees of the thread. */
+    state_digits(E->threads[t].state, E->levels, r,
+                 ntree * t / E->nthreads, 0);
+    state_digits(E->threads[t].state, E->levels, r,
+                 ntree * (t + 1) / E->nthreads, 1);
   }
 
   /* set the start state to the initial index. */
@@ -406,6 +496,39 @@ int enum_threads_init (enum_t *E) {
     for (unsigned int i = 0; i < E->G->n_order; i++)
       E->threads[t].state[i].energy = 0.0;
 
+  /* initialize the first three atom positions of every thread. */
+  for (unsigned int t = 0; t < E->nthreads; t++)
+    enum_thread_frame(E->threads + t, 0);
+
+  /* seed the random number generators of every thread by passing the
+   * enumerator seed and thread index through a splitmix64 step.
+   */
+  for (unsigned int t = 0; t < E->nthreads; t++) {
+    unsigned long long z = (unsigned long long) E->seed
+                         + 0x9e3779b97f4a7c15ULL * (t + 1);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    z = z ^ (z >> 31);
+    E->threads[t].rng = (z ? z : 0x9e3779b97f4a7c15ULL);
+  }
+
+  /* allocate the contact grids of every thread, with all cells empty. */
+  for (unsigned int t = 0; E->cutoff > 0.0 && t < E->nthreads; t++) {
+    enum_thread_t *th = E->threads + t;
+    th->grid_head = (unsigned int*)
+      malloc((E->grid_sz + E->G->n_order) * sizeof(unsigned int) +
+             4 * E->G->n_order * sizeof(int));
+    if (!th->grid_head)
+      throw("unable to allocate contact grid");
+
+    th->grid_next = th->grid_head + E->grid_sz;
+    th->grid_cell = (int*) (th->grid_next + E->G->n_order);
+    for (unsigned int c = 0; c < E->grid_sz; c++)
+      th->grid_head[c] = E->G->n_order;
+
+    th->grid_n = th->grid_lim = 0;
+  }
+
   /* compute the tree size. */
   for (unsigned int i = 0; i < E->G->n_order; i++)
     E->logW += log10((double) E->threads[0].state[i].nb);
@@ -417,6 +540,120 @@ int enum_threads_init (enum_t *E) {
   return 1;
 }
 
+/* enum_thread_frame(): place the atoms of three consecutive levels of a
+ * thread into the canonical frame used to initialize every embedding.
+ * the first atom is placed at the origin, the second on the negative
+ * x-axis, and the third in the xy-plane with a positive y-coordinate.
+ *
+ * arguments:
+ *  @th: pointer to the thread to modify.
+ *  @lev: first level of the frame.
+ */
+void enum_thread_frame (enum_thread_t *th, const unsigned int lev) {
+  /* get references to the thread state and the order. */
+  enum_thread_node_t *state = th->state;
+  graph_t *G = th->E->G;
+  const unsigned int *order = G->order;
+
+  /* get the distances required to embed the three atoms. */
+  const double d01 = graph_get_edge_exact(G, order[lev], order[lev + 1]);
+  const double d02 = graph_get_edge_exact(G, order[lev], order[lev + 2]);
+  const double d12 = graph_get_edge_exact(G, order[lev + 1],
+                                             order[lev + 2]);
+
+  /* compute the cosine and sine of the angle formed by the atoms. */
+  const double ct = distances_to_angle(d01, d02, d12);
+  const double st = sqrt(1.0 - ct * ct);
+
+  /* place the atoms. */
+  vector_set(&state[lev].pos, 0.0, 0.0, 0.0);
+  vector_set(&state[lev + 1].pos, -d01, 0.0, 0.0);
+  vector_set(&state[lev + 2].pos, d12 * ct - d01, d12 * st, 0.0);
+  enum_thread_moved(th, lev);
+}
+
+/* enum_thread_moved(): note that the atoms of a thread at a given level
+ * and above have been moved by means other than embedding and feasibility
+ * checking, so that any data derived from their positions is refreshed.
+ *
+ * arguments:
+ *  @th: pointer to the thread to modify.
+ *  @lev: lowest level that has moved.
+ */
+void enum_thread_moved (enum_thread_t *th, const unsigned int lev) {
+  /* lower the limit of the filed levels of the contact grid. */
+  if (th->grid_lim > lev)
+    th->grid_lim = lev;
+
+  /* lower the limit of the single-precision positions. */
+  if (th->fpos_lim > lev)
+    th->fpos_lim = lev;
+}
+
+/* enum_thread_basis(): compute the orthonormal basis of the frame
+ * spanned by three atom positions. the first basis vector points from
+ * the first atom to the second, and the second lies in the plane of all
+ * three atoms, towards the third.
+ *
+ * arguments:
+ *  @x0, @x1, @x2: positions of the three atoms.
+ *  @u, @v, @w: output basis vectors.
+ */
+void enum_thread_basis (const vector_t *x0, const vector_t *x1,
+                        const vector_t *x2,
+                        vector_t *u, vector_t *v, vector_t *w) {
+  /* declare a scale factor. */
+  double f;
+
+  /* compute the first basis vector along x1 - x0. */
+  u->x = x1->x - x0->x;
+  u->y = x1->y - x0->y;
+  u->z = x1->z - x0->z;
+  f = 1.0 / sqrt(u->x * u->x + u->y * u->y + u->z * u->z);
+  u->x *= f;
+  u->y *= f;
+  u->z *= f;
+
+  /* compute the second basis vector from x2 - x0, orthogonal to u. */
+  v->x = x2->x - x0->x;
+  v->y = x2->y - x0->y;
+  v->z = x2->z - x0->z;
+  f = v->x * u->x + v->y * u->y + v->z * u->z;
+  v->x -= f * u->x;
+  v->y -= f * u->y;
+  v->z -= f * u->z;
+  f = 1.0 / sqrt(v->x * v->x + v->y * v->y + v->z * v->z);
+  v->x *= f;
+  v->y *= f;
+  v->z *= f;
+
+  /* compute the third basis vector. */
+  w->x = u->y * v->z - u->z * v->y;
+  w->y = u->z * v->x - u->x * v->z;
+  w->z = u->x * v->y - u->y * v->x;
+}
+
+/* enum_thread_random(): draw a uniformly distributed integer from the
+ * pseudorandom number generator (xorshift64*) of a thread.
+ *
+ * arguments:
+ *  @th: pointer to the thread that owns the generator.
+ *  @n: number of values in the output range.
+ *
+ * returns:
+ *  pseudorandom integer in the range [0,n-1].
+ */
+unsigned int enum_thread_random (enum_thread_t *th, unsigned int n) {
+  /* advance the generator state. */
+  th->rng ^= th->rng >> 12;
+  th->rng ^= th->rng << 25;
+  th->rng ^= th->rng >> 27;
+
+  /* scale the upper half of the scrambled state into the range. */
+  const unsigned long long r = (th->rng * 0x2545f4914f6cdd1dULL) >> 32;
+  return (unsigned int) ((r * (unsigned long long) n) >> 32);
+}
+
 /* enum_thread_feasible(): determine whether an enumeration tree node
  * is feasible or not.
  *
@@ -426,13 +663,20 @@ int enum_threads_init (enum_t *E) {
  * returns:
  *  integer indicating whether (1) or not (0) the atom is feasible.
  */
-static inline int enum_thread_feasible (enum_thread_t *th) {
+int enum_thread_feasible (enum_thread_t *th) {
   /* get local references to the pruning data. */
   enum_t *E = th->E;
   void **data = E->prune_data[th->level];
   enum_prune_test_fn *func = E->prune[th->level];
   const unsigned int n = E->prune_sz[th->level];
 
+  /* count the tested node. */
+  th->ntest++;
+
+  /* time every closure separately when profiling. */
+  if (th->prof)
+    return enum_prof_feasible(th);
+
   /* loop over the array of pruning function pointers. */
   for (unsigned int i = 0; i < n; i++) {
     /* return infeasible if any function returns a prune. */
@@ -503,6 +747,878 @@ static inline void enum_thread_lerp_index (const unsigned int i,
   *lerp = (N > 1 ? ((double) idx) / ((double) (N - 1)) : 0.5);
 }
 
+/* embed_omega(): compute the cosine and sine of the dihedral angle that
+ * places a new atom, based on a branch index into the discretized
+ * distance (or dihedral) between the first and the new atom.
+ *
+ * arguments:
+ *  @val03: edge between the first and the new atom.
+ *  @d01, @d02, @d12: distances between the three embedded atoms.
+ *  @d13, @d23: exact distances from the second and third atoms.
+ *  @rot: discrete dihedral values of the rotamers, or null to
+ *        interpolate over the edge.
+ *  @idx: branch index, or rotamer index, of the new atom.
+ *  @nb: number of branches of the new atom.
+ *  @cw, @sw: pointers to the output cosine and sine.
+ */
+static inline void embed_omega (value_t val03,
+                                const double d01,
+                                const double d02,
+                                const double d12,
+                                const double d13,
+                                const double d23,
+                                const double *rot,
+                                const unsigned int idx,
+                                const unsigned int nb,
+                                double *cw, double *sw) {
+  /* define the dihedral value and interpolation quantities. */
+  double d03, sig, lerp;
+
+  /* determine the cosine and sine of omega. */
+  if (rot) {
+    /* rotamer case: take the discrete dihedral of the branch. */
+    *cw = cos(rot[idx]);
+    *sw = sin(rot[idx]);
+  }
+  else if (value_is_dihedral(val03)) {
+    /* dihedral case: directly interpolate the cosine and sine. */
+    val03 = value_bound(value_scal(*val03.src, M_PI / 180.0),
+                        value_interval(-M_PI, M_PI));
+
+    /* compute the interpolation factor and the sign. */
+    enum_thread_lerp_index(idx, nb, 1, &sig, &lerp);
+
+    /* compute the current d(i,i-3) edge value. */
+    d03 = val03.l + (val03.u - val03.l) * lerp;
+
+    /* compute the cosine and sine of omega. */
+    *cw = cos(d03);
+    *sw = sin(d03);
+  }
+  else {
+    /* distance/angle case: determine the sign and
+     * interpolation factors from the value of the
+     * thread state index.
+     */
+    enum_thread_lerp_index(idx, nb, 0, &sig, &lerp);
+
+    /* compute the current d(i,i-3) edge value. */
+    d03 = val03.l + (val03.u - val03.l) * lerp;
+
+    /* compute the cosine and sine of omega. */
+    *cw = distances_to_dihedral(d01, d02, d03, d12, d13, d23);
+    *cw = (*cw < -1.0 ? -1.0 : *cw > 1.0 ? 1.0 : *cw);
+    *sw = sig * sqrt(1.0 - *cw * *cw);
+  }
+}
+
+/* embed_atom(): compute the position of an atom from the positions of
+ * three embedded atoms, based on a branch index into the discretized
+ * distance (or dihedral) between the first and the new atom.
+ *
+ * arguments:
+ *  @x0, @x1, @x2: positions of the three embedded atoms.
+ *  @val03: edge between the first and the new atom.
+ *  @d13, @d23: exact distances from the second and third atoms.
+ *  @rot: discrete dihedral values of the rotamers, or null to
+ *        interpolate over the edge.
+ *  @idx: branch index, or rotamer index, of the new atom.
+ *  @nb: number of branches of the new atom.
+ *
+ * returns:
+ *  position of the new atom.
+ */
+static inline vector_t embed_atom (const vector_t x0,
+                                   const vector_t x1,
+                                   const vector_t x2,
+                                   value_t val03,
+                                   const double d13,
+                                   const double d23,
+                                   const double *rot,
+                                   const unsigned int idx,
+                                   const unsigned int nb) {
+  /* define distances between the atoms. */
+  double d01, d02, d12;
+
+  /* define angular quantities for embedding the atom. */
+  double ct, st, cw, sw;
+
+  /* define vector quantities and extra scalars for embedding the atom. */
+  vector_t x3, r01, r02, r12, rv, p1, p2, p3;
+  double fp, fv, fd;
+
+  /* r01 = x1 - x0 == x_{i-2} - x_{i-3} */
+  r01.x = x1.x - x0.x;
+  r01.y = x1.y - x0.y;
+  r01.z = x1.z - x0.z;
+
+  /* r02 = x2 - x0 == x_{i-1} - x_{i-3} */
+  r02.x = x2.x - x0.x;
+  r02.y = x2.y - x0.y;
+  r02.z = x2.z - x0.z;
+
+  /* r12 = x2 - x1 == x_{i-1} - x_{i-2} */
+  r12.x = x2.x - x1.x;
+  r12.y = x2.y - x1.y;
+  r12.z = x2.z - x1.z;
+
+  /* rv = cross(r12, r01) */
+  rv.x = r12.y * r01.z - r12.z * r01.y;
+  rv.y = r12.z * r01.x - r12.x * r01.z;
+  rv.z = r12.x * r01.y - r12.y * r01.x;
+
+  /* fd = dot(r12, r01) */
+  fd = r12.x * r01.x + r12.y * r01.y + r12.z * r01.z;
+
+  /* compute distances between the previously embedded atoms. */
+  d01 = sqrt(r01.x * r01.x + r01.y * r01.y + r01.z * r01.z);
+  d02 = sqrt(r02.x * r02.x + r02.y * r02.y + r02.z * r02.z);
+  d12 = sqrt(r12.x * r12.x + r12.y * r12.y + r12.z * r12.z);
+
+  /* compute the cosine and sine of theta. */
+  ct = distances_to_angle(d12, d13, d23);
+  st = sqrt(1.0 - ct * ct);
+
+  /* determine the cosine and sine of omega. */
+  embed_omega(val03, d01, d02, d12, d13, d23, rot, idx, nb, &cw, &sw);
+
+  /* compute the scale factor for all p-vectors. */
+  fv = st / sqrt(rv.x * rv.x + rv.y * rv.y + rv.z * rv.z);
+  fp = -d23 / d12;
+
+  /* compute the first anchor position. */
+  p1.x = fp * ((ct + 1.0 / fp) * x2.x - ct * x1.x);
+  p1.y = fp * ((ct + 1.0 / fp) * x2.y - ct * x1.y);
+  p1.z = fp * ((ct + 1.0 / fp) * x2.z - ct * x1.z);
+
+  /* compute the second anchor position. */
+  fp *= fv;
+  p2.x = fp * (d12 * d12 * r01.x - fd * r12.x);
+  p2.y = fp * (d12 * d12 * r01.y - fd * r12.y);
+  p2.z = fp * (d12 * d12 * r01.z - fd * r12.z);
+
+  /* compute the third anchor position. */
+  p3.x = fp * d12 * rv.x;
+  p3.y = fp * d12 * rv.y;
+  p3.z = fp * d12 * rv.z;
+
+  /* compute the newly embedded atom position. */
+  x3.x = p1.x + cw * p2.x + sw * p3.x;
+  x3.y = p1.y + cw * p2.y + sw * p3.y;
+  x3.z = p1.z + cw * p2.z + sw * p3.z;
+
+  /* return the new position. */
+  return x3;
+}
+
+/* embed_atom_single(): compute the position of an atom from the positions
+ * of three embedded atoms in single precision. the arguments are those of
+ * embed_atom(), with positions given as floats relative to a common
+ * anchor, and the arithmetic of embed_atom() is repeated in floats.
+ *
+ * the rounding error of each embedding is of the order of 1e-7 times the
+ * distance to the anchor, which lies far below the ddf tolerance. leaves
+ * reached by single-precision traversal are re-embedded in double
+ * precision before they are accepted, so this error never reaches the
+ * output.
+ *
+ * arguments:
+ *  @x0, @x1, @x2: anchored positions of the three embedded atoms.
+ *  @x3: output anchored position of the new atom.
+ */
+static inline void embed_atom_single (const float *x0,
+                                      const float *x1,
+                                      const float *x2,
+                                      value_t val03,
+                                      const double d13,
+                                      const double d23,
+                                      const double *rot,
+                                      const unsigned int idx,
+                                      const unsigned int nb,
+                                      float *x3) {
+  /* define distances between the atoms, and the dihedral value. */
+  float d01, d02, d12, d03, e13, e23;
+
+  /* define angular quantities for embedding the atom. */
+  float ct, st, cw, sw, a, b, c;
+  double sig, lerp;
+
+  /* define vector quantities and extra scalars for embedding the atom. */
+  float r01[3], r02[3], r12[3], rv[3], y2[3], y1[3];
+  float fp, fv, fd;
+
+  /* store the atom positions relative to the first atom. */
+  for (unsigned int k = 0; k < 3; k++) {
+    y1[k] = r01[k] = x1[k] - x0[k];
+    y2[k] = r02[k] = x2[k] - x0[k];
+  }
+
+  /* r12 = x2 - x1 == x_{i-1} - x_{i-2} */
+  r12[0] = r02[0] - r01[0];
+  r12[1] = r02[1] - r01[1];
+  r12[2] = r02[2] - r01[2];
+
+  /* rv = cross(r12, r01) */
+  rv[0] = r12[1] * r01[2] - r12[2] * r01[1];
+  rv[1] = r12[2] * r01[0] - r12[0] * r01[2];
+  rv[2] = r12[0] * r01[1] - r12[1] * r01[0];
+
+  /* fd = dot(r12, r01) */
+  fd = r12[0] * r01[0] + r12[1] * r01[1] + r12[2] * r01[2];
+
+  /* compute distances between the previously embedded atoms. */
+  d01 = sqrtf(r01[0] * r01[0] + r01[1] * r01[1] + r01[2] * r01[2]);
+  d02 = sqrtf(r02[0] * r02[0] + r02[1] * r02[1] + r02[2] * r02[2]);
+  d12 = sqrtf(r12[0] * r12[0] + r12[1] * r12[1] + r12[2] * r12[2]);
+  e13 = (float) d13;
+  e23 = (float) d23;
+
+  /* compute the cosine and sine of theta. */
+  ct = (e23 * e23 + d12 * d12 - e13 * e13) / (2.0f * e23 * d12);
+  st = sqrtf(1.0f - ct * ct);
+
+  /* determine the cosine and sine of omega. */
+  if (rot) {
+    /* rotamer case: take the discrete dihedral of the branch. */
+    cw = cosf((float) rot[idx]);
+    sw = sinf((float) rot[idx]);
+  }
+  else if (value_is_dihedral(val03)) {
+    /* dihedral case: directly interpolate the cosine and sine. */
+    val03 = value_bound(value_scal(*val03.src, M_PI / 180.0),
+                        value_interval(-M_PI, M_PI));
+
+    /* compute the interpolation factor and the sign. */
+    enum_thread_lerp_index(idx, nb, 1, &sig, &lerp);
+
+    /* compute the current d(i,i-3) edge value. */
+    d03 = (float) (val03.l + (val03.u - val03.l) * lerp);
+
+    /* compute the cosine and sine of omega. */
+    cw = cosf(d03);
+    sw = sinf(d03);
+  }
+  else {
+    /* distance/angle case: determine the sign and
+     * interpolation factors from the value of the
+     * thread state index.
+     */
+    enum_thread_lerp_index(idx, nb, 0, &sig, &lerp);
+
+    /* compute the current d(i,i-3) edge value. */
+    d03 = (float) (val03.l + (val03.u - val03.l) * lerp);
+
+    /* compute the cosine and sine of omega, as distances_to_dihedral()
+     * does in double precision.
+     */
+    if (d03 == 0.0f) {
+      cw = 1.0f;
+    }
+    else {
+      a = 0.5f * (d01 * d01 + e13 * e13 - d03 * d03) / (d01 * e13);
+      b = 0.5f * (e13 * e13 + d12 * d12 - e23 * e23) / (e13 * d12);
+      c = 0.5f * (d01 * d01 + d12 * d12 - d02 * d02) / (d01 * d12);
+      cw = (a - b * c) / sqrtf((1.0f - b * b) * (1.0f - c * c));
+    }
+
+    cw = (cw < -1.0f ? -1.0f : cw > 1.0f ? 1.0f : cw);
+    sw = (float) sig * sqrtf(1.0f - cw * cw);
+  }
+
+  /* compute the scale factor for all p-vectors. */
+  fv = st / sqrtf(rv[0] * rv[0] + rv[1] * rv[1] + rv[2] * rv[2]);
+  fp = -e23 / d12;
+
+  /* compute the first anchor position, and add the second and third
+   * anchor positions scaled by the cosine and sine of omega.
+   */
+  a = fp * (ct + 1.0f / fp);
+  b = fp * ct;
+  c = fp * fv;
+  for (unsigned int k = 0; k < 3; k++)
+    y2[k] = a * y2[k] - b * y1[k]
+          + cw * c * (d12 * d12 * r01[k] - fd * r12[k])
+          + sw * c * d12 * rv[k];
+
+  /* store the new position, relative to the anchor. */
+  for (unsigned int k = 0; k < 3; k++)
+    x3[k] = x0[k] + y2[k];
+}
+
+/* embed_atom_fixed(): compute the position of an atom from the positions
+ * of three embedded atoms at a level of fixed geometry, whose embedding
+ * constants and branch dihedrals have been precomputed. no square roots
+ * or trigonometric functions are evaluated.
+ *
+ * arguments:
+ *  @x0, @x1, @x2: positions of the three embedded atoms.
+ *  @g: precomputed embedding constants of the level.
+ *  @idx: branch index, or rotamer index, of the new atom.
+ *
+ * returns:
+ *  position of the new atom.
+ */
+static inline vector_t embed_atom_fixed (const vector_t x0,
+                                         const vector_t x1,
+                                         const vector_t x2,
+                                         const enum_geom_t *g,
+                                         const unsigned int idx) {
+  /* get the cosine and sine of omega at the branch. */
+  const double cw = g->cs[2 * idx];
+  const double sw = g->cs[2 * idx + 1];
+
+  /* define vector quantities for embedding the atom. */
+  vector_t x3, r01, r12, rv;
+
+  /* r01 = x1 - x0 == x_{i-2} - x_{i-3} */
+  r01.x = x1.x - x0.x;
+  r01.y = x1.y - x0.y;
+  r01.z = x1.z - x0.z;
+
+  /* r12 = x2 - x1 == x_{i-1} - x_{i-2} */
+  r12.x = x2.x - x1.x;
+  r12.y = x2.y - x1.y;
+  r12.z = x2.z - x1.z;
+
+  /* rv = cross(r12, r01) */
+  rv.x = r12.y * r01.z - r12.z * r01.y;
+  rv.y = r12.z * r01.x - r12.x * r01.z;
+  rv.z = r12.x * r01.y - r12.y * r01.x;
+
+  /* combine the anchor positions, as in embed_atom(). */
+  x3.x = g->a * x2.x - g->b * x1.x + cw * (g->c * r01.x - g->d * r12.x)
+       + sw * g->f * rv.x;
+  x3.y = g->a * x2.y - g->b * x1.y + cw * (g->c * r01.y - g->d * r12.y)
+       + sw * g->f * rv.y;
+  x3.z = g->a * x2.z - g->b * x1.z + cw * (g->c * r01.z - g->d * r12.z)
+       + sw * g->f * rv.z;
+
+  /* return the new position. */
+  return x3;
+}
+
+/* enum_thread_geometry(): precompute the embedding constants of every
+ * level of an enumerator whose three preceeding atoms are separated by
+ * exact distances. at such levels, the angle of the new atom and the
+ * shape of the frame of its predecessors never change, and the dihedral
+ * of each branch is known in advance.
+ *
+ * arguments:
+ *  @E: pointer to the enumerator to modify.
+ *
+ * returns:
+ *  integer indicating whether (1) or not (0) the operation succeeded.
+ */
+int enum_thread_geometry (enum_t *E) {
+  /* get references to the graph and the branch counts. */
+  graph_t *G = E->G;
+  const unsigned int *order = G->order;
+  const enum_thread_node_t *state = E->threads[0].state;
+  const unsigned int len = G->n_order;
+
+  /* declare required variables:
+   *  @d01, @d02, @d12: exact distances between the predecessors.
+   *  @d13, @d23: exact distances from the new atom.
+   *  @ct, @st: cosine and sine of the angle of the new atom.
+   *  @fd, @fv, @fp: scalars of embed_atom().
+   *  @rv2: squared norm of the cross product of the frame.
+   *  @rot: discrete dihedral values of the level, if any.
+   *  @g: embedding constants of the current level.
+   *  @n: number of tabulated dihedrals of the level.
+   *  @nfix: number of levels of fixed geometry.
+   */
+  value_t e01, e02, e12;
+  double d01, d02, d12, d13, d23, ct, st, fd, fv, fp, rv2;
+  const double *rot;
+  enum_geom_t *g;
+  unsigned int lev, k, n, nfix;
+
+  /* release the constants of any earlier initialization. */
+  for (lev = 0; E->geom && lev < len; lev++)
+    free(E->geom[lev].cs);
+
+  free(E->geom);
+
+  /* allocate the array of embedding constants. */
+  E->geom = (enum_geom_t*) calloc(len, sizeof(enum_geom_t));
+  if (!E->geom)
+    throw("unable to allocate embedding constants");
+
+  /* loop over the levels that follow the initial frame. */
+  for (lev = 3, nfix = 0; lev < len; lev++) {
+    /* skip duplicate levels. */
+    if (G->orig[lev])
+      continue;
+
+    /* get the distances between the predecessors, and skip levels
+     * where any of them is not exact.
+     */
+    e01 = graph_get_edge(G, order[lev - 3], order[lev - 2]);
+    e02 = graph_get_edge(G, order[lev - 3], order[lev - 1]);
+    e12 = graph_get_edge(G, order[lev - 2], order[lev - 1]);
+    if (!value_is_scalar(e01) || !value_is_scalar(e02) ||
+        !value_is_scalar(e12))
+      continue;
+
+    /* get the exact distances of the new atom. */
+    d01 = e01.l;
+    d02 = e02.l;
+    d12 = e12.l;
+    d13 = graph_get_edge_exact(G, order[lev - 2], order[lev]);
+    d23 = graph_get_edge_exact(G, order[lev - 1], order[lev]);
+
+    /* compute the angle of the new atom, and the squared norm of the
+     * cross product of the frame, skipping degenerate frames.
+     */
+    ct = distances_to_angle(d12, d13, d23);
+    st = sqrt(1.0 - ct * ct);
+    fd = 0.5 * (d02 * d02 - d01 * d01 - d12 * d12);
+    rv2 = d01 * d01 * d12 * d12 - fd * fd;
+    if (!(rv2 > 0.0) || isnan(st))
+      continue;
+
+    /* compute the scalars of embed_atom(). */
+    fv = st / sqrt(rv2);
+    fp = -d23 / d12;
+
+    /* allocate the dihedral table of the level. */
+    g = E->geom + lev;
+    rot = (E->rot ? E->rot[lev] : NULL);
+    n = (rot ? E->n_rot[lev] : state[lev].nb);
+    g->cs = (double*) malloc(2 * n * sizeof(double));
+    if (!g->cs)
+      throw("unable to allocate dihedral table");
+
+    /* store the coefficients of the anchor positions. */
+    g->a = fp * ct + 1.0;
+    g->b = fp * ct;
+    g->c = fp * fv * d12 * d12;
+    g->d = fp * fv * fd;
+    g->f = fp * fv * d12;
+
+    /* tabulate the cosine and sine of omega at every branch. */
+    for (k = 0; k < n; k++)
+      embed_omega(graph_get_edge(G, order[lev - 3], order[lev]),
+                  d01, d02, d12, d13, d23, rot, k, state[lev].nb,
+                  g->cs + 2 * k, g->cs + 2 * k + 1);
+
+    nfix++;
+  }
+
+  /* output an informational message about the fixed levels. */
+  info("%u levels have fixed embedding geometry", nfix);
+
+  /* return success. */
+  return 1;
+}
+
+/* ENUM_SINGLE_ANCHOR: number of consecutive levels whose single-precision
+ * positions share an anchor. the first level of every run is embedded in
+ * double precision, which re-anchors the single-precision chain.
+ */
+#define ENUM_SINGLE_ANCHOR  16
+
+/* single_anchor(): get the anchor level of the single-precision position
+ * of a level, i.e. the first level of its run, resolved to its original.
+ */
+static inline unsigned int single_anchor (const unsigned int *dup,
+                                          const unsigned int lev) {
+  /* resolve the first level of the run. */
+  const unsigned int a = lev - lev % ENUM_SINGLE_ANCHOR;
+  return a - dup[a];
+}
+
+/* single_sync(): refresh the single-precision positions of a thread from
+ * its double-precision positions, up to a given level.
+ *
+ * arguments:
+ *  @th: pointer to the thread to modify.
+ *  @lev: one-past-last level to refresh.
+ */
+static void single_sync (enum_thread_t *th, const unsigned int lev) {
+  /* get references to the thread state and the duplicates. */
+  enum_thread_node_t *state = th->state;
+  const unsigned int *dup = th->E->G->orig;
+
+  /* store every moved original position relative to its anchor. */
+  for (unsigned int i = th->fpos_lim; i < lev; i++) {
+    if (dup[i])
+      continue;
+
+    const vector_t *a = &state[single_anchor(dup, i)].pos;
+    state[i].fpos[0] = (float) (state[i].pos.x - a->x);
+    state[i].fpos[1] = (float) (state[i].pos.y - a->y);
+    state[i].fpos[2] = (float) (state[i].pos.z - a->z);
+  }
+
+  /* mark the positions as refreshed. */
+  th->fpos_lim = lev;
+}
+
+/* single_load(): get the single-precision position of a level relative to
+ * a given anchor level, which may differ from the anchor of the level.
+ *
+ * arguments:
+ *  @state: pointer to the thread state.
+ *  @dup: duplicate offsets of the levels.
+ *  @lev: original level to load.
+ *  @anc: anchor level of the result.
+ *  @y: output anchored position.
+ */
+static inline void single_load (const enum_thread_node_t *state,
+                                const unsigned int *dup,
+                                const unsigned int lev,
+                                const unsigned int anc,
+                                float *y) {
+  /* get the anchor of the level. */
+  const unsigned int a = single_anchor(dup, lev);
+
+  /* copy positions that share the anchor. */
+  if (a == anc) {
+    y[0] = state[lev].fpos[0];
+    y[1] = state[lev].fpos[1];
+    y[2] = state[lev].fpos[2];
+    return;
+  }
+
+  /* shift other positions by the difference of the anchors. */
+  y[0] = state[lev].fpos[0] + (float) (state[a].pos.x - state[anc].pos.x);
+  y[1] = state[lev].fpos[1] + (float) (state[a].pos.y - state[anc].pos.y);
+  y[2] = state[lev].fpos[2] + (float) (state[a].pos.z - state[anc].pos.z);
+}
+
+/* embed_level(): embed the atom at a given level of a thread in single
+ * or double precision.
+ *
+ * arguments:
+ *  @th: pointer to the thread to modify.
+ *  @lev: level of the atom to embed, which must be at least three.
+ *  @single: whether or not to embed in single precision.
+ *
+ * returns:
+ *  integer indicating whether a new atom was embedded (1), or whether
+ *  the level is a duplicate (0).
+ */
+static inline int embed_level (enum_thread_t *th, const unsigned int lev,
+                               const int single) {
+  /* get references to the thread state and the graph. */
+  enum_thread_node_t *state = th->state;
+  graph_t *G = th->E->G;
+  const unsigned int *order = G->order;
+  const unsigned int *dup = G->orig;
+
+  /* duplicate atoms are held by their original levels. */
+  if (dup[lev])
+    return 0;
+
+  /* rotamer levels take the rotamer chosen at their first level. */
+  const double *rot = (th->E->rot ? th->E->rot[lev] : NULL);
+  const unsigned int idx = (rot ? state[th->E->rot_lead[lev]].idx
+                                : state[lev].idx);
+
+  /* get the positions of the predecessors, resolving duplicate atoms
+   * to their original levels, and the edges to the new atom.
+   */
+  const vector_t x0 = state[lev - 3 - dup[lev - 3]].pos;
+  const vector_t x1 = state[lev - 2 - dup[lev - 2]].pos;
+  const vector_t x2 = state[lev - 1 - dup[lev - 1]].pos;
+  const value_t val03 = graph_get_edge(G, order[lev - 3], order[lev]);
+  const double d13 = graph_get_edge_exact(G, order[lev - 2], order[lev]);
+  const double d23 = graph_get_edge_exact(G, order[lev - 1], order[lev]);
+
+  /* embed the atom from the single-precision positions of its
+   * predecessors, except at the anchor levels of the single-precision
+   * chain, which are embedded in double precision.
+   */
+  const int fp = th->E->single;
+  const unsigned int anc = (fp ? single_anchor(dup, lev) : lev);
+  if (single && anc != lev) {
+    float y0[3], y1[3], y2[3];
+    if (th->fpos_lim < lev)
+      single_sync(th, lev);
+
+    single_load(state, dup, lev - 3 - dup[lev - 3], anc, y0);
+    single_load(state, dup, lev - 2 - dup[lev - 2], anc, y1);
+    single_load(state, dup, lev - 1 - dup[lev - 1], anc, y2);
+    embed_atom_single(y0, y1, y2, val03, d13, d23, rot, idx,
+                      state[lev].nb, state[lev].fpos);
+
+    /* convert the position for the pruning closures. */
+    state[lev].pos.x = state[anc].pos.x + state[lev].fpos[0];
+    state[lev].pos.y = state[anc].pos.y + state[lev].fpos[1];
+    state[lev].pos.z = state[anc].pos.z + state[lev].fpos[2];
+    th->fpos_lim = lev + 1;
+    return 1;
+  }
+
+  /* embed in double precision, using the precomputed constants of
+   * levels of fixed geometry.
+   */
+  if (th->E->geom[lev].cs)
+    state[lev].pos = embed_atom_fixed(x0, x1, x2, th->E->geom + lev, idx);
+  else
+    state[lev].pos = embed_atom(x0, x1, x2, val03, d13, d23,
+                                rot, idx, state[lev].nb);
+
+  /* keep the single-precision position in step, if required. */
+  if (fp) {
+    if (th->fpos_lim < lev)
+      single_sync(th, lev);
+
+    state[lev].fpos[0] = (float) (state[lev].pos.x - state[anc].pos.x);
+    state[lev].fpos[1] = (float) (state[lev].pos.y - state[anc].pos.y);
+    state[lev].fpos[2] = (float) (state[lev].pos.z - state[anc].pos.z);
+    th->fpos_lim = lev + 1;
+  }
+
+  /* return that a new atom was embedded. */
+  return 1;
+}
+
+/* enum_thread_embed(): embed the atom at a given level of a thread,
+ * based on the current value of its state index and the positions of
+ * the three atoms that precede it in the order.
+ *
+ * arguments:
+ *  @th: pointer to the thread to modify.
+ *  @lev: level of the atom to embed, which must be at least three.
+ *
+ * returns:
+ *  integer indicating whether a new atom was embedded (1), or whether
+ *  the level is a duplicate whose position is held by its original
+ *  level (0). duplicates do not require feasibility checks.
+ */
+int enum_thread_embed (enum_thread_t *th, const unsigned int lev) {
+  /* embed in the precision of the traversal. */
+  return embed_level(th, lev, th->E->single);
+}
+
+/* enum_thread_embed_reverse(): embed the atom at a given level of a
+ * thread from the three atoms that follow it in the order, which must
+ * not be duplicates. the atom takes the branch of the level three below
+ * it, whose edge to the atom is discretized in the forward direction.
+ *
+ * arguments:
+ *  @th: pointer to the thread to modify.
+ *  @lev: level of the atom to embed.
+ */
+void enum_thread_embed_reverse (enum_thread_t *th, const unsigned int lev) {
+  /* get references to the thread state and the graph. */
+  enum_thread_node_t *state = th->state;
+  graph_t *G = th->E->G;
+  const unsigned int *order = G->order;
+
+  /* rotamer levels take the rotamer chosen at their first level. */
+  const double *rot = (th->E->rot ? th->E->rot[lev + 3] : NULL);
+  const unsigned int idx = (rot ? state[th->E->rot_lead[lev + 3]].idx
+                                : state[lev + 3].idx);
+
+  /* embed the atom from its successors. */
+  state[lev].pos =
+    embed_atom(state[lev + 3].pos, state[lev + 2].pos, state[lev + 1].pos,
+               graph_get_edge(G, order[lev], order[lev + 3]),
+               graph_get_edge_exact(G, order[lev + 2], order[lev]),
+               graph_get_edge_exact(G, order[lev + 1], order[lev]),
+               rot, idx, state[lev + 3].nb);
+}
+
+/* enum_thread_place(): place the atoms of a rigid fragment of a thread
+ * from their precomputed coordinates in the frame of the three levels
+ * that precede the fragment.
+ *
+ * arguments:
+ *  @th: pointer to the thread to modify.
+ *  @a: first level of the fragment.
+ *  @b: one-past-last level of the fragment.
+ */
+static inline void enum_thread_place (enum_thread_t *th,
+                                      const unsigned int a,
+                                      const unsigned int b) {
+  /* get references to the thread state and the fragment coordinates. */
+  enum_thread_node_t *state = th->state;
+  const unsigned int *dup = th->E->G->orig;
+  const vector_t *q = th->E->frag_pos;
+  vector_t u, v, w;
+
+  /* compute the frame basis, resolving duplicates. */
+  const vector_t x0 = state[a - 3 - dup[a - 3]].pos;
+  enum_thread_basis(&x0, &state[a - 2 - dup[a - 2]].pos,
+                         &state[a - 1 - dup[a - 1]].pos, &u, &v, &w);
+
+  /* transform the fragment coordinates into the thread frame. */
+  for (unsigned int lev = a; lev < b; lev++) {
+    state[lev].pos.x = x0.x + q[lev].x * u.x + q[lev].y * v.x
+                            + q[lev].z * w.x;
+    state[lev].pos.y = x0.y + q[lev].x * u.y + q[lev].y * v.y
+                            + q[lev].z * w.y;
+    state[lev].pos.z = x0.z + q[lev].x * u.z + q[lev].y * v.z
+                            + q[lev].z * w.z;
+  }
+
+  /* the single-precision positions of the fragment are refreshed from
+   * the placed positions when next required.
+   */
+  if (th->fpos_lim > a)
+    th->fpos_lim = a;
+}
+
+/* enum_thread_refine(): re-embed a leaf reached by single-precision
+ * traversal in double precision, and check every atom of the leaf once
+ * more against the distance bounds of its ddf closures. the check does
+ * not count as a node test of the thread or its closures, whose counts
+ * already hold the single-precision tests of the same atoms. the other
+ * closures are not repeated, as the re-embedded positions differ from
+ * their tested positions by rounding alone.
+ *
+ * arguments:
+ *  @th: pointer to the thread holding the leaf.
+ *
+ * returns:
+ *  integer indicating whether (1) or not (0) the leaf remains feasible.
+ */
+static int enum_thread_refine (enum_thread_t *th) {
+  /* get a reference to the length of the order. */
+  const unsigned int len = th->E->G->n_order;
+
+  /* loop over the levels that follow the initial frame. */
+  for (unsigned int lev = 3; lev < len; lev++) {
+    /* embed the atom in double precision. duplicates are skipped. */
+    if (!embed_level(th, lev, 0))
+      continue;
+
+    /* check the distance bounds of the re-embedded atom. */
+    th->level = lev;
+    if (!enum_prune_ddf_valid(th->E, th))
+      return 0;
+  }
+
+  /* return feasible. */
+  return 1;
+}
+
+/* enum_thread_solution(): handle a feasible leaf of the tree, i.e. a
+ * complete candidate solution held in the state of a thread. candidates
+ * that pass the rmsd-step and energy tests are counted and written.
+ *
+ * arguments:
+ *  @th: pointer to the thread holding the candidate solution.
+ *
+ * returns:
+ *  integer indicating whether (1) or not (0) the candidate was handled
+ *  without errors. rejected candidates are not errors.
+ */
+int enum_thread_solution (enum_thread_t *th) {
+  /* get references to the thread state, enumerator and graph. */
+  enum_thread_node_t *state = th->state;
+  enum_t *E = th->E;
+  graph_t *G = E->G;
+
+  /* get a reference to the length of the order. */
+  const unsigned int len = G->n_order;
+  const unsigned int *dup = G->orig;
+
+  /* get the final non-duplicate level, which holds the energy summed over
+   * every embedded level.
+   */
+  unsigned int last = len - 1;
+  while (last && dup[last])
+    last--;
+
+  /* declare variables for centering the structure. */
+  vector_t x0;
+  double fp;
+
+  /* reject leaves of single-precision traversal that turn out to be
+   * infeasible in double precision.
+   */
+  if (E->single && !enum_thread_refine(th)) {
+    E->nrej++;
+    return 1;
+  }
+
+  /* compute the center of the structure. */
+  x0.x = x0.y = x0.z = 0.0;
+  for (unsigned int i = 0; i < len; i++) {
+    if (!dup[i]) {
+      x0.x += state[i].pos.x;
+      x0.y += state[i].pos.y;
+      x0.z += state[i].pos.z;
+    }
+  }
+
+  /* scale the computed mean value. */
+  fp = 1.0 / ((double) G->n_orig);
+  x0.x *= fp;
+  x0.y *= fp;
+  x0.z *= fp;
+
+  /* center the coordinates of the current candidate solution. */
+  for (unsigned int i = 0; i < len; i++) {
+    state[i].pos.x -= x0.x;
+    state[i].pos.y -= x0.y;
+    state[i].pos.z -= x0.z;
+  }
+
+  enum_thread_moved(th, 0);
+
+  /* reject if:
+   *  1. the rmsd-step of the candidate solution is too low.
+   *  2. the energy of the candidate solution is too high.
+   */
+  if (state_rmsd(G, state) < E->rmsd_tol ||
+      state[last].energy > E->energy_tol) {
+    E->nrej++;
+    return 1;
+  }
+
+  /* store the new solution into the "previous" slot. */
+  for (unsigned int i = 0; i < len; i++)
+    state[i].prev = state[i].pos;
+
+#ifdef __IBP_HAVE_PTHREAD
+  /* obtain a lock on the write mutex. */
+  pthread_mutex_lock(&E->write_mutex);
+#endif
+
+  /* do not exceed the solution limit if another thread reached it. */
+  if (E->nmax && E->nsol >= E->nmax) {
+#ifdef __IBP_HAVE_PTHREAD
+    pthread_mutex_unlock(&E->write_mutex);
+#endif
+    return 1;
+  }
+
+  /* increment the solution count. random probing keeps the energy
+   * tolerance fixed, so that samples are not forced downhill.
+   */
+  E->nsol++;
+  if (!E->nsample)
+    E->energy_tol = state[last].energy;
+
+  /* write some output. */
+  info("solution %u found, U = %.32le",
+       E->nsol, state[last].energy);
+
+  /* write the solution. */
+  if (E->write_data && !E->write_data(E, th)) {
+#ifdef __IBP_HAVE_PTHREAD
+    /* unlock the write mutex. */
+    pthread_mutex_unlock(&E->write_mutex);
+#endif
+
+    /* raise an exception and return failure. */
+    throw("failed to write solution %u", E->nsol);
+  }
+
+#ifdef __IBP_HAVE_PTHREAD
+  /* unlock the write mutex. */
+  pthread_mutex_unlock(&E->write_mutex);
+#endif
+
+  /* return success. */
+  return 1;
+}
+
 /* enum_thread_timer(): timer thread function for enumeration timing
  * information.
  *
@@ -517,6 +1633,9 @@ void *enum_thread_timer (void *pdata) {
   const unsigned int nt = E->nthreads;
   const unsigned int len = E->G->n_order;
 
+  /* determine whether the threads traverse in index order. */
+  const int dfs = (E->thread_fn == enum_thread_execute);
+
   /* initialize the timer. */
   unsigned int last_nsol = 0;
   double t = 0.0, dt = 1.0;
@@ -530,8 +1649,10 @@ void *enum_thread_timer (void *pdata) {
     /* start outputting timing information. */
     info("elapsed time: %.0lf min.", t);
 
-    /* compute the log-width of each thread. */
-    for (unsigned int tid = 0; tid < nt; tid++) {
+    /* compute the log-width of each thread, which is only meaningful
+     * for the depth-first traversal.
+     */
+    for (unsigned int tid = 0; tid < nt && dfs; tid++) {
       /* compute the thread width. */
       double L1 = 0.0;
       double L2 = 0.0;
@@ -560,262 +1681,189 @@ void *enum_thread_timer (void *pdata) {
   return NULL;
 }
 
-/* enum_thread_execute(): core thread function for enumerator threads.
+/* enum_thread_step(): embed and feasibility-check the atoms of a range
+ * of levels, stopping at the first infeasible atom.
  *
  * arguments:
- *  @pdata: pointer to the current enumerator thread data structure.
+ *  @th: pointer to the thread to modify.
+ *  @lev: first level of the range.
+ *  @next: one-past-last level of the range.
+ *
+ * returns:
+ *  integer indicating whether (1) or not (0) all atoms were feasible.
  */
-void *enum_thread_execute (void *pdata) {
-  /* get references to the current thread data. */
-  enum_thread_t *thread = (enum_thread_t*) pdata;
-  enum_thread_node_t *state = thread->state;
-  graph_t *G = thread->E->G;
-  enum_t *E = thread->E;
+int enum_thread_step (enum_thread_t *th, const unsigned int lev,
+                      const unsigned int next) {
+  /* get a reference to the rigid fragment ends. */
+  const unsigned int *frag = th->E->frag;
+
+  /* loop over the levels of the range. */
+  for (unsigned int i = lev; i < next; i++) {
+    /* place rigid fragments that lie within the range at once. */
+    if (frag[i] && frag[i] <= next) {
+      enum_thread_place(th, i, frag[i]);
+
+      /* check feasibility of each atom of the fragment. */
+      for (unsigned int j = i; j < frag[i]; j++) {
+        th->level = j;
+        if (!enum_thread_feasible(th))
+          return 0;
+      }
 
-  /* get a reference to the length of the order. */
-  const unsigned int len = G->n_order;
-  const unsigned int *dup = G->orig;
-  unsigned int lev = thread->level;
+      /* resume after the fragment. */
+      i = frag[i] - 1;
+      continue;
+    }
 
-  /* get the distances required to embed the first three atoms. */
-  double d01 = graph_get_edge_exact(G, G->order[0], G->order[1]);
-  double d02 = graph_get_edge_exact(G, G->order[0], G->order[2]);
-  double d12 = graph_get_edge_exact(G, G->order[1], G->order[2]);
+    /* embed the atom. duplicate atoms are skipped. */
+    if (!enum_thread_embed(th, i))
+      continue;
 
-  /* define distances to each newly embedded atom. */
-  double d03, d13, d23;
-  value_t val03;
+    /* check feasibility of the newly embedded atom. */
+    th->level = i;
+    if (!enum_thread_feasible(th))
+      return 0;
+  }
 
-  /* compute the cosine and sine of the angle formed by the atoms. */
-  double ct = distances_to_angle(d01, d02, d12);
-  double st = sqrt(1.0 - ct * ct);
+  /* return feasible. */
+  return 1;
+}
 
-  /* define dihedral angular quantities for embedding atoms. */
-  double cw, sw, sig, lerp;
+/* enum_thread_traverse(): perform a depth-first traversal of the levels
+ * of a thread, from the current state indices of its branching levels up
+ * to (but excluding) their end indices.
+ *
+ * each step of the traversal embeds the atom of a branching level, along
+ * with the single-choice atoms that follow it. the traversal is cut off
+ * once the node tests of the thread reach its node limit, if any.
+ *
+ * arguments:
+ *  @th: pointer to the thread to traverse.
+ *  @lv: array of branching levels to traverse, followed by the
+ *       one-past-last level of the traversal.
+ *  @m: number of branching levels in @lv.
+ *  @lev: first level of the traversal.
+ *  @leaf: function to call on every feasible leaf.
+ *
+ * returns:
+ *  integer indicating whether (1) or not (0) every leaf was handled
+ *  without errors.
+ */
+int enum_thread_traverse (enum_thread_t *th,
+                          const unsigned int *lv,
+                          const unsigned int m,
+                          const unsigned int lev,
+                          enum_thread_leaf_fn leaf) {
+  /* get references to the thread state and enumerator. */
+  enum_thread_node_t *state = th->state;
+  enum_t *E = th->E;
+  unsigned int k = 0;
 
-  /* define vector quantities and extra scalars for embedding atoms. */
-  vector_t x0, x1, x2, x3, r01, r02, r12, rv, p1, p2, p3;
-  double fp, fv, fd;
+  /* embed the single-choice atoms that precede all branching. */
+  if (!enum_thread_step(th, lev, lv[0]))
+    return 1;
 
-  /* initialize the first three atom positions. */
-  vector_set(&state[0].pos, 0.0, 0.0, 0.0);
-  vector_set(&state[1].pos, -d01, 0.0, 0.0);
-  vector_set(&state[2].pos, d12 * ct - d01, d12 * st, 0.0);
+  /* handle traversals without branching as a single leaf. */
+  if (m == 0)
+    return leaf(th);
 
   /* loop over the set of states apportioned to the thread. */
-  while (state_valid(state, len)) {
+  while (state_valid(state, lv, m)) {
     /* check if we should terminate enumeration. */
     if (E->term)
-      return NULL;
+      return 1;
 
     /* check if we've computed enough solutions. */
     if (E->nmax && E->nsol >= E->nmax)
-      return NULL;
+      return 1;
 
-    /* embed all modified atoms in the state. */
-    while (lev < len) {
-      /* do not attempt to embed the first three atoms. */
-      if (lev < 3)
-        lev = 3;
-
-      /* check for duplicate atoms. */
-      if (dup[lev]) {
-        /* store the previously computed position, and move on. */
-        state[lev].pos = state[lev - dup[lev]].pos;
-        state[lev].energy = state[lev - dup[lev]].energy;
-        lev++; continue;
-      }
-
-      /* pull some embedded atom positions into local variables. */
-      x0 = state[lev - 3].pos;
-      x1 = state[lev - 2].pos;
-      x2 = state[lev - 1].pos;
-
-      /* r01 = x1 - x0 == x_{i-2} - x_{i-3} */
-      r01.x = x1.x - x0.x;
-      r01.y = x1.y - x0.y;
-      r01.z = x1.z - x0.z;
-
-      /* r02 = x2 - x0 == x_{i-1} - x_{i-3} */
-      r02.x = x2.x - x0.x;
-      r02.y = x2.y - x0.y;
-      r02.z = x2.z - x0.z;
-
-      /* r12 = x2 - x1 == x_{i-1} - x_{i-2} */
-      r12.x = x2.x - x1.x;
-      r12.y = x2.y - x1.y;
-      r12.z = x2.z - x1.z;
-
-      /* rv = cross(r12, r01) */
-      rv.x = r12.y * r01.z - r12.z * r01.y;
-      rv.y = r12.z * r01.x - r12.x * r01.z;
-      rv.z = r12.x * r01.y - r12.y * r01.x;
-
-      /* fd = dot(r12, r01) */
-      fd = r12.x * r01.x + r12.y * r01.y + r12.z * r01.z;
-
-      /* compute distances between the previously embedded atoms. */
-      d01 = sqrt(r01.x * r01.x + r01.y * r01.y + r01.z * r01.z);
-      d02 = sqrt(r02.x * r02.x + r02.y * r02.y + r02.z * r02.z);
-      d12 = sqrt(r12.x * r12.x + r12.y * r12.y + r12.z * r12.z);
-
-      /* obtain distances to the atom to be embedded. */
-      val03 = graph_get_edge(G, G->order[lev - 3], G->order[lev]);
-      d13 = graph_get_edge_exact(G, G->order[lev - 2], G->order[lev]);
-      d23 = graph_get_edge_exact(G, G->order[lev - 1], G->order[lev]);
-
-      /* compute the cosine and sine of theta. */
-      ct = distances_to_angle(d12, d13, d23);
-      st = sqrt(1.0 - ct * ct);
-
-      /* determine the cosine and sine of omega. */
-      if (value_is_dihedral(val03)) {
-        /* dihedral case: directly interpolate the cosine and sine. */
-        val03 = value_bound(value_scal(*val03.src, M_PI / 180.0),
-                            value_interval(-M_PI, M_PI));
-
-        /* compute the interpolation factor and the sign. */
-        enum_thread_lerp_index(state[lev].idx, state[lev].nb, 1,
-                               &sig, &lerp);
-
-        /* compute the current d(i,i-3) edge value. */
-        d03 = val03.l + (val03.u - val03.l) * lerp;
-
-        /* compute the cosine and sine of omega. */
-        cw = cos(d03);
-        sw = sin(d03);
-      }
-      else {
-        /* distance/angle case: determine the sign and
-         * interpolation factors from the value of the
-         * thread state index.
-         */
-        enum_thread_lerp_index(state[lev].idx, state[lev].nb, 0,
-                               &sig, &lerp);
-
-        /* compute the current d(i,i-3) edge value. */
-        d03 = val03.l + (val03.u - val03.l) * lerp;
+    /* check if the node budget of the thread is spent. */
+    if (th->nlim && th->ntest >= th->nlim)
+      return 1;
 
-        /* compute the cosine and sine of omega. */
-        cw = distances_to_dihedral(d01, d02, d03, d12, d13, d23);
-        cw = (cw < -1.0 ? -1.0 : cw > 1.0 ? 1.0 : cw);
-        sw = sig * sqrt(1.0 - cw * cw);
-      }
+    /* publish the state into any requested snapshot. */
+    if (th->snap_seen != E->snap)
+      enum_snap_publish(th);
 
-      /* compute the scale factor for all p-vectors. */
-      fv = st / sqrt(rv.x * rv.x + rv.y * rv.y + rv.z * rv.z);
-      fp = -d23 / d12;
-
-      /* compute the first anchor position. */
-      p1.x = fp * ((ct + 1.0 / fp) * x2.x - ct * x1.x);
-      p1.y = fp * ((ct + 1.0 / fp) * x2.y - ct * x1.y);
-      p1.z = fp * ((ct + 1.0 / fp) * x2.z - ct * x1.z);
-
-      /* compute the second anchor position. */
-      fp *= fv;
-      p2.x = fp * (d12 * d12 * r01.x - fd * r12.x);
-      p2.y = fp * (d12 * d12 * r01.y - fd * r12.y);
-      p2.z = fp * (d12 * d12 * r01.z - fd * r12.z);
-
-      /* compute the third anchor position. */
-      p3.x = fp * d12 * rv.x;
-      p3.y = fp * d12 * rv.y;
-      p3.z = fp * d12 * rv.z;
-
-      /* compute and store the newly embedded atom position. */
-      x3.x = p1.x + cw * p2.x + sw * p3.x;
-      x3.y = p1.y + cw * p2.y + sw * p3.y;
-      x3.z = p1.z + cw * p2.z + sw * p3.z;
-      state[lev].pos = x3;
-
-      /* check feasibility of the newly embedded atom. */
-      thread->level = lev;
-      if (!enum_thread_feasible(thread)) {
+    /* embed all modified atoms in the state. */
+    while (k < m) {
+      /* embed and check the atoms of the step. */
+      if (!enum_thread_step(th, lv[k], lv[k + 1])) {
         /* infeasible:
          *  1. skip all sub-trees of the infeasible atom/node.
          *  2. move back into the loop without incrementing.
          */
-        lev = state_increment(state, len, lev);
+        k = state_increment(state, lv, m, k);
         goto infeasible;
       }
 
       /* check if the atom is feasible and terminal. */
-      if (lev == len - 1) {
-        /* compute the center of the structure. */
-        x0.x = x0.y = x0.z = 0.0;
-        for (unsigned int i = 0; i < len; i++) {
-          if (!dup[i]) {
-            x0.x += state[i].pos.x;
-            x0.y += state[i].pos.y;
-            x0.z += state[i].pos.z;
-          }
-        }
-
-        /* scale the computed mean value. */
-        fp = 1.0 / ((double) G->n_orig);
-        x0.x *= fp;
-        x0.y *= fp;
-        x0.z *= fp;
-
-        /* center the coordinates of the current candidate solution. */
-        for (unsigned int i = 0; i < len; i++) {
-          state[i].pos.x -= x0.x;
-          state[i].pos.y -= x0.y;
-          state[i].pos.z -= x0.z;
-        }
-
-        /* break if:
-         *  1. the rmsd-step of the candidate solution is too low.
-         *  2. the energy of the candidate solution is too high.
-         */
-        if (state_rmsd(G, state) < E->rmsd_tol ||
-            state[len - 1].energy > E->energy_tol) {
-          E->nrej++;
-          break;
-        }
-
-        /* store the new solution into the "previous" slot. */
-        for (unsigned int i = 0; i < len; i++)
-          state[i].prev = state[i].pos;
-
-#ifdef __IBP_HAVE_PTHREAD
-        /* obtain a lock on the write mutex. */
-        pthread_mutex_lock(&E->write_mutex);
-#endif
-
-        /* increment the solution count. */
-        E->nsol++;
-        E->energy_tol = state[len - 1].energy;
-
-        /* write some output. */
-        info("solution %u found, U = %.32le",
-             E->nsol, E->energy_tol);
-
-        /* write the solution. */
-        if (E->write_data && !E->write_data(E, thread)) {
-          /* raise an exception and end thread execution. */
-          raise("failed to write solution %u", E->nsol);
-          return NULL;
-        }
-
-#ifdef __IBP_HAVE_PTHREAD
-        /* unlock the write mutex. */
-        pthread_mutex_unlock(&E->write_mutex);
-#endif
-      }
+      if (k == m - 1 && !leaf(th))
+        return 0;
 
       /* move down a level. */
-      lev++;
+      k++;
     }
 
     /* increment the state. */
-    lev = state_increment(state, len, len - 1);
+    k = state_increment(state, lv, m, m - 1);
 
 /* causes the thread to re-enter the level loop without an increment. */
 infeasible:;
   }
 
+  /* return success. */
+  return 1;
+}
+
+/* enum_thread_path(): embed the single path of a thread that is given by
+ * the current state indices of its branching levels.
+ *
+ * arguments:
+ *  @th: pointer to the thread to embed.
+ *
+ * returns:
+ *  integer indicating whether (1) or not (0) every atom of the path is
+ *  feasible.
+ */
+int enum_thread_path (enum_thread_t *th) {
+  /* get a reference to the branching levels. */
+  const unsigned int *lv = th->E->levels;
+  const unsigned int m = th->E->n_levels;
+
+  /* embed the single-choice atoms that precede all branching. */
+  if (!enum_thread_step(th, 3, lv[0]))
+    return 0;
+
+  /* embed each branching level along with its single-choice atoms. */
+  for (unsigned int k = 0; k < m; k++) {
+    if (!enum_thread_step(th, lv[k], lv[k + 1]))
+      return 0;
+  }
+
+  /* return feasible. */
+  return 1;
+}
+
+/* enum_thread_execute(): core thread function for enumerator threads.
+ *
+ * arguments:
+ *  @pdata: pointer to the current enumerator thread data structure.
+ */
+void *enum_thread_execute (void *pdata) {
+  /* get references to the current thread data. */
+  enum_thread_t *thread = (enum_thread_t*) pdata;
+  enum_t *E = thread->E;
+
+  /* trees without branching are handled by the first thread only. */
+  if (E->n_levels == 0 && (thread != E->threads || E->G->n_order <= 3))
+    return NULL;
+
+  /* traverse the tree apportioned to the thread. */
+  if (!enum_thread_traverse(thread, E->levels, E->n_levels, 3,
+                            enum_thread_solution))
+    raise("failed to handle solution");
+
   /* end thread execution. */
   return NULL;
 }
-
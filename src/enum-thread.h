@@ -2,11 +2,120 @@
 /* ensure once-only inclusion. */
 #pragma once
 
+/* enum_thread_leaf_fn: function pointer specification for handling the
+ * feasible leaves reached by a depth-first traversal of a thread.
+ *
+ * arguments:
+ *  @th: pointer to the thread holding the leaf.
+ *
+ * returns:
+ *  integer indicating whether (1) or not (0) the leaf was handled
+ *  without errors.
+ */
+typedef int (*enum_thread_leaf_fn) (enum_thread_t *th);
+
 /* function declarations (enum-thread.c): */
 
 int enum_threads_init (enum_t *E);
 
+int enum_thread_geometry (enum_t *E);
+
+void enum_thread_frame (enum_thread_t *th, const unsigned int lev);
+
+void enum_thread_moved (enum_thread_t *th, const unsigned int lev);
+
+void enum_thread_basis (const vector_t *x0, const vector_t *x1,
+                        const vector_t *x2,
+                        vector_t *u, vector_t *v, vector_t *w);
+
+unsigned int enum_thread_random (enum_thread_t *th, unsigned int n);
+
+int enum_thread_embed (enum_thread_t *th, const unsigned int lev);
+
+void enum_thread_embed_reverse (enum_thread_t *th, const unsigned int lev);
+
+int enum_thread_feasible (enum_thread_t *th);
+
+int enum_thread_solution (enum_thread_t *th);
+
+int enum_thread_step (enum_thread_t *th, const unsigned int lev,
+                      const unsigned int next);
+
+int enum_thread_traverse (enum_thread_t *th,
+                          const unsigned int *lv,
+                          const unsigned int m,
+                          const unsigned int lev,
+                          enum_thread_leaf_fn leaf);
+
+int enum_thread_path (enum_thread_t *th);
+
 void *enum_thread_timer (void *pdata);
 
 void *enum_thread_execute (void *pdata);
 
+/* function declarations (enum-sample.c): */
+
+void *enum_thread_sample (void *pdata);
+
+void *enum_thread_restart (void *pdata);
+
+/* function declarations (enum-snap.c): */
+
+void enum_snap_publish (enum_thread_t *th);
+
+void enum_snap_leave (enum_thread_t *th);
+
+int enum_snap_resume (enum_t *E, const char *fname);
+
+/* function declarations (enum-replay.c): */
+
+int enum_replay_selected (const char *sel, const unsigned int i);
+
+int enum_replay_init (enum_t *E);
+
+void *enum_thread_replay (void *pdata);
+
+/* function declarations (enum-lds.c): */
+
+void *enum_thread_lds (void *pdata);
+
+/* function declarations (enum-estimate.c): */
+
+void *enum_thread_estimate (void *pdata);
+
+void enum_estimate_report (enum_t *E);
+
+/* function declarations (enum-auto.c): */
+
+int enum_auto_init (enum_t *E, opts_t *opts);
+
+/* function declarations (enum-prof.c): */
+
+int enum_prof_init (enum_t *E);
+
+int enum_prof_feasible (enum_thread_t *th);
+
+void enum_prof_sum (enum_t *E, unsigned int k, enum_prof_t *sum);
+
+double enum_prof_hz (enum_t *E);
+
+int enum_prof_report (enum_t *E);
+
+void enum_prof_free (enum_t *E);
+
+
+/* function declarations (enum-block.c): */
+
+int enum_block_separable (enum_t *E);
+
+int enum_blocks_init (enum_t *E);
+
+void *enum_thread_blocks (void *pdata);
+
+/* function declarations (enum-meet.c): */
+
+int enum_meet_init (enum_t *E);
+
+void enum_meet_free (enum_t *E);
+
+void *enum_thread_meet (void *pdata);
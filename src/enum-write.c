@@ -2,6 +2,7 @@
 /* include the enumerator headers. */
 #include "enum.h"
 #include "enum-thread.h"
+#include "enum-write.h"
 
 /* all functions defined in this source file must follow the function
  * pointer specifications outlined for enumerator output writing systems.
@@ -249,3 +250,183 @@ int enum_write_pdb (enum_t *E, enum_thread_t *th) {
   return 1;
 }
 
+
+/* * * * * * * * * * * * * * PATH: * * * * * * * * * * * * * */
+
+/* the path output format stores each solution as the state indices of
+ * its branching levels, packed into the fewest bits that hold the branch
+ * count of each level, followed by the energy of the solution as a
+ * float. the header records the shape of the tree, which must match the
+ * tree of the enumerator that reconstructs the solutions.
+ *
+ * for more details, consult:
+ *  - enum_replay_init() in enum-replay.c
+ */
+
+/* enum_write_path_open(): called to open a path output system.
+ */
+int enum_write_path_open (enum_t *E) {
+  /* declare required variables:
+   *  @fd: temporary file descriptor.
+   *  @ibuf: integer data buffer.
+   *  @k: branching level index.
+   */
+  unsigned int k, bits;
+  int fd, ibuf[3];
+
+  /* only depth-first traversals keep a complete state index path. */
+  if (E->thread_fn == enum_thread_blocks ||
+      E->thread_fn == enum_thread_meet)
+    throw("path output requires a depth-first traversal mode");
+
+  /* allocate the bit counts of the branching levels. */
+  E->path_bits = (unsigned int*)
+    malloc((E->n_levels + 1) * sizeof(unsigned int));
+
+  /* check if allocation failed. */
+  if (!E->path_bits)
+    throw("unable to allocate path bit counts");
+
+  /* compute the number of bits required at each branching level. */
+  for (k = 0, bits = 0; k < E->n_levels; k++) {
+    E->path_bits[k] = 0;
+    while ((1U << E->path_bits[k]) < E->threads[0].state[E->levels[k]].nb)
+      E->path_bits[k]++;
+
+    bits += E->path_bits[k];
+  }
+
+  /* store the number of bytes of each packed path. */
+  E->path_sz = (bits + 7) / 8;
+
+  /* attempt to open the output file. */
+  fd = open(E->fname, O_CREAT | O_TRUNC | O_WRONLY,
+            S_IRUSR | S_IWUSR | S_IRGRP | S_IWGRP | S_IROTH);
+
+  /* check if the file failed to open. */
+  if (fd < 0)
+    throw("unable to open file '%s'", E->fname);
+
+  /* success! store the file descriptor. */
+  E->fd = fd;
+
+  /* write the magic string and the tree dimensions. */
+  ibuf[0] = E->G->n_order;
+  ibuf[1] = E->G->n_orig;
+  ibuf[2] = E->n_levels;
+  write(E->fd, ENUM_PATH_MAGIC, 8 * sizeof(char));
+  write(E->fd, ibuf, 3 * sizeof(int));
+
+  /* write the branching levels and their branch counts. */
+  for (k = 0; k < E->n_levels; k++) {
+    ibuf[0] = E->levels[k];
+    ibuf[1] = E->threads[0].state[E->levels[k]].nb;
+    write(E->fd, ibuf, 2 * sizeof(int));
+  }
+
+  /* output an informational message. */
+  info("writing %u-byte branch paths to '%s'", E->path_sz, E->fname);
+
+  /* return success. */
+  return 1;
+}
+
+/* enum_write_path_close(): called to close a path output system.
+ */
+void enum_write_path_close (enum_t *E) {
+  /* close the file descriptor. */
+  if (E->fd >= 0)
+    close(E->fd);
+
+  /* re-init the file descriptor. */
+  E->fd = -1;
+
+  /* free the bit counts. */
+  free(E->path_bits);
+  E->path_bits = NULL;
+}
+
+/* enum_write_path_pack(): pack the state indices of the branching levels
+ * of a solution into the fewest bits that hold each branch count, least
+ * significant bits first.
+ *
+ * arguments:
+ *  @idx: state index at each branching level.
+ *  @bits: number of bits of the state index of each branching level.
+ *  @m: number of branching levels.
+ *  @buf: output buffer, which must hold every packed bit.
+ */
+void enum_write_path_pack (const unsigned int *idx, const unsigned int *bits,
+                           const unsigned int m, unsigned char *buf) {
+  /* declare required variables:
+   *  @pos: bit position of the next packed index.
+   */
+  unsigned int k, b, pos;
+
+  /* clear the bytes of the packed path. */
+  for (k = 0, pos = 0; k < m; k++)
+    pos += bits[k];
+
+  memset(buf, 0, (pos + 7) / 8);
+
+  /* pack the bits of every index. */
+  for (k = 0, pos = 0; k < m; k++) {
+    for (b = 0; b < bits[k]; b++, pos++)
+      buf[pos / 8] |= ((idx[k] >> b) & 1) << (pos % 8);
+  }
+}
+
+/* enum_write_path_unpack(): unpack the state indices of the branching
+ * levels of a solution packed by enum_write_path_pack().
+ *
+ * arguments:
+ *  @buf: packed path buffer.
+ *  @bits: number of bits of the state index of each branching level.
+ *  @m: number of branching levels.
+ *  @idx: output state index at each branching level.
+ */
+void enum_write_path_unpack (const unsigned char *buf,
+                             const unsigned int *bits,
+                             const unsigned int m, unsigned int *idx) {
+  /* declare required variables:
+   *  @pos: bit position of the next packed index.
+   */
+  unsigned int k, b, pos;
+
+  /* unpack the bits of every index. */
+  for (k = 0, pos = 0; k < m; k++) {
+    for (b = 0, idx[k] = 0; b < bits[k]; b++, pos++)
+      idx[k] |= ((buf[pos / 8] >> (pos % 8)) & 1U) << b;
+  }
+}
+
+/* enum_write_path(): called to write a structure to path output.
+ */
+int enum_write_path (enum_t *E, enum_thread_t *th) {
+  /* declare required variables:
+   *  @buf: packed state indices of the solution.
+   *  @idx: state indices of the branching levels.
+   *  @xf: energy of the solution, casted to a float.
+   */
+  unsigned char buf[E->path_sz + 1];
+  unsigned int idx[E->n_levels + 1];
+  unsigned int k, last;
+  float xf;
+
+  /* get the final non-duplicate level, which holds the energy. */
+  for (last = E->G->n_order - 1; last && E->G->orig[last]; last--);
+
+  /* pack the state indices of the branching levels. */
+  for (k = 0; k < E->n_levels; k++)
+    idx[k] = th->state[E->levels[k]].idx;
+
+  enum_write_path_pack(idx, E->path_bits, E->n_levels, buf);
+
+  /* write the packed path and the energy. */
+  xf = (float) th->state[last].energy;
+  write(E->fd, buf, E->path_sz);
+  write(E->fd, &xf, sizeof(float));
+
+  /* return success. */
+  return 1;
+}
@@ -16,3 +16,21 @@ int enum_write_pdb_open (enum_t *E);
 
 int enum_write_pdb (enum_t *E, enum_thread_t *th);
 
+/* ENUM_PATH_MAGIC: string that begins every path output file. */
+#define ENUM_PATH_MAGIC  "IBPPATH1"
+
+/* function declarations (PATH): */
+
+int enum_write_path_open (enum_t *E);
+
+void enum_write_path_close (enum_t *E);
+
+int enum_write_path (enum_t *E, enum_thread_t *th);
+
+void enum_write_path_pack (const unsigned int *idx, const unsigned int *bits,
+                           const unsigned int m, unsigned char *buf);
+
+void enum_write_path_unpack (const unsigned char *buf,
+                             const unsigned int *bits,
+                             const unsigned int m, unsigned int *idx);
+
@@ -4,6 +4,7 @@
 #include "enum-thread.h"
 #include "enum-write.h"
 #include "enum-prune.h"
+#include "enum-jit.h"
 
 /* enum_format_map_t: structure for mapping between output format names
  * and enumerated type values.
@@ -18,17 +19,35 @@ struct enum_format_map_t {
   enum_write_close_fn write_close;
 };
 
+/* selection classes of pruning methods under '--method auto':
+ *  ENUM_AUTO_ALWAYS: methods that define the feasible solutions, which
+ *                    are always registered at every level.
+ *  ENUM_AUTO_PROBE: methods that only anticipate the prunes of the
+ *                   methods above, which are kept at the levels where
+ *                   the calibration probe shows that they pay off.
+ *  ENUM_AUTO_NEVER: methods that change the accepted solutions, which
+ *                   are only registered on request.
+ */
+#define ENUM_AUTO_ALWAYS  0
+#define ENUM_AUTO_PROBE   1
+#define ENUM_AUTO_NEVER   2
+
 /* enum_prune_map_t: structure for mapping between pruning method names
  * and function pointers.
  */
 struct enum_prune_map_t {
   /* @name: string name of the pruning method.
    * @prune_init, @prune_test, @prune_report: pruning function pointers.
+   * @prune_done: optional function called after every level is
+   *              initialized.
+   * @sel: selection class of the method under '--method auto'.
    */
   char *name;
   enum_prune_init_fn prune_init;
   enum_prune_test_fn prune_test;
   enum_prune_report_fn prune_report;
+  enum_prune_done_fn prune_done;
+  int sel;
 };
 
 /* formats: mapping between name and type of all output formats
@@ -52,6 +71,13 @@ static const struct enum_format_map_t formats[] = {
     NULL /* no close function required. */
   },
 
+  /* path output format. creates a single file of packed branch paths. */
+  { "path",
+    enum_write_path_open,
+    enum_write_path,
+    enum_write_path_close
+  },
+
   /* null-terminator. */
   { NULL, NULL, NULL, NULL }
 };
@@ -64,46 +90,67 @@ static const struct enum_prune_map_t pruners[] = {
   { "dist",
     enum_prune_ddf_init,
     enum_prune_ddf,
-    enum_prune_ddf_report
+    enum_prune_ddf_report,
+    NULL,
+    ENUM_AUTO_ALWAYS
   },
 
   /* dihedral torsion feasibility. */
   { "dihe",
     enum_prune_dihe_init,
     enum_prune_taf,
-    enum_prune_dihe_report
+    enum_prune_dihe_report,
+    NULL,
+    ENUM_AUTO_ALWAYS
   },
 
   /* improper torsion feasibility. */
   { "impr",
     enum_prune_impr_init,
     enum_prune_taf,
-    enum_prune_impr_report
+    enum_prune_impr_report,
+    NULL,
+    ENUM_AUTO_ALWAYS
   },
 
   /* shortest path feasibility. */
   { "path",
     enum_prune_path_init,
     enum_prune_path,
-    enum_prune_path_report
+    enum_prune_path_report,
+    NULL,
+    ENUM_AUTO_PROBE
   },
 
   /* future distance feasibility. */
   { "future",
     enum_prune_future_init,
     enum_prune_future,
-    enum_prune_future_report
+    enum_prune_future_report,
+    NULL,
+    ENUM_AUTO_PROBE
+  },
+
+  /* one-step forward checking. */
+  { "forward",
+    enum_prune_forward_init,
+    enum_prune_forward,
+    enum_prune_forward_report,
+    NULL,
+    ENUM_AUTO_PROBE
   },
 
   /* energetic feasibility. */
   { "energy",
     enum_prune_energy_init,
     enum_prune_energy,
-    enum_prune_energy_report
+    enum_prune_energy_report,
+    enum_prune_energy_done,
+    ENUM_AUTO_NEVER
   },
 
   /* null-terminator. */
-  { NULL, NULL, NULL, NULL }
+  { NULL, NULL, NULL, NULL, NULL, 0 }
 };
 
 /* enum_init_threads(): set up the thread array of an enumerator in
@@ -149,6 +196,19 @@ static int enum_init_threads (enum_t *E, opts_t *opts) {
     E->threads[i].E = E;
     E->threads[i].level = 3;
 
+    /* initialize the node count and snapshot state. */
+    E->threads[i].ntest = E->threads[i].nlim = 0;
+    E->threads[i].snap = 0;
+    E->threads[i].snap_seen = 0;
+
+    /* contact grids are allocated when the threads are started. */
+    E->threads[i].grid_head = NULL;
+
+    /* profile counters are allocated when profiling begins. */
+    E->threads[i].prof = NULL;
+    E->threads[i].grid_n = E->threads[i].grid_lim = 0;
+    E->threads[i].fpos_lim = 0;
+
     /* initialize the thread state pointer. */
     stateptr = ((char*) E->threads) + offset + i * stride;
     E->threads[i].state = (enum_thread_node_t*) stateptr;
@@ -218,8 +278,71 @@ static int enum_init_format (enum_t *E, opts_t *opts) {
   throw("unrecognized output format '%s'", opts->fmt_out);
 }
 
+/* enum_prune_job_t: structure for holding the state shared by the
+ * threads that initialize a pruning method over the levels of the order.
+ */
+typedef struct {
+  /* @E: pointer to the enumerator structure to modify.
+   * @initfn: initialization function of the pruning method.
+   * @nthreads: number of initializing threads.
+   * @ok: whether every level was initialized.
+   */
+  enum_t *E;
+  enum_prune_init_fn initfn;
+  unsigned int nthreads;
+  int ok;
+}
+enum_prune_job_t;
+
+/* enum_prune_worker_t: structure for holding the state of one thread
+ * that initializes a pruning method.
+ */
+typedef struct {
+  /* @job: pointer to the shared initialization state.
+   * @first: first level initialized by the thread.
+   */
+  enum_prune_job_t *job;
+  unsigned int first;
+}
+enum_prune_worker_t;
+
+/* enum_init_prune_levels(): initialize a pruning method at every level
+ * of the order assigned to a thread. levels are dealt out in turn, which
+ * balances initializers whose cost grows with the level. each level is
+ * initialized by one thread only, and so the closures of each level are
+ * registered in the same order as a serial initialization.
+ *
+ * arguments:
+ *  @pdata: pointer to the worker structure of the thread.
+ *
+ * returns:
+ *  unused return value, always NULL.
+ */
+static void *enum_init_prune_levels (void *pdata) {
+  /* get references to the worker and the shared state. */
+  enum_prune_worker_t *w = (enum_prune_worker_t*) pdata;
+  enum_prune_job_t *job = w->job;
+  enum_t *E = job->E;
+
+  /* loop over the levels assigned to the thread. */
+  for (unsigned int lev = w->first; lev < E->G->n_order && job->ok;
+       lev += job->nthreads) {
+    /* skip duplicate levels. */
+    if (E->G->orig[lev])
+      continue;
+
+    /* initialize pruning methods for the current level. */
+    if (!job->initfn(E, lev))
+      job->ok = 0;
+  }
+
+  /* end thread execution. */
+  return NULL;
+}
+
 /* enum_init_prune_add(): register a pruning device with an enumerator by
- * the string name of the pruning device.
+ * the string name of the pruning device. the levels of the order are
+ * initialized by the threads of the enumerator in parallel.
  *
  * arguments:
  *  @E: pointer to the enumerator structure to modify.
@@ -230,33 +353,62 @@ static int enum_init_format (enum_t *E, opts_t *opts) {
  */
 static int enum_init_prune_add (enum_t *E, const char *name) {
   /* declare required variables:
-   *  @initfn: initialization function pointer.
+   *  @job: state shared by the initializing threads.
+   *  @w: worker state of each initializing thread.
    *  @i: general-purpose loop counter.
    */
-  enum_prune_init_fn initfn;
-  unsigned int i, lev;
+  enum_prune_job_t job;
+  unsigned int i, t, n;
 
   /* search for the pruning method in the mapping. */
   for (i = 0; pruners[i].name; i++) {
-    /* check if the current pruning method name matches. */
-    if (strcmp(pruners[i].name, name) == 0) {
-      /* match found. get the pruning initialization function. */
-      initfn = pruners[i].prune_init;
-
-      /* loop over all levels of the graph order. */
-      for (lev = 0; lev < E->G->n_order; lev++) {
-        /* skip duplicate levels. */
-        if (E->G->orig[lev])
-          continue;
-
-        /* initialize pruning methods for the current level. */
-        if (!initfn(E, lev))
-          throw("unable to initialize pruning method '%s'", name);
-      }
+    /* skip pruning methods with non-matching names. */
+    if (strcmp(pruners[i].name, name))
+      continue;
+
+    /* prepare the shared initialization state. */
+    n = (E->nthreads < E->G->n_order ? E->nthreads : E->G->n_order);
+    n = (n ? n : 1);
+    job.E = E;
+    job.initfn = pruners[i].prune_init;
+    job.nthreads = n;
+    job.ok = 1;
+
+    /* name the closures registered by the pruning method. */
+    E->prune_cur = pruners[i].name;
+
+    /* initialize the levels, dealt out over the threads. */
+    enum_prune_worker_t w[n];
+    for (t = 0; t < n; t++) {
+      w[t].job = &job;
+      w[t].first = t;
+    }
 
-      /* return success. */
-      return 1;
+#ifdef __IBP_HAVE_PTHREAD
+    pthread_t tid[n];
+    for (t = 1; t < n; t++) {
+      if (pthread_create(tid + t, NULL, enum_init_prune_levels, w + t))
+        throw("unable to create initialization thread %u of %u", t + 1, n);
     }
+
+    enum_init_prune_levels(w);
+    for (t = 1; t < n; t++)
+      pthread_join(tid[t], NULL);
+#else
+    for (t = 0; t < n; t++)
+      enum_init_prune_levels(w + t);
+#endif
+
+    /* check that every level was initialized. */
+    if (!job.ok)
+      throw("unable to initialize pruning method '%s'", name);
+
+    /* finish the initialization of the pruning method. */
+    if (pruners[i].prune_done)
+      pruners[i].prune_done(E);
+
+    /* return success. */
+    return 1;
   }
 
   /* unknown pruning method. */
@@ -275,8 +427,9 @@ static int enum_init_prune_add (enum_t *E, const char *name) {
 static int enum_init_prune (enum_t *E, opts_t *opts) {
   /* declare required variables:
    *  @i: general-purpose loop counter.
+   *  @m: pruning method index.
    */
-  unsigned int i;
+  unsigned int i, m;
 
   /* allocate the pruning method outer array. */
   E->prune = (enum_prune_test_fn**)
@@ -286,11 +439,12 @@ static int enum_init_prune (enum_t *E, opts_t *opts) {
   E->prune_sz = (unsigned int*)
     malloc(E->G->n_order * sizeof(unsigned int));
 
-  /* initialize the pruning method data array. */
+  /* initialize the pruning method data and name arrays. */
   E->prune_data = (void***) malloc(E->G->n_order * sizeof(void**));
+  E->prune_name = (const char***) malloc(E->G->n_order * sizeof(char**));
 
   /* check if any allocation failed. */
-  if (!E->prune || !E->prune_sz || !E->prune_data)
+  if (!E->prune || !E->prune_sz || !E->prune_data || !E->prune_name)
     throw("unable to allocate pruning arrays");
 
   /* initialize the inner arrays. */
@@ -298,15 +452,189 @@ static int enum_init_prune (enum_t *E, opts_t *opts) {
     E->prune[i] = NULL;
     E->prune_sz[i] = 0;
     E->prune_data[i] = NULL;
+    E->prune_name[i] = NULL;
   }
 
+  /* index the peptide terms by the levels that complete them. */
+  if (!enum_prune_terms_init(E))
+    throw("unable to index peptide terms");
+
   /* loop over the pruning method names in the options structure. */
   for (i = 0; i < opts->n_prune; i++) {
+    /* defer automatic selection until every named method is added. */
+    if (!strcmp(opts->prune[i], "auto")) {
+      E->autosel = 1;
+      continue;
+    }
+
     /* add the pruning method to the enumerator. */
     if (!enum_init_prune_add(E, opts->prune[i]))
       return 0;
   }
 
+  /* under automatic selection, add every method that it considers and
+   * that was not named explicitly.
+   */
+  for (m = 0; E->autosel && pruners[m].name; m++) {
+    /* skip methods that are never selected automatically. */
+    if (pruners[m].sel == ENUM_AUTO_NEVER)
+      continue;
+
+    /* skip methods that were named explicitly. */
+    for (i = 0; i < opts->n_prune; i++) {
+      if (!strcmp(opts->prune[i], pruners[m].name))
+        break;
+    }
+
+    /* add the pruning method to the enumerator. */
+    if (i == opts->n_prune && !enum_init_prune_add(E, pruners[m].name))
+      return 0;
+  }
+
+  /* return success. */
+  return 1;
+}
+
+/* enum_prune_optional(): determine whether the closures of a pruning
+ * method only anticipate the prunes of the methods that define feasible
+ * solutions, up to the distance tolerance, so that automatic selection
+ * may drop them.
+ *
+ * arguments:
+ *  @name: name of the pruning method.
+ *
+ * returns:
+ *  integer indicating whether (1) or not (0) the method is optional.
+ */
+int enum_prune_optional (const char *name) {
+  /* search for the pruning method in the mapping. */
+  for (unsigned int m = 0; pruners[m].name; m++) {
+    if (!strcmp(pruners[m].name, name))
+      return (pruners[m].sel == ENUM_AUTO_PROBE);
+  }
+
+  /* unknown methods are never optional. */
+  return 0;
+}
+
+/* enum_init_rotamers(): initialize the discrete dihedral values of an
+ * enumerator, which replace the interpolated branches at every level
+ * whose dihedral edge derives from a sidechain torsion with rotamers.
+ * only the rotamers whose values all lie within their torsion intervals
+ * are kept. the first level of each sidechain branches over its rotamers,
+ * and the later levels of the sidechain take the values of the chosen
+ * rotamer without branching.
+ *
+ * arguments:
+ *  @E: pointer to the enumerator structure to modify.
+ *
+ * returns:
+ *  integer indicating whether (1) or not (0) the operation succeeded.
+ */
+static int enum_init_rotamers (enum_t *E) {
+  /* declare required variables:
+   *  @pr: pointer to the rotamers of a sidechain.
+   *  @d03, @ang: dihedral edge and torsion interval of a level.
+   *  @keep: indices of the admissible rotamers of a sidechain.
+   *  @lev: level of each torsion of a sidechain, or zero.
+   *  @lead: first level of a sidechain.
+   *  @n: number of admissible rotamers of a sidechain.
+   *  @nsc, @nlev: numbers of sidechains and levels having rotamers.
+   */
+  peptide_rotamer_t *pr;
+  peptide_t *P = E->P;
+  graph_t *G = E->G;
+  unsigned int lev[PEPTIDE_MAX_CHI], *keep;
+  unsigned int i, j, k, c, n, lead, nsc, nlev;
+  value_t d03, ang;
+  double x;
+
+  /* return if no sidechains have rotamers. */
+  if (!P || P->n_rotamers == 0)
+    return 1;
+
+  /* allocate the per-level arrays. */
+  E->rot = (double**) calloc(G->n_order, sizeof(double*));
+  E->n_rot = (unsigned int*) calloc(G->n_order, sizeof(unsigned int));
+  E->rot_lead = (unsigned int*) calloc(G->n_order, sizeof(unsigned int));
+  if (!E->rot || !E->n_rot || !E->rot_lead)
+    throw("unable to allocate rotamer levels");
+
+  /* loop over the sidechains having rotamers. */
+  for (j = 0, nsc = nlev = 0; j < P->n_rotamers; j++) {
+    pr = P->rotamers + j;
+
+    /* locate the original level of each torsion of the sidechain. */
+    for (c = 0, lead = 0; c < pr->n_chi; c++) {
+      for (i = 3, lev[c] = 0; i < G->n_order && !lev[c]; i++) {
+        d03 = graph_get_edge(G, G->order[i - 3], G->order[i]);
+        if (!G->orig[i] && value_is_dihedral(d03) &&
+            d03.src == &P->torsions[pr->tor_id[c]].ang)
+          lev[c] = i;
+      }
+
+      if (lev[c] && (!lead || lev[c] < lead))
+        lead = lev[c];
+    }
+
+    /* skip sidechains whose torsions do not drive any level. */
+    if (!lead)
+      continue;
+
+    /* allocate the admissible rotamer indices. */
+    keep = (unsigned int*) malloc(pr->n_val * sizeof(unsigned int));
+    if (!keep)
+      throw("unable to allocate rotamer indices");
+
+    /* keep the rotamers that lie within every torsion interval. */
+    for (k = 0, n = 0; k < pr->n_val; k++) {
+      for (c = 0; c < pr->n_chi; c++) {
+        ang = P->torsions[pr->tor_id[c]].ang;
+        x = pr->val[k * pr->n_chi + c];
+        if (!value_is_undefined(ang) &&
+            !(x >= ang.l && x <= ang.u) &&
+            !(x - 360.0 >= ang.l && x - 360.0 <= ang.u) &&
+            !(x + 360.0 >= ang.l && x + 360.0 <= ang.u))
+          break;
+      }
+
+      if (c == pr->n_chi)
+        keep[n++] = k;
+    }
+
+    /* sidechains without any admissible rotamers keep interpolating. */
+    if (n == 0) {
+      free(keep);
+      continue;
+    }
+
+    /* store the rotamer values of each level of the sidechain. */
+    for (c = 0; c < pr->n_chi; c++) {
+      if (!lev[c])
+        continue;
+
+      E->rot[lev[c]] = (double*) malloc(n * sizeof(double));
+      if (!E->rot[lev[c]]) {
+        free(keep);
+        throw("unable to allocate rotamer values");
+      }
+
+      for (k = 0; k < n; k++)
+        E->rot[lev[c]][k] = pr->val[keep[k] * pr->n_chi + c] * M_PI / 180.0;
+
+      E->n_rot[lev[c]] = n;
+      E->rot_lead[lev[c]] = lead;
+      nlev++;
+    }
+
+    /* free the admissible rotamer indices. */
+    free(keep);
+    nsc++;
+  }
+
+  /* output an informational message about the rotamer levels. */
+  info("%u sidechains branch over rotamers at %u levels", nsc, nlev);
+
   /* return success. */
   return 1;
 }
@@ -353,6 +681,91 @@ enum_t *enum_new (peptide_t *P, graph_t *G, opts_t *opts) {
   /* initialize the termination variable. */
   E->term = 0;
 
+  /* store the traversal control variables. */
+  E->nsample = opts->nsample;
+  E->nprobe = opts->nprobe;
+  E->autosel = 0;
+  E->seed = opts->seed;
+  E->single = opts->single;
+  E->est = NULL;
+
+  /* initialize the drawn leaves of random probing. */
+  E->drawn = E->drawn_tab = NULL;
+  E->n_drawn = E->cap_drawn = E->drawn_sz = 0;
+
+  /* initialize the peptide term indices. */
+  memset(&E->bonds, 0, sizeof(enum_terms_t));
+  memset(&E->angles, 0, sizeof(enum_terms_t));
+  memset(&E->torsions, 0, sizeof(enum_terms_t));
+  memset(&E->impropers, 0, sizeof(enum_terms_t));
+
+  /* initialize the branching levels and blocks. */
+  E->levels = NULL;
+  E->n_levels = E->n_split = 0;
+  E->frag = NULL;
+  E->frag_pos = NULL;
+  E->rot = NULL;
+  E->n_rot = NULL;
+  E->rot_lead = NULL;
+  E->geom = NULL;
+  E->blocks = NULL;
+  E->n_blocks = 0;
+  E->meet = NULL;
+  E->jit = NULL;
+
+  /* initialize the snapshot variables. */
+  E->snap = E->snap_cover = 0;
+  E->snap_done = E->snap_wait = E->nlive = 0;
+  E->snap_fh = NULL;
+  E->fname_resume = (opts->fname_resume ? strdup(opts->fname_resume)
+                                        : NULL);
+
+  /* initialize the path output and reconstruction variables. */
+  E->path_bits = NULL;
+  E->path_sz = 0;
+  E->fname_replay = (opts->fname_replay ? strdup(opts->fname_replay)
+                                        : NULL);
+  E->select = (opts->select ? strdup(opts->select) : NULL);
+  E->replay_fh = NULL;
+
+  /* initialize the pruning method names and the profiling variables. */
+  E->prune_name = NULL;
+  E->prune_cur = NULL;
+  E->fname_prof = (opts->fname_prof ? strdup(opts->fname_prof) : NULL);
+  E->prof_off = NULL;
+  E->prof_t0 = 0;
+  E->prof_c0 = 0.0;
+
+  /* select the thread traversal function. random probing draws solutions
+   * until the sample size, which also acts as a solution limit.
+   */
+  E->thread_fn = (opts->lds ? enum_thread_lds : enum_thread_execute);
+  if (E->nsample) {
+    E->thread_fn = enum_thread_sample;
+    if (!E->nmax || E->nsample < E->nmax)
+      E->nmax = E->nsample;
+  }
+
+  /* tree size estimation replaces the traversal entirely. */
+  if (E->nprobe)
+    E->thread_fn = enum_thread_estimate;
+
+  /* block decomposition is attempted once the tree size is known. */
+  if (opts->blocks)
+    E->thread_fn = enum_thread_blocks;
+
+  /* bidirectional enumeration also requires the tree size. */
+  if (opts->meet)
+    E->thread_fn = enum_thread_meet;
+
+  /* randomized restarts search until the solution limit is reached. */
+  if (opts->restarts)
+    E->thread_fn = enum_thread_restart;
+
+  /* reconstruction replaces the traversal by the stored paths. */
+  if (E->fname_replay)
+    E->thread_fn = enum_thread_replay;
+
   /* store the branching control variables. */
   E->nbmax = opts->branch_max / 2;
   E->eps = opts->branch_eps;
@@ -370,6 +783,13 @@ enum_t *enum_new (peptide_t *P, graph_t *G, opts_t *opts) {
   E->rmsd_tol = (double) G->n_orig * pow(opts->rmsd_tol, 2.0);
   E->energy_tol = INFINITY;
 
+  /* store the contact energy cutoff, and size the contact grids to hold
+   * every atom with few collisions.
+   */
+  E->cutoff = opts->cutoff;
+  E->cutoff_err = 0.0;
+  for (E->grid_sz = 1; E->grid_sz < 2 * G->n_order; E->grid_sz *= 2);
+
   /* set the enumerator output format. */
   if (!enum_init_format(E, opts)) {
     /* raise an exception and return null. */
@@ -378,6 +798,26 @@ enum_t *enum_new (peptide_t *P, graph_t *G, opts_t *opts) {
     return NULL;
   }
 
+  /* prepare for tree size estimation, which writes no solutions. */
+  if (E->nprobe) {
+    /* disable the output system. */
+    E->write_open = NULL;
+    E->write_data = NULL;
+    E->write_close = NULL;
+
+    /* allocate the estimator sums of every thread. */
+    E->est = (double*) calloc(E->nthreads * (2 * G->n_order + 3),
+                              sizeof(double));
+
+    /* check if allocation failed. */
+    if (!E->est) {
+      /* raise an exception and return null. */
+      raise("unable to allocate estimator sums");
+      enum_free(E);
+      return NULL;
+    }
+  }
+
   /* initialize the pruning methods. */
   if (!enum_init_prune(E, opts)) {
     /* raise an exception and return null. */
@@ -386,6 +826,37 @@ enum_t *enum_new (peptide_t *P, graph_t *G, opts_t *opts) {
     return NULL;
   }
 
+  /* output an informational message about neglected contact energies. */
+  if (E->cutoff > 0.0)
+    info("contact cutoff %.3lf neglects at most %.3le energy per structure",
+         E->cutoff, E->cutoff_err);
+
+  /* initialize the discrete dihedral values from rotamers. */
+  if (!enum_init_rotamers(E)) {
+    /* raise an exception and return null. */
+    raise("unable to initialize rotamer levels");
+    enum_free(E);
+    return NULL;
+  }
+
+  /* select the pruning closures by a calibration probe, if requested.
+   * tree size estimation measures the tree of every closure.
+   */
+  if (E->autosel && !E->nprobe && !enum_auto_init(E, opts)) {
+    /* raise an exception and return null. */
+    raise("unable to select pruning closures");
+    enum_free(E);
+    return NULL;
+  }
+
+  /* compile the pruning kernels, if requested. */
+  if (opts->jit && !enum_jit_init(E)) {
+    /* raise an exception and return null. */
+    raise("unable to compile pruning kernels");
+    enum_free(E);
+    return NULL;
+  }
+
   /* return the new structure pointer. */
   return E;
 }
@@ -413,8 +884,16 @@ void enum_free (enum_t *E) {
   if (E->write_close)
     E->write_close(E);
 
-  /* free the directory name string. */
+  /* free the directory and snapshot name strings. */
   free(E->fname);
+  free(E->fname_resume);
+  free(E->fname_replay);
+  free(E->select);
+  free(E->fname_prof);
+
+  /* close any path output being reconstructed. */
+  if (E->replay_fh)
+    fclose(E->replay_fh);
 
   /* free the pruning function array. */
   if (E->prune) {
@@ -442,22 +921,72 @@ void enum_free (enum_t *E) {
     free(E->prune_data);
   }
 
-  /* free the pruning test sizes. */
+  /* free the pruning method names. */
+  for (i = 0; E->prune_name && i < E->G->n_order; i++)
+    free(E->prune_name[i]);
+
+  /* free the pruning test sizes and method names. */
   free(E->prune_sz);
+  free(E->prune_name);
+
+  /* free the peptide term indices. */
+  enum_prune_terms_free(E);
+
+  /* free the contact grids and profile counters of the threads. */
+  for (i = 0; E->threads && i < E->nthreads; i++)
+    free(E->threads[i].grid_head);
 
-  /* free the threads. */
+  enum_prof_free(E);
+
+  /* free the threads, branching levels, fragments and estimator sums. */
   free(E->threads);
+  free(E->levels);
+  free(E->frag);
+  free(E->frag_pos);
+
+  /* free the discrete dihedral values. */
+  for (i = 0; E->rot && i < E->G->n_order; i++)
+    free(E->rot[i]);
+
+  free(E->rot);
+  free(E->n_rot);
+  free(E->rot_lead);
+
+  /* free the embedding constants. */
+  for (i = 0; E->geom && i < E->G->n_order; i++)
+    free(E->geom[i].cs);
+
+  free(E->geom);
+  free(E->est);
+
+  /* free the drawn leaves of random probing. */
+  free(E->drawn);
+  free(E->drawn_tab);
+
+  /* free the blocks. */
+  for (i = 0; i < E->n_blocks; i++) {
+    free(E->blocks[i].lv);
+    free(E->blocks[i].sol);
+  }
+
+  /* free the block array and the bidirectional state. */
+  free(E->blocks);
+  enum_meet_free(E);
+
+  /* unload the compiled pruning kernels. */
+  enum_jit_free(E);
 
   /* finally, free the structure pointer. */
   free(E);
 }
 
-/* enum_report(): output a pruning report after enumeration.
+/* enum_report(): output a pruning report after (or during) enumeration.
  *
  * arguments:
  *  @E: pointer to the enumerator structure to access.
+ *  @fh: file handle to write the report into.
  */
-static void enum_report (enum_t *E) {
+void enum_report (enum_t *E, FILE *fh) {
   /* declare required variables:
    *  @i: pruning array index at each level.
    *  @m: pruning method index.
@@ -472,7 +1001,7 @@ static void enum_report (enum_t *E) {
   /* loop over the pruning methods. */
   for (m = 0; pruners[m].name; m++) {
     /* output an initial header. */
-    printf("\nPruning results [%s]:\n", pruners[m].name);
+    fprintf(fh, "\nPruning results [%s]:\n", pruners[m].name);
 
     /* get the pruning function pointers. */
     testfn = pruners[m].prune_test;
@@ -489,16 +1018,35 @@ static void enum_report (enum_t *E) {
         if (E->prune[lev][i] != testfn) continue;
 
         /* print reporting information for the closure. */
-        reportfn(E, lev, E->prune_data[lev][i]);
+        reportfn(E, fh, lev, E->prune_data[lev][i]);
       }
     }
   }
 
   /* output the number of solutions. */
-  printf("\nSolutions:\n"
-         "  Accepted: %16u\n"
-         "  Rejected: %16u\n",
-         E->nsol, E->nrej);
+  fprintf(fh, "\nSolutions:\n"
+              "  Accepted: %16u\n"
+              "  Rejected: %16u\n",
+          E->nsol, E->nrej);
+}
+
+/* enum_thread_run(): execute the traversal function of an enumerator
+ * thread, and remove the thread from the set of threads that publish
+ * into snapshots once the traversal has finished.
+ *
+ * arguments:
+ *  @pdata: pointer to the enumerator thread data structure.
+ */
+static void *enum_thread_run (void *pdata) {
+  /* get a reference to the thread. */
+  enum_thread_t *th = (enum_thread_t*) pdata;
+
+  /* execute the traversal and leave the snapshots. */
+  th->E->thread_fn(pdata);
+  enum_snap_leave(th);
+
+  /* end thread execution. */
+  return NULL;
 }
 
 /* enum_execute(): enumerate all solutions from an iDMDGP graph/peptide
@@ -512,14 +1060,36 @@ static void enum_report (enum_t *E) {
  *  failure.
  */
 int enum_execute (enum_t *E) {
-  /* initialize the solution count and open the output system. */
+  /* initialize the threads for enumeration. */
+  if (!enum_threads_init(E))
+    throw("unable to initialize enumerator threads");
+
+  /* initialize the solution count and open the output system, which may
+   * record the shape of the tree.
+   */
   E->nsol = 0;
   if (E->write_open && !E->write_open(E))
     throw("unable to open enumerator output");
 
-  /* initialize the threads for enumeration. */
-  if (!enum_threads_init(E))
-    throw("unable to initialize enumerator threads");
+  /* restore the thread ranges from a snapshot, if requested. */
+  if (E->fname_resume && !enum_snap_resume(E, E->fname_resume))
+    throw("unable to resume from snapshot");
+
+  /* open the stored paths to reconstruct, if requested. */
+  if (E->fname_replay && !enum_replay_init(E))
+    throw("unable to open paths for reconstruction");
+
+  /* start profiling the pruning closures, if requested. */
+  if (E->fname_prof && !enum_prof_init(E))
+    throw("unable to initialize pruning profile");
+
+  /* split the tree into independent blocks, if requested. */
+  if (E->thread_fn == enum_thread_blocks && !enum_blocks_init(E))
+    throw("unable to split enumerator into blocks");
+
+  /* split the tree into two halves, if requested. */
+  if (E->thread_fn == enum_thread_meet && !enum_meet_init(E))
+    throw("unable to split enumerator into halves");
 
 #if defined(__IBP_HAVE_PTHREAD)
 #if defined(__IBP_HAVE_CUDA)
@@ -537,11 +1107,14 @@ int enum_execute (enum_t *E) {
   if (ret)
     throw("unable to create timer thread");
 
-  /* execute the threads. */
+  /* execute the threads, every one of which publishes into snapshots
+   * until its traversal has finished.
+   */
+  E->nlive = E->nthreads;
   for (unsigned int i = 0; i < E->nthreads; i++) {
     /* create the thread. */
     int ret = pthread_create(&E->threads[i].thread, NULL,
-                             enum_thread_execute,
+                             enum_thread_run,
                              (void*) (E->threads + i));
 
     /* check the thread creation result. */
@@ -559,7 +1132,8 @@ int enum_execute (enum_t *E) {
 #else /* __IBP_HAVE_PTHREAD */
 
   /* execute a single enumerator in the current thread. boring. */
-  enum_thread_execute((void*) E->threads);
+  E->nlive = 1;
+  enum_thread_run((void*) E->threads);
 
 #endif /* __IBP_HAVE_PTHREAD */
 
@@ -568,7 +1142,15 @@ int enum_execute (enum_t *E) {
     E->write_close(E);
 
   /* write the pruning report. */
-  enum_report(E);
+  enum_report(E, stdout);
+
+  /* write the tree size estimate. */
+  if (E->nprobe)
+    enum_estimate_report(E);
+
+  /* write the pruning profile. */
+  if (E->fname_prof && !enum_prof_report(E))
+    throw("unable to write pruning profile");
 
   /* return success. */
   return 1;
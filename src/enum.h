@@ -5,6 +5,7 @@
 /* include the system headers. */
 #include <sys/stat.h>
 #include <unistd.h>
+#include <signal.h>
 #include <fcntl.h>
 
 /* include the pthread header. */
@@ -39,6 +40,15 @@ typedef struct _enum_thread_t enum_thread_t;
  */
 typedef int (*enum_prune_init_fn) (struct _enum_t *E, unsigned int lev);
 
+/* enum_prune_done_fn: function pointer specification for finishing the
+ * initialization of an enumerator pruning device, once every level has
+ * been initialized.
+ *
+ * arguments:
+ *  @E: pointer to the enumerator data structure to modify.
+ */
+typedef void (*enum_prune_done_fn) (struct _enum_t *E);
+
 /* enum_prune_test_fn: function pointer specification for testing
  * prune-ability (i.e. infeasibility) by an enumerator pruning device.
  *
@@ -60,10 +70,12 @@ typedef int (*enum_prune_test_fn) (struct _enum_t *E,
  *
  * arguments:
  *  @E: pointer to the enumerator data structure to access.
+ *  @fh: file handle to write the report into.
  *  @lev: level in the graph repetition order to report prunes for.
  *  @data: optional payload data pointer.
  */
 typedef void (*enum_prune_report_fn) (struct _enum_t *E,
+                                      FILE *fh,
                                       unsigned int lev,
                                       void *data);
 
@@ -99,6 +111,135 @@ typedef int (*enum_write_data_fn) (struct _enum_t *E,
  */
 typedef void (*enum_write_close_fn) (struct _enum_t *E);
 
+/* enum_thread_fn: function pointer specification for the traversal
+ * executed by each thread of an enumerator.
+ *
+ * arguments:
+ *  @pdata: pointer to the enumerator thread data structure.
+ *
+ * returns:
+ *  unused return value, always NULL.
+ */
+typedef void* (*enum_thread_fn) (void *pdata);
+
+/* enum_terms_t: data structure for holding the terms of a peptide array
+ * grouped by the graph level that embeds the last of their atoms.
+ */
+typedef struct {
+  /* @start: offsets of the terms of each level into @id, followed by the
+   *         total number of indexed terms.
+   * @id: indices of the terms into their peptide array.
+   */
+  unsigned int *start, *id;
+}
+enum_terms_t;
+
+/* enum_block_t: data structure for holding a block of consecutive levels
+ * that may be enumerated independently of all other blocks, along with
+ * the feasible partial solutions of the block.
+ *
+ * the atoms of every block after the first are embedded relative to a
+ * canonical placement of the three levels preceding the block, which
+ * form its embedding frame.
+ */
+typedef struct {
+  /* @start: first level of the block.
+   * @end: one-past-last level of the block.
+   * @lv: branching levels of the block, followed by @end.
+   * @m: number of branching levels in the block.
+   */
+  unsigned int start, end;
+  unsigned int *lv, m;
+
+  /* @sol: atom positions of every partial solution of the block.
+   * @nsol: number of partial solutions of the block.
+   * @cap: number of partial solutions allocated in @sol.
+   */
+  vector_t *sol;
+  unsigned int nsol, cap;
+}
+enum_block_t;
+
+/* enum_geom_t: data structure for holding the precomputed embedding
+ * constants of a level whose three preceeding atoms lie at exact
+ * distances from each other. each new atom is placed at:
+ *
+ *   x3 = a x2 - b x1 + cos(w) (c r01 - d r12) + sin(w) f (r12 x r01)
+ *
+ * where r01 = x1 - x0 and r12 = x2 - x1.
+ */
+typedef struct {
+  /* @a, @b, @c, @d, @f: coefficients of the embedding.
+   */
+  double a, b, c, d, f;
+
+  /* @cs: interleaved cosines and sines of the dihedral of every branch
+   *      (or rotamer) of the level, or null if the level is not fixed.
+   */
+  double *cs;
+}
+enum_geom_t;
+
+/* enum_meet_cell_t: data structure for holding the spatial hash key of a
+ * backward solution of a bidirectional enumeration, for sorting.
+ */
+typedef struct {
+  /* @key: packed cell coordinates of the indexed atom.
+   * @idx: index of the backward solution.
+   */
+  unsigned long long key;
+  unsigned int idx;
+}
+enum_meet_cell_t;
+
+/* enum_meet_t: data structure for holding the state of a bidirectional
+ * (meet-in-the-middle) enumeration, in which the tree is split at a middle
+ * level into a forward half, embedded from the start of the order, and a
+ * backward half, embedded in reverse from the end of the order. the two
+ * halves share the three levels that precede the middle level, which
+ * form their junction frame.
+ */
+typedef struct {
+  /* @mid: first level that belongs only to the backward half.
+   * @lv: branching levels of the forward half, followed by @mid.
+   * @m: number of branching levels in the forward half.
+   */
+  unsigned int mid, *lv, m;
+
+  /* @fwd: positions of levels [0,mid) of every forward solution.
+   * @bwd: junction frame coordinates of levels [mid,n) of every backward
+   *       solution, where n is the length of the order.
+   * @nfwd, @nbwd: numbers of forward and backward solutions.
+   * @capf, @capb: numbers of solutions allocated in @fwd and @bwd.
+   */
+  vector_t *fwd, *bwd;
+  unsigned int nfwd, nbwd, capf, capb;
+
+  /* @kf, @kb: forward and backward levels of the tightest edge that
+   *           crosses the junction, used to index backward solutions.
+   * @rad: width of the cells of the spatial hash, which is the upper
+   *       bound of the crossing edge plus the distance tolerance, or
+   *       zero if no crossing edge exists.
+   * @ddf: whether or not distance bounds are enforced.
+   * @cells: backward solutions sorted by the cells of their indexed atoms.
+   */
+  unsigned int kf, kb;
+  double rad;
+  int ddf;
+  enum_meet_cell_t *cells;
+
+  /* @next: index of the next half to be enumerated.
+   * @next_fwd: index of the next forward solution to be joined.
+   * @barrier: barrier that separates the enumeration of the halves from
+   *           their join, in which every thread takes part.
+   */
+  unsigned int next, next_fwd;
+#ifdef __IBP_HAVE_PTHREAD
+  pthread_barrier_t barrier;
+#endif
+}
+enum_meet_t;
+
 /* enum_thread_node_t: data structure for holding the state of a single
  * node in an iDMDGP sub-tree. an array of these structures describes
  * the state of a single candidate solution.
@@ -115,8 +256,12 @@ typedef struct {
   /* coordinate variables:
    *  @pos: position of the node for the candidate solution.
    *  @prev: previous solution position of the node.
+   *  @fpos: single-precision position of the node, relative to the
+   *         position of its anchor level, during single-precision
+   *         traversal.
    */
   vector_t pos, prev;
+  float fpos[3];
 
   /* variables related to dihedral interval reduction:
    *  @isa, @isb: interval sets used during intersection operations.
@@ -133,6 +278,19 @@ typedef struct {
 }
 enum_thread_node_t;
 
+/* enum_prof_t: data structure for holding the profile counters of a
+ * single pruning closure in a single thread.
+ */
+typedef struct {
+  /* @ticks: clock ticks spent in the closure.
+   * @ncall: number of calls made to the closure.
+   * @nprune: number of prunes performed by the closure.
+   */
+  unsigned long long ticks;
+  unsigned long ncall, nprune;
+}
+enum_prof_t;
+
 /* enum_thread_t: data structure for holding the traversal state of a
  * single thread of an iDMDGP solution enumerator, which covers a
  * well-defined iDMDGP sub-tree.
@@ -152,6 +310,42 @@ struct _enum_thread_t {
    */
   enum_thread_node_t *state;
   unsigned int level;
+
+  /* @rng: state of the pseudorandom number generator of the thread.
+   * @block: index of the block being enumerated by the thread.
+   */
+  unsigned long long rng;
+  unsigned int block;
+
+  /* @ntest: number of tree nodes tested for feasibility by the thread.
+   * @nlim: node test count at which depth-first traversals of the thread
+   *        are cut off, or zero for no limit.
+   * @snap: index of the last snapshot that the thread published into.
+   * @snap_seen: value of the snapshot request counter of the enumerator
+   *             when the thread last checked it.
+   */
+  unsigned long ntest, nlim;
+  unsigned int snap;
+  sig_atomic_t snap_seen;
+
+  /* @grid_head: first level filed in each hashed cell of the contact
+   *             grid of the thread, or the level count for empty cells.
+   * @grid_next: next level filed in the same hashed cell as each level.
+   * @grid_cell: cell coordinates and hashed cell of each filed level.
+   * @grid_n: number of leading levels that have been filed.
+   * @grid_lim: lowest level whose atom has moved without being embedded
+   *            since it was filed.
+   * @fpos_lim: lowest level whose single-precision position may differ
+   *            from its double-precision position.
+   */
+  unsigned int *grid_head, *grid_next;
+  int *grid_cell;
+  unsigned int grid_n, grid_lim, fpos_lim;
+
+  /* @prof: profile counters of every closure, or null when the thread
+   *        is not being profiled.
+   */
+  enum_prof_t *prof;
 };
 
 /* enum_t: structure for holding all state information required for the
@@ -211,16 +405,132 @@ struct _enum_t {
   /* @prune: (2d) array of pruning test function pointers.
    * @prune_sz: sizes of each inner array in @prune.
    * @prune_data: array of pruning data payloads.
+   * @prune_name: name of the pruning method that registered each closure.
+   * @prune_cur: name of the pruning method being initialized.
    */
   enum_prune_test_fn **prune;
   unsigned int *prune_sz;
   void ***prune_data;
+  const char ***prune_name;
+  const char *prune_cur;
+
+  /* @bonds, @angles: bonds and angles completed at each level.
+   * @torsions, @impropers: torsions and impropers completed at each level.
+   */
+  enum_terms_t bonds, angles, torsions, impropers;
 
   /* @threads: array of enumerator threads.
    * @nthreads: number of enumerator threads.
+   * @thread_fn: traversal function executed by each thread.
    */
   enum_thread_t *threads;
   unsigned int nthreads;
+  enum_thread_fn thread_fn;
+
+  /* @levels: levels of the order having more than one branch, followed
+   *          by the length of the order as a sentinel.
+   * @n_levels: number of branching levels.
+   * @n_split: number of leading branching levels whose indices divide
+   *           the tree among the threads.
+   */
+  unsigned int *levels;
+  unsigned int n_levels, n_split;
+
+  /* @frag: one-past-last level of the rigid fragment that begins at each
+   *        level, or zero where no fragment begins.
+   * @frag_pos: coordinates of the atoms of every rigid fragment in the
+   *            frame of the three levels that precede the fragment.
+   */
+  unsigned int *frag;
+  vector_t *frag_pos;
+
+  /* @rot: dihedral values, in radians, that each rotamer of a sidechain
+   *       assigns to each level, or null at levels that interpolate over
+   *       their dihedral intervals.
+   * @n_rot: number of rotamers of the sidechain of each level.
+   * @rot_lead: first level of the sidechain of each level, which branches
+   *            over the rotamers and fixes the values of later levels.
+   */
+  double **rot;
+  unsigned int *n_rot;
+  unsigned int *rot_lead;
+
+  /* @geom: embedding constants of every level.
+   */
+  enum_geom_t *geom;
+
+  /* @blocks: independently enumerated blocks of levels.
+   * @n_blocks: number of blocks.
+   * @next_block: index of the next block to be enumerated.
+   * @busy: number of threads still enumerating blocks.
+   */
+  enum_block_t *blocks;
+  unsigned int n_blocks, next_block, busy;
+
+  /* @meet: state of the bidirectional enumeration, if any.
+   */
+  enum_meet_t *meet;
+
+  /* @jit: handle of the shared object of compiled pruning kernels.
+   */
+  void *jit;
+
+  /* @snap: number of snapshots requested, usually by a signal handler.
+   * @snap_cover: number of requests covered by written or pending files.
+   * @snap_done: number of snapshot files written.
+   * @snap_wait: number of live threads yet to publish into @snap_fh.
+   * @nlive: number of threads that have not finished their traversal.
+   * @snap_fh: file handle of the pending snapshot, if any.
+   * @fname_resume: snapshot filename to resume the traversal from.
+   */
+  volatile sig_atomic_t snap;
+  sig_atomic_t snap_cover;
+  unsigned int snap_done, snap_wait, nlive;
+  FILE *snap_fh;
+  char *fname_resume;
+
+  /* @path_bits: number of bits of the state index of each branching level
+   *             in path output.
+   * @path_sz: number of bytes of the packed state indices of each path.
+   * @fname_replay: path output filename to reconstruct solutions from.
+   * @select: comma-separated indices and ranges of the solutions to
+   *          reconstruct, or null to reconstruct every solution.
+   * @replay_fh: file handle of the path output being reconstructed.
+   */
+  unsigned int *path_bits, path_sz;
+  char *fname_replay, *select;
+  FILE *replay_fh;
+
+  /* @nsample: number of solutions to draw by random probing.
+   * @seed: seed value for the random number generators of the threads.
+   * @single: whether or not atoms are embedded in single precision.
+   */
+  unsigned int nsample;
+  unsigned long seed;
+  unsigned int single;
+
+  /* @drawn: branch indices at every branching level of each leaf drawn
+   *         by random probing.
+   * @n_drawn, @cap_drawn: numbers of drawn and allocated leaves.
+   * @drawn_tab: open-addressing hash table of the drawn leaves, holding
+   *             leaf indices offset by one, or zero in empty slots.
+   * @drawn_sz: number of slots in the hash table, a power of two.
+   */
+  unsigned int *drawn, n_drawn, cap_drawn;
+  unsigned int *drawn_tab, drawn_sz;
+
+  /* @nprobe: number of random probes for tree size estimation.
+   * @est: per-thread estimator sums, laid out as the feasible node sums
+   *       and the tested node sums of each level, followed by the probe
+   *       count, node test count and elapsed time of the thread.
+   */
+  unsigned int nprobe;
+  double *est;
+
+  /* @autosel: whether or not the pruning closures are selected by a
+   *           calibration probe.
+   */
+  unsigned int autosel;
 
   /* @timer: unique thread for computing timing information.
    */
@@ -234,6 +544,28 @@ struct _enum_t {
    *  @energy_tol: maximum acceptable energy for pruning.
    */
   double ddf_tol, rmsd_tol, energy_tol;
+
+  /* @cutoff: distance beyond which contact energies are neglected, and
+   *          side length of the cells of the contact grids, or zero to
+   *          evaluate every contact.
+   * @cutoff_err: upper bound on the contact energy neglected along any
+   *              path of the tree.
+   * @grid_sz: number of hashed cells of each contact grid, a power of two.
+   */
+  double cutoff, cutoff_err;
+  unsigned int grid_sz;
+
+  /* @fname_prof: pruning profile output filename, or null to disable
+   *              profiling.
+   * @prof_off: offset of the first closure of each level in the profile
+   *            counters of each thread, followed by the closure count.
+   * @prof_t0: clock ticks at the start of profiling.
+   * @prof_c0: monotonic clock time, in microseconds, at the same instant.
+   */
+  char *fname_prof;
+  unsigned int *prof_off;
+  unsigned long long prof_t0;
+  double prof_c0;
 };
 
 /* function declarations (enum.c): */
@@ -244,3 +576,7 @@ void enum_free (enum_t *E);
 
 int enum_execute (enum_t *E);
 
+void enum_report (enum_t *E, FILE *fh);
+
+int enum_prune_optional (const char *name);
+
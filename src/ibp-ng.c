@@ -28,11 +28,16 @@
   -f, --format FMT        Output format                               [dcd]\n\
   -r, --restraints RES    Input restraints filename                  [none]\n\
   -s, --sidechain SL      Sidechain(s) to make explicit              [none]\n\
+      --profile FPROF     Output pruning profile file                [none]\n\
 \n\
  Configuration file options:\n\
   -T, --topology TOP      Topology file for protein geometry\n\
   -P, --params PAR        Parameter file for protein geometry\n\
   -R, --reorder ORD       Repetition order definitions filename\n\
+      --rotamers ROT      Rotamer library for explicit sidechains\n\
+      --resume SNAP       Snapshot to resume enumeration from        [none]\n\
+      --replay FPATH      Reconstruct solutions from a path file     [none]\n\
+      --select SEL        Solutions to reconstruct, e.g. 1-10,42      [all]\n\
 \n\
  Graph options:\n\
       --refine            Flag to refine the graph edges              [off]\n\
@@ -43,12 +48,22 @@
   -b, --branch-max NB     Maximum number of branches per node          [20]\n\
   -e, --branch-eps EPS    Minimum interval discretization            [0.05]\n\
   -l, --limit NSOL        Maximum number of solutions                 [off]\n\
+      --sample NS         Draw solutions by random probing            [off]\n\
+      --seed SEED         Random number generator seed                  [1]\n\
+      --lds               Flag to use limited discrepancy search      [off]\n\
+      --estimate NP       Estimate tree size and runtime by probing   [off]\n\
+      --blocks            Flag to enumerate independent blocks        [off]\n\
+      --meet              Flag to enumerate bidirectionally           [off]\n\
+      --restarts          Flag to use randomized restarts             [off]\n\
+      --single            Flag to embed in single precision           [off]\n\
       --vdw-scale VF      Atomic radius scaling factor                [0.6]\n\
       --ddf-tol TOL       DDF error tolerance                       [0.001]\n\
+      --cutoff RC         Contact energy cutoff distance              [off]\n\
 \n\
  Parallel execution options:\n\
   -g, --gpu               Flag to execute on the GPU                  [off]\n\
   -t, --threads NT        Number of threads to execute                  [1]\n\
+      --jit               Flag to compile instance-specific kernels   [off]\n\
 \n\
  The ibp-ng utility enumerates all feasible solutions to a given Interval\n\
  Discretizable Molecular Distance Geometry Problem (iDMDGP) instance, or\n\
@@ -62,6 +77,7 @@
  *  @ord: repetition order structure for constructing graphs.
  *  @top: molecular topology structure for constructing graphs.
  *  @par: molecular parameters structure for constructing graphs.
+ *  @rot: rotamer library structure for branching over sidechains.
  *  @P: peptide structure for initializing molecular information.
  *  @G: graph structure for summarizing a problem instance.
  *  @E: enum structure for enumerating all feasible solutions.
@@ -70,6 +86,7 @@ opts_t *opts = NULL;
 reorder_t *ord = NULL;
 topol_t *top = NULL;
 param_t *par = NULL;
+rotamer_t *rot = NULL;
 peptide_t *P = NULL;
 graph_t *G = NULL;
 enum_t *E = NULL;
@@ -86,6 +103,17 @@ void main_handler (int sig) {
   E->term = 1;
 }
 
+/* main_snapshot(): handle user signals in order to request a snapshot
+ * of the running enumeration threads.
+ *
+ * arguments:
+ *  @sig: code of the caught signal.
+ */
+void main_snapshot (int sig) {
+  /* raise the snapshot request counter. */
+  E->snap++;
+}
+
 /* main(): application entry point.
  *
  * arguments:
@@ -176,6 +204,20 @@ int main (int argc, char **argv) {
       die("unable to add restraints from '%s'", opts->fname_restr[i]);
   }
 
+  /* check if a rotamer library was specified. */
+  if (opts->fname_rot) {
+    /* create a new rotamer library structure from the specified file. */
+    rot = rotamer_new_from_file(opts->fname_rot);
+
+    /* check that the rotamer library was successfully created. */
+    if (!rot)
+      die("unable to read rotamers from '%s'", opts->fname_rot);
+
+    /* apply rotamer information to the explicit sidechains. */
+    if (!rotamer_apply_all(rot, P))
+      die("unable to apply rotamer library");
+  }
+
   /* back-calculate the peptide force-field / probability parameters. */
   if (!peptide_field(P, opts->ddf_tol))
     die("unable to recompute force field parameters");
@@ -211,6 +253,9 @@ int main (int argc, char **argv) {
   /* catch interrupt signals. */
   signal(SIGINT, main_handler);
 
+  /* catch snapshot request signals. */
+  signal(SIGUSR1, main_snapshot);
+
   /* enumerate all solutions from the graph. */
   if (!enum_execute(E))
     die("failed to enumerate graph solutions");
@@ -227,6 +272,7 @@ death:
   reorder_free(ord);
   topol_free(top);
   param_free(par);
+  rotamer_free(rot);
 
   /* free the enumerator structure. */
   enum_free(E);
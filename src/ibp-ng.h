@@ -10,6 +10,7 @@
 #include "enum.h"
 #include "topol.h"
 #include "param.h"
+#include "rotamer.h"
 #include "assign.h"
 #include "dmdgp.h"
 #include "psf.h"
@@ -29,6 +29,21 @@
 #define OPTS_S_RMSD       ('z'+3)
 #define OPTS_S_REFINE     ('z'+4)
 #define OPTS_S_COMPLETE   ('z'+5)
+#define OPTS_S_SAMPLE     ('z'+6)
+#define OPTS_S_SEED       ('z'+7)
+#define OPTS_S_LDS        ('z'+8)
+#define OPTS_S_ESTIMATE   ('z'+9)
+#define OPTS_S_BLOCKS     ('z'+10)
+#define OPTS_S_MEET       ('z'+11)
+#define OPTS_S_ROTAMERS   ('z'+12)
+#define OPTS_S_RESTARTS   ('z'+13)
+#define OPTS_S_JIT        ('z'+14)
+#define OPTS_S_SINGLE     ('z'+15)
+#define OPTS_S_RESUME     ('z'+16)
+#define OPTS_S_REPLAY     ('z'+17)
+#define OPTS_S_SELECT     ('z'+18)
+#define OPTS_S_CUTOFF     ('z'+19)
+#define OPTS_S_PROFILE    ('z'+20)
 
 /* define all accepted long options.
  */
@@ -46,6 +61,7 @@
 #define OPTS_L_TOPOLOGY   "topology"
 #define OPTS_L_PARAMS     "params"
 #define OPTS_L_REORDER    "reorder"
+#define OPTS_L_ROTAMERS   "rotamers"
 #define OPTS_L_GPU        "gpu"
 #define OPTS_L_THREADS    "threads"
 #define OPTS_L_METHOD     "method"
@@ -57,6 +73,20 @@
 #define OPTS_L_RMSD       "rmsd"
 #define OPTS_L_REFINE     "refine"
 #define OPTS_L_COMPLETE   "complete"
+#define OPTS_L_SAMPLE     "sample"
+#define OPTS_L_SEED       "seed"
+#define OPTS_L_LDS        "lds"
+#define OPTS_L_ESTIMATE   "estimate"
+#define OPTS_L_BLOCKS     "blocks"
+#define OPTS_L_MEET       "meet"
+#define OPTS_L_RESTARTS   "restarts"
+#define OPTS_L_JIT        "jit"
+#define OPTS_L_SINGLE     "single"
+#define OPTS_L_RESUME     "resume"
+#define OPTS_L_REPLAY     "replay"
+#define OPTS_L_SELECT     "select"
+#define OPTS_L_CUTOFF     "cutoff"
+#define OPTS_L_PROFILE    "profile"
 
 /* opts_config_t: option definition structure for informing opts_next()
  * about all supported command line options that the user may specify.
@@ -91,6 +121,7 @@ static const opts_config_t conf[] = {
   { OPTS_L_TOPOLOGY,   OPTS_S_TOPOLOGY,   1 },
   { OPTS_L_PARAMS,     OPTS_S_PARAMS,     1 },
   { OPTS_L_REORDER,    OPTS_S_REORDER,    1 },
+  { OPTS_L_ROTAMERS,   OPTS_S_ROTAMERS,   1 },
   { OPTS_L_GPU,        OPTS_S_GPU,        0 },
   { OPTS_L_THREADS,    OPTS_S_THREADS,    1 },
   { OPTS_L_METHOD,     OPTS_S_METHOD,     1 },
@@ -99,9 +130,23 @@ static const opts_config_t conf[] = {
   { OPTS_L_LIMIT,      OPTS_S_LIMIT,      1 },
   { OPTS_L_VDW_SCALE,  OPTS_S_VDW_SCALE,  1 },
   { OPTS_L_DDF_TOL,    OPTS_S_DDF_TOL,    1 },
+  { OPTS_L_CUTOFF,     OPTS_S_CUTOFF,     1 },
+  { OPTS_L_PROFILE,    OPTS_S_PROFILE,    1 },
   { OPTS_L_RMSD,       OPTS_S_RMSD,       1 },
   { OPTS_L_REFINE,     OPTS_S_REFINE,     0 },
   { OPTS_L_COMPLETE,   OPTS_S_COMPLETE,   0 },
+  { OPTS_L_SAMPLE,     OPTS_S_SAMPLE,     1 },
+  { OPTS_L_SEED,       OPTS_S_SEED,       1 },
+  { OPTS_L_LDS,        OPTS_S_LDS,        0 },
+  { OPTS_L_ESTIMATE,   OPTS_S_ESTIMATE,   1 },
+  { OPTS_L_BLOCKS,     OPTS_S_BLOCKS,     0 },
+  { OPTS_L_MEET,       OPTS_S_MEET,       0 },
+  { OPTS_L_RESTARTS,   OPTS_S_RESTARTS,   0 },
+  { OPTS_L_JIT,        OPTS_S_JIT,        0 },
+  { OPTS_L_SINGLE,     OPTS_S_SINGLE,     0 },
+  { OPTS_L_RESUME,     OPTS_S_RESUME,     1 },
+  { OPTS_L_REPLAY,     OPTS_S_REPLAY,     1 },
+  { OPTS_L_SELECT,     OPTS_S_SELECT,     1 },
 
   /* null terminator. */
   { NULL,              '\0',              0 }
@@ -218,12 +263,17 @@ opts_t *opts_new (void) {
   opts->fname_top = NULL;
   opts->fname_par = NULL;
   opts->fname_ord = NULL;
+  opts->fname_rot = NULL;
+  opts->fname_resume = NULL;
+  opts->fname_replay = NULL;
   opts->fname_psf = NULL;
   opts->fname_dmdgp = NULL;
+  opts->fname_prof = NULL;
 
   /* initialize the file option fields. */
   opts->idx_in = NULL;
   opts->fmt_out = NULL;
+  opts->select = NULL;
 
   /* initialize the restraint filename fields. */
   opts->fname_restr = NULL;
@@ -239,14 +289,26 @@ opts_t *opts_new (void) {
 
   /* initialize branch control fields. */
   opts->thread_gpu = 0;
+  opts->jit = 0;
   opts->thread_num = 1;
   opts->branch_max = 20;
   opts->branch_eps = 0.05;
 
+  /* initialize traversal control fields. */
+  opts->nsample = 0;
+  opts->seed = 1;
+  opts->lds = 0;
+  opts->nprobe = 0;
+  opts->blocks = 0;
+  opts->meet = 0;
+  opts->restarts = 0;
+  opts->single = 0;
+
   /* initialize prune control fields. */
   opts->nsol_limit = 0;
   opts->vdw_scale = 0.6;
   opts->ddf_tol = 0.001;
+  opts->cutoff = 0.0;
   opts->rmsd_tol = 0.0;
 
   /* initialize graph control fields. */
@@ -498,6 +560,13 @@ opts_t *opts_new_from_strings (int argc, char **argv) {
         argi++;
         break;
 
+      /* profile filename. */
+      case OPTS_S_PROFILE:
+        /* set the profile filename. */
+        opts->fname_prof = argv[argi];
+        argi++;
+        break;
+
       /* chain identifier.
        * sequence number.
        */
@@ -564,6 +633,34 @@ opts_t *opts_new_from_strings (int argc, char **argv) {
         argi++;
         break;
 
+      /* rotamer library filename. */
+      case OPTS_S_ROTAMERS:
+        /* set the rotamer library filename. */
+        opts->fname_rot = argv[argi];
+        argi++;
+        break;
+
+      /* snapshot filename. */
+      case OPTS_S_RESUME:
+        /* set the snapshot filename. */
+        opts->fname_resume = argv[argi];
+        argi++;
+        break;
+
+      /* path filename. */
+      case OPTS_S_REPLAY:
+        /* set the path filename. */
+        opts->fname_replay = argv[argi];
+        argi++;
+        break;
+
+      /* path selection. */
+      case OPTS_S_SELECT:
+        /* set the path selection string. */
+        opts->select = argv[argi];
+        argi++;
+        break;
+
       /* number of threads. */
       case OPTS_S_THREADS:
 #if !defined(__IBP_HAVE_PTHREAD)
@@ -591,6 +688,19 @@ opts_t *opts_new_from_strings (int argc, char **argv) {
         break;
 #endif
 
+      /* compiled kernel flag. */
+      case OPTS_S_JIT:
+#if !defined(__IBP_HAVE_JIT)
+        /* raise an exception about kernel compilation support. */
+        raise("this program was compiled without jit support");
+        opts_free(opts);
+        return NULL;
+#else
+        /* set the kernel flag. */
+        opts->jit++;
+        break;
+#endif
+
       /* pruning method. */
       case OPTS_S_METHOD:
         /* add the new pruning method or method list. */
@@ -623,6 +733,49 @@ opts_t *opts_new_from_strings (int argc, char **argv) {
         argi++;
         break;
 
+      /* random probing sample size. */
+      case OPTS_S_SAMPLE:
+        opts->nsample = atoi(argv[argi]);
+        argi++;
+        break;
+
+      /* random number generator seed. */
+      case OPTS_S_SEED:
+        opts->seed = strtoul(argv[argi], NULL, 10);
+        argi++;
+        break;
+
+      /* limited discrepancy search flag. */
+      case OPTS_S_LDS:
+        opts->lds++;
+        break;
+
+      /* tree size estimation probe count. */
+      case OPTS_S_ESTIMATE:
+        opts->nprobe = atoi(argv[argi]);
+        argi++;
+        break;
+
+      /* block decomposition flag. */
+      case OPTS_S_BLOCKS:
+        opts->blocks++;
+        break;
+
+      /* bidirectional enumeration flag. */
+      case OPTS_S_MEET:
+        opts->meet++;
+        break;
+
+      /* randomized restarts flag. */
+      case OPTS_S_RESTARTS:
+        opts->restarts++;
+        break;
+
+      /* single-precision traversal flag. */
+      case OPTS_S_SINGLE:
+        opts->single++;
+        break;
+
       /* vdw scale factor. */
       case OPTS_S_VDW_SCALE:
         opts->vdw_scale = atof(argv[argi]);
@@ -635,6 +788,12 @@ opts_t *opts_new_from_strings (int argc, char **argv) {
         argi++;
         break;
 
+      /* contact energy cutoff distance. */
+      case OPTS_S_CUTOFF:
+        opts->cutoff = atof(argv[argi]);
+        argi++;
+        break;
+
       /* rmsd tolerance. */
       case OPTS_S_RMSD:
         opts->rmsd_tol = atof(argv[argi]);
@@ -770,6 +929,39 @@ int opts_validate (opts_t *opts) {
   if (opts->ddf_tol < 0.0)
     raise("DDF: error tolerance must be non-negative");
 
+  /* validate the contact energy cutoff. */
+  if (opts->cutoff < 0.0)
+    raise("contact energy cutoff must be non-negative");
+
+  /* validate the traversal mode. */
+  if ((opts->nsample > 0) + (opts->lds > 0) +
+      (opts->nprobe > 0) + (opts->blocks > 0) +
+      (opts->meet > 0) + (opts->restarts > 0) +
+      (opts->fname_replay != NULL) > 1)
+    raise("at most one traversal mode may be selected");
+
+  /* validate the solution limit of randomized restarts. */
+  if (opts->restarts && !opts->nsol_limit)
+    raise("restarts require a solution limit");
+
+  /* validate the traversal mode of single-precision embedding, whose
+   * leaves are re-embedded from their branch indices.
+   */
+  if (opts->single && (opts->blocks || opts->meet))
+    raise("single precision requires a depth-first traversal mode");
+
+  /* validate the traversal mode of resumed enumerations, as snapshots
+   * only record the ranges of depth-first traversals.
+   */
+  if (opts->fname_resume && (opts->nsample || opts->lds || opts->nprobe ||
+                             opts->blocks || opts->meet || opts->restarts ||
+                             opts->fname_replay))
+    raise("resuming requires the default traversal mode");
+
+  /* validate the path selection. */
+  if (opts->select && !opts->fname_replay)
+    raise("path selection requires a path file to replay");
+
   /* return valid. */
   return (traceback_length() == 0);
 }
@@ -21,27 +21,37 @@ typedef struct {
    *  @fname_top: topology filename string.
    *  @fname_par: parameter filename string.
    *  @fname_ord: reorder filename string.
+   *  @fname_rot: rotamer library filename string.
+   *  @fname_resume: snapshot filename string to resume from.
+   *  @fname_replay: path filename string to reconstruct solutions from.
    */
   char *fname_in;
   char *fname_top;
   char *fname_par;
   char *fname_ord;
+  char *fname_rot;
+  char *fname_resume;
+  char *fname_replay;
 
   /* declare variables for output filename storage:
    *  @fname_out: output filename string.
    *  @fname_psf: psf filename string.
    *  @fname_dmdgp: dmdgp filename string.
+   *  @fname_prof: pruning profile filename string.
    */
   char *fname_out;
   char *fname_psf;
   char *fname_dmdgp;
+  char *fname_prof;
 
   /* declare variables for input and output clarifications:
    *  @idx_in: chain or index string for input file parsing.
    *  @fmt_out: format string for output file writing.
+   *  @select: selection string of the stored paths to reconstruct.
    */
   char *idx_in;
   char *fmt_out;
+  char *select;
 
   /* declare variables for restraint filename storage:
    *  @fname_restr: array of restraint filename strings.
@@ -65,23 +75,45 @@ typedef struct {
 
   /* declare variables for branch control:
    *  @thread_gpu: whether or not we should use the gpu.
+   *  @jit: whether or not to compile instance-specific pruning kernels.
    *  @thread_num: number of parallel threads to utilize.
    *  @branch_max: maximum number of branches per node.
    *  @branch_eps: smallest division for interval discretization.
    */
-  unsigned int thread_gpu, thread_num;
+  unsigned int thread_gpu, thread_num, jit;
   unsigned int branch_max;
   double branch_eps;
 
+  /* declare variables for traversal control:
+   *  @nsample: number of solutions to draw by random probing.
+   *  @seed: seed value for the per-thread random number generators.
+   *  @lds: whether or not to use limited discrepancy search.
+   *  @nprobe: number of random probes for tree size estimation.
+   *  @blocks: whether or not to enumerate independent blocks.
+   *  @meet: whether or not to enumerate bidirectionally.
+   *  @restarts: whether or not to use randomized restarts.
+   *  @single: whether or not to embed atoms in single precision.
+   */
+  unsigned int nsample;
+  unsigned long seed;
+  unsigned int lds;
+  unsigned int nprobe;
+  unsigned int blocks;
+  unsigned int meet;
+  unsigned int restarts;
+  unsigned int single;
+
   /* declare variables for pruning control:
    *  @nsol_limit: maximum number of solutions to enumerate.
    *  @vdw_scale: atomic radius scaling factor for ddf lower-bounds.
    *  @ddf_tol: tolerance for acceptable out-of-bound errors.
+   *  @cutoff: distance beyond which contact energies are neglected.
    *  @rmsd_tol: rmsd for skipping structures.
    */
   unsigned int nsol_limit;
   double vdw_scale;
   double ddf_tol;
+  double cutoff;
   double rmsd_tol;
 
   /* declare variables for graph control:
@@ -53,6 +53,10 @@ peptide_t *peptide_new (void) {
   P->impropers = NULL;
   P->n_impropers = 0;
 
+  /* initialize the rotamer array. */
+  P->rotamers = NULL;
+  P->n_rotamers = 0;
+
   /* return the newly allocated peptide. */
   return P;
 }
@@ -110,6 +114,12 @@ void peptide_free (peptide_t *P) {
   if (P->n_impropers)
     free(P->impropers);
 
+  /* free the rotamer values and array. */
+  for (i = 0; i < P->n_rotamers; i++)
+    free(P->rotamers[i].val);
+
+  free(P->rotamers);
+
   /* reset the array counts. */
   P->n_res = 0;
   P->n_sc = 0;
@@ -118,6 +128,7 @@ void peptide_free (peptide_t *P) {
   P->n_angles = 0;
   P->n_torsions = 0;
   P->n_impropers = 0;
+  P->n_rotamers = 0;
 
   /* finally, free the structure pointer. */
   free(P);
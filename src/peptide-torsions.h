@@ -4,6 +4,10 @@
 
 /* function declarations (peptide-torsions.c): */
 
+int peptide_torsion_find (peptide_t *P,
+                          unsigned int id1, unsigned int id2,
+                          unsigned int id3, unsigned int id4);
+
 int peptide_torsion_add (peptide_t *P,
                          unsigned int resid1, const char *name1,
                          unsigned int resid2, const char *name2,
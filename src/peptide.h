@@ -82,6 +82,30 @@ typedef struct {
 }
 peptide_dihed_t;
 
+/* PEPTIDE_MAX_CHI: maximum number of sidechain dihedrals of a residue.
+ */
+#define PEPTIDE_MAX_CHI  4
+
+/* peptide_rotamer_t: structure for holding the discrete combinations of
+ * values that the sidechain torsions of a residue may take, as drawn from
+ * a rotamer library.
+ */
+typedef struct {
+  /* @tor_id: indices of the sidechain torsions in the peptide.
+   * @n_chi: number of sidechain torsions.
+   */
+  unsigned int tor_id[PEPTIDE_MAX_CHI];
+  unsigned int n_chi;
+
+  /* @val: array of torsion values of each rotamer, stored rotamer by
+   *       rotamer, in degrees.
+   * @n_val: number of rotamers.
+   */
+  double *val;
+  unsigned int n_val;
+}
+peptide_rotamer_t;
+
 /* peptide_t: structure for holding a single peptide chain.
  *
  * the information assimilated into this data structure is used to
@@ -128,6 +152,12 @@ typedef struct {
    */
   peptide_dihed_t *impropers;
   unsigned int n_impropers;
+
+  /* @rotamers: array of residues having discrete sidechain rotamers.
+   * @n_rotamers: number of residues having discrete sidechain rotamers.
+   */
+  peptide_rotamer_t *rotamers;
+  unsigned int n_rotamers;
 }
 peptide_t;
 
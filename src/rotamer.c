@@ -0,0 +1,439 @@
+
+/* include the rotamer library header. */
+#include "rotamer.h"
+
+/* include the peptide atom and torsion headers. */
+#include "peptide-atoms.h"
+#include "peptide-torsions.h"
+
+/* include the case-insensitive string comparison header. */
+#include <strings.h>
+
+/* ROTAMER_MAX_TOKENS: maximum number of tokens on a library line.
+ */
+#define ROTAMER_MAX_TOKENS  8
+
+/* rotamer_new(): allocate a new empty rotamer library data structure.
+ *
+ * returns:
+ *  pointer to a newly allocated empty data structure.
+ */
+rotamer_t *rotamer_new (void) {
+  /* declare required variables:
+   *  @rot: output structure pointer.
+   */
+  rotamer_t *rot;
+
+  /* allocate a new structure pointer. */
+  rot = (rotamer_t*) malloc(sizeof(rotamer_t));
+
+  /* check if allocation failed. */
+  if (!rot) {
+    /* raise an exception and return null. */
+    raise("unable to allocate rotamer structure pointer");
+    return NULL;
+  }
+
+  /* initialize the dihedral definitions. */
+  rot->chis = NULL;
+  rot->n_chis = 0;
+
+  /* initialize the rotamers. */
+  rot->rots = NULL;
+  rot->n_rots = 0;
+
+  /* return the structure pointer. */
+  return rot;
+}
+
+/* rotamer_free(): free all allocated memory associated with a rotamer
+ * library data structure.
+ *
+ * arguments:
+ *  @rot: pointer to the data structure to free.
+ */
+void rotamer_free (rotamer_t *rot) {
+  /* declare required variables:
+   *  @i, @j: general purpose loop counters.
+   */
+  unsigned int i, j;
+
+  /* return if the structure pointer is null. */
+  if (!rot) return;
+
+  /* free the dihedral definitions. */
+  for (i = 0; i < rot->n_chis; i++) {
+    free(rot->chis[i].res);
+    for (j = 0; j < 4; j++)
+      free(rot->chis[i].atoms[j]);
+  }
+
+  /* free the rotamer residue names. */
+  for (i = 0; i < rot->n_rots; i++)
+    free(rot->rots[i].res);
+
+  /* free the arrays and the structure pointer. */
+  free(rot->chis);
+  free(rot->rots);
+  free(rot);
+}
+
+/* rotamer_add_chi(): add a sidechain dihedral definition to a rotamer
+ * library.
+ *
+ * arguments:
+ *  @rot: pointer to the rotamer library to modify.
+ *  @res: residue name string.
+ *  @idx: index of the dihedral within the rotamers of the residue.
+ *  @atoms: names of the four atoms that define the dihedral.
+ *
+ * returns:
+ *  integer indicating whether (1) or not (0) the operation succeeded.
+ */
+static int rotamer_add_chi (rotamer_t *rot, const char *res,
+                            unsigned int idx, char **atoms) {
+  /* declare required variables:
+   *  @chi: pointer to the new dihedral definition.
+   *  @i: atom index.
+   */
+  rotamer_chi_t *chi;
+  unsigned int i;
+
+  /* reallocate the dihedral definition array. */
+  rot->chis = (rotamer_chi_t*)
+    realloc(rot->chis, (rot->n_chis + 1) * sizeof(rotamer_chi_t));
+
+  /* check if reallocation failed. */
+  if (!rot->chis)
+    throw("unable to reallocate dihedral definition array");
+
+  /* store the new dihedral definition. */
+  chi = rot->chis + rot->n_chis;
+  chi->res = strdup(res);
+  chi->idx = idx;
+  for (i = 0; i < 4; i++)
+    chi->atoms[i] = strdup(atoms[i]);
+
+  /* increment the dihedral definition count and return success. */
+  rot->n_chis++;
+  return 1;
+}
+
+/* rotamer_add(): add a rotamer to a rotamer library.
+ *
+ * arguments:
+ *  @rot: pointer to the rotamer library to modify.
+ *  @res: residue name string.
+ *  @chi: sidechain dihedral values of the rotamer, in degrees.
+ *  @n_chi: number of sidechain dihedral values.
+ *
+ * returns:
+ *  integer indicating whether (1) or not (0) the operation succeeded.
+ */
+static int rotamer_add (rotamer_t *rot, const char *res,
+                        const double *chi, unsigned int n_chi) {
+  /* declare required variables:
+   *  @ent: pointer to the new rotamer.
+   */
+  rotamer_entry_t *ent;
+
+  /* reallocate the rotamer array. */
+  rot->rots = (rotamer_entry_t*)
+    realloc(rot->rots, (rot->n_rots + 1) * sizeof(rotamer_entry_t));
+
+  /* check if reallocation failed. */
+  if (!rot->rots)
+    throw("unable to reallocate rotamer array");
+
+  /* store the new rotamer. */
+  ent = rot->rots + rot->n_rots;
+  ent->res = strdup(res);
+  ent->n_chi = n_chi;
+  memcpy(ent->chi, chi, n_chi * sizeof(double));
+
+  /* increment the rotamer count and return success. */
+  rot->n_rots++;
+  return 1;
+}
+
+/* rotamer_parse(): read the contents of a rotamer library file. each
+ * line holds either a dihedral definition or a rotamer:
+ *
+ *   chi RES IDX A1 A2 A3 A4
+ *   rot RES CHI1 [CHI2 ...]
+ *
+ * and all text following an exclamation mark is ignored.
+ *
+ * arguments:
+ *  @fh: input file handle.
+ *  @rot: pointer to the rotamer library to fill.
+ *
+ * returns:
+ *  integer indicating whether (1) or not (0) the operation succeeded.
+ */
+static int rotamer_parse (FILE *fh, rotamer_t *rot) {
+  /* declare required variables:
+   *  @buf: line buffer.
+   *  @tok: token pointers within the line buffer.
+   *  @chi: parsed dihedral values.
+   *  @line: current line number.
+   *  @n: number of tokens on the current line.
+   */
+  char buf[1024], *tok[ROTAMER_MAX_TOKENS + 1], *s, *end;
+  double chi[ROTAMER_MAX_CHI];
+  unsigned int line, n, i;
+  long idx;
+
+  /* loop over the lines of the file. */
+  for (line = 1; fgets(buf, sizeof(buf), fh); line++) {
+    /* strip comments from the line. */
+    s = strchr(buf, '!');
+    if (s)
+      *s = '\0';
+
+    /* split the line into tokens. */
+    for (n = 0, s = strtok(buf, " \t\r\n"); s && n <= ROTAMER_MAX_TOKENS;
+         s = strtok(NULL, " \t\r\n"))
+      tok[n++] = s;
+
+    /* skip empty lines. */
+    if (n == 0)
+      continue;
+
+    /* check for overlong lines. */
+    if (n > ROTAMER_MAX_TOKENS)
+      throw("too many fields on line %u", line);
+
+    /* check the line type. */
+    if (strcasecmp(tok[0], "chi") == 0) {
+      /* parse the dihedral definition. */
+      if (n != 7)
+        throw("malformed dihedral definition on line %u", line);
+
+      idx = strtol(tok[2], &end, 10);
+      if (*end || idx < 1 || idx > ROTAMER_MAX_CHI)
+        throw("invalid dihedral index '%s' on line %u", tok[2], line);
+
+      /* store the dihedral definition. */
+      if (!rotamer_add_chi(rot, tok[1], (unsigned int) idx, tok + 3))
+        throw("unable to add dihedral definition on line %u", line);
+    }
+    else if (strcasecmp(tok[0], "rot") == 0) {
+      /* parse the rotamer dihedral values. */
+      if (n < 3 || n - 2 > ROTAMER_MAX_CHI)
+        throw("malformed rotamer on line %u", line);
+
+      for (i = 2; i < n; i++) {
+        chi[i - 2] = strtod(tok[i], &end);
+        if (*end)
+          throw("invalid dihedral value '%s' on line %u", tok[i], line);
+      }
+
+      /* store the rotamer. */
+      if (!rotamer_add(rot, tok[1], chi, n - 2))
+        throw("unable to add rotamer on line %u", line);
+    }
+    else
+      throw("unknown entry '%s' on line %u", tok[0], line);
+  }
+
+  /* return success. */
+  return 1;
+}
+
+/* rotamer_new_from_file(): allocate a new rotamer library data structure
+ * by reading information from a file.
+ *
+ * arguments:
+ *  @fname: input rotamer library filename string.
+ *
+ * returns:
+ *  pointer to a newly allocated and filled data structure.
+ */
+rotamer_t *rotamer_new_from_file (const char *fname) {
+  /* declare required variables:
+   *  @rot: output structure pointer.
+   *  @fh: input file handle.
+   */
+  rotamer_t *rot;
+  FILE *fh;
+
+  /* allocate the structure pointer. */
+  rot = rotamer_new();
+  if (!rot)
+    return NULL;
+
+  /* open the input file. */
+  fh = fopen(fname, "r");
+
+  /* check that the file was opened successfully. */
+  if (!fh) {
+    /* no. raise an exception and return null. */
+    raise("unable to open '%s' for reading", fname);
+    rotamer_free(rot);
+    return NULL;
+  }
+
+  /* attempt to parse the input file. */
+  if (!rotamer_parse(fh, rot)) {
+    /* failure. raise an exception. */
+    raise("unable to parse rotamer library '%s'", fname);
+
+    /* clean up. */
+    rotamer_free(rot);
+    fclose(fh);
+
+    /* return null. */
+    return NULL;
+  }
+
+  /* close the input file and return the new structure. */
+  fclose(fh);
+  return rot;
+}
+
+/* rotamer_wrap(): wrap a dihedral value into the range (-180,180].
+ */
+static inline double rotamer_wrap (double x) {
+  /* shift the value by whole turns. */
+  x = fmod(x, 360.0);
+  if (x <= -180.0) x += 360.0;
+  if (x > 180.0) x -= 360.0;
+  return x;
+}
+
+/* rotamer_apply_all(): apply the information in a rotamer library to the
+ * explicit sidechains of a peptide. the sidechain torsions of each residue
+ * that match the dihedral definitions of its residue type receive the
+ * distinct combinations of values that the rotamers of the residue type
+ * take, in the order of their first appearance in the library.
+ *
+ * arguments:
+ *  @rot: pointer to the rotamer library to access.
+ *  @P: pointer to the peptide structure to modify.
+ *
+ * returns:
+ *  integer indicating whether (1) or not (0) the operation succeeded.
+ */
+int rotamer_apply_all (rotamer_t *rot, peptide_t *P) {
+  /* declare required variables:
+   *  @pr: pointer to the new peptide rotamers.
+   *  @chi: pointer to the current dihedral definition.
+   *  @ent: pointer to the current library rotamer.
+   *  @col: dihedral index of each stored torsion.
+   *  @tor: peptide index of each stored torsion.
+   *  @val: distinct value combinations of the residue.
+   *  @id: atom indices of the current dihedral.
+   *  @nc: number of stored torsions of the residue.
+   *  @n: number of distinct value combinations.
+   */
+  peptide_rotamer_t *pr;
+  rotamer_entry_t *ent;
+  rotamer_chi_t *chi;
+  unsigned int col[ROTAMER_MAX_CHI], tor[ROTAMER_MAX_CHI];
+  unsigned int i, j, k, m, r, nc, n;
+  const char *name;
+  double *val, *x;
+  int id[4], t;
+
+  /* loop over the explicit sidechains of the peptide. */
+  for (i = 0; i < P->n_sc; i++) {
+    /* get the residue index and name. */
+    r = P->sc[i];
+    name = peptide_get_resname(P, r);
+    if (!name)
+      continue;
+
+    /* loop over the dihedral definitions of the residue. */
+    for (j = 0, nc = 0; j < rot->n_chis && nc < ROTAMER_MAX_CHI; j++) {
+      chi = rot->chis + j;
+      if (strcmp(chi->res, name))
+        continue;
+
+      /* locate the atoms of the dihedral. */
+      for (k = 0; k < 4; k++) {
+        id[k] = peptide_atom_find(P, r, chi->atoms[k]);
+        if (id[k] < 0)
+          break;
+      }
+
+      /* locate the torsion, skipping dihedrals absent from the peptide
+       * and torsions that already hold discrete values.
+       */
+      t = (k == 4 ? peptide_torsion_find(P, id[0], id[1], id[2], id[3])
+                  : -1);
+
+      for (k = 0; t >= 0 && k < P->n_rotamers; k++)
+        for (m = 0; m < P->rotamers[k].n_chi; m++)
+          t = (P->rotamers[k].tor_id[m] == (unsigned int) t ? -1 : t);
+
+      if (t < 0)
+        continue;
+
+      /* store the torsion. */
+      col[nc] = chi->idx;
+      tor[nc++] = (unsigned int) t;
+    }
+
+    /* skip residues without any matched torsions. */
+    if (nc == 0)
+      continue;
+
+    /* allocate the array of distinct value combinations. */
+    val = (double*) malloc((rot->n_rots + 1) * nc * sizeof(double));
+    if (!val)
+      throw("unable to allocate rotamer values");
+
+    /* gather the distinct value combinations of the residue. */
+    for (k = 0, n = 0; k < rot->n_rots; k++) {
+      /* skip rotamers of other residues or lacking a dihedral. */
+      ent = rot->rots + k;
+      for (j = 0; j < nc && ent->n_chi >= col[j]; j++);
+      if (strcmp(ent->res, name) || j < nc)
+        continue;
+
+      /* store the values of the combination. */
+      x = val + n * nc;
+      for (j = 0; j < nc; j++)
+        x[j] = rotamer_wrap(ent->chi[col[j] - 1]);
+
+      /* keep the combination only if it was not seen before. */
+      for (m = 0; m < n; m++) {
+        for (j = 0; j < nc && fabs(val[m * nc + j] - x[j]) < 1.0e-6; j++);
+        if (j == nc)
+          break;
+      }
+
+      if (m == n)
+        n++;
+    }
+
+    /* skip residues without any rotamers. */
+    if (n == 0) {
+      free(val);
+      continue;
+    }
+
+    /* reallocate the peptide rotamer array. */
+    P->rotamers = (peptide_rotamer_t*)
+      realloc(P->rotamers, (P->n_rotamers + 1) *
+                           sizeof(peptide_rotamer_t));
+
+    /* check if reallocation failed. */
+    if (!P->rotamers) {
+      free(val);
+      throw("unable to reallocate peptide rotamer array");
+    }
+
+    /* store the rotamers. */
+    pr = P->rotamers + P->n_rotamers;
+    memcpy(pr->tor_id, tor, nc * sizeof(unsigned int));
+    pr->n_chi = nc;
+    pr->val = val;
+    pr->n_val = n;
+    P->n_rotamers++;
+  }
+
+  /* return success. */
+  return 1;
+}
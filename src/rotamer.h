@@ -0,0 +1,73 @@
+
+/* ensure once-only inclusion. */
+#pragma once
+
+/* include the c math library header. */
+#include <math.h>
+
+/* include the peptide header. */
+#include "peptide.h"
+
+/* include the traceback and string function headers. */
+#include "trace.h"
+#include "str.h"
+
+/* ROTAMER_MAX_CHI: maximum number of sidechain dihedrals in a rotamer.
+ */
+#define ROTAMER_MAX_CHI  PEPTIDE_MAX_CHI
+
+/* rotamer_chi_t: structure for holding the definition of a single
+ * sidechain dihedral (chi) angle of a residue.
+ */
+typedef struct {
+  /* @res: residue name string.
+   * @idx: index of the dihedral within its rotamers, starting from one.
+   * @atoms: names of the four atoms that define the dihedral.
+   */
+  char *res;
+  unsigned int idx;
+  char *atoms[4];
+}
+rotamer_chi_t;
+
+/* rotamer_entry_t: structure for holding a single rotamer of a residue.
+ */
+typedef struct {
+  /* @res: residue name string.
+   * @chi: sidechain dihedral values of the rotamer, in degrees.
+   * @n_chi: number of sidechain dihedrals in the rotamer.
+   */
+  char *res;
+  double chi[ROTAMER_MAX_CHI];
+  unsigned int n_chi;
+}
+rotamer_entry_t;
+
+/* rotamer_t: structure for holding a rotamer library.
+ */
+typedef struct {
+  /* @chis: array of sidechain dihedral definitions.
+   * @n_chis: number of sidechain dihedral definitions.
+   */
+  rotamer_chi_t *chis;
+  unsigned int n_chis;
+
+  /* @rots: array of rotamers, ordered from most to least common within
+   *        each residue.
+   * @n_rots: number of rotamers.
+   */
+  rotamer_entry_t *rots;
+  unsigned int n_rots;
+}
+rotamer_t;
+
+/* function declarations: */
+
+rotamer_t *rotamer_new (void);
+
+rotamer_t *rotamer_new_from_file (const char *fname);
+
+void rotamer_free (rotamer_t *rot);
+
+int rotamer_apply_all (rotamer_t *rot, peptide_t *P);
+
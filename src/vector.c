@@ -227,6 +227,43 @@ inline double vector_dihedral (vector_t *a, vector_t *b,
   return atan2(y, x);
 }
 
+/* vector_circle_range(): compute the range of squared distances from a
+ * vector to the points of a circle in space. the extremes lie in the
+ * plane through the axis of the circle and the vector.
+ *
+ * arguments:
+ *  @c: center of the circle.
+ *  @e: unit axis of the circle.
+ *  @r: radius of the circle.
+ *  @x: vector to use for the computation.
+ *  @lo, @hi: output smallest and largest squared distances.
+ */
+inline void vector_circle_range (const vector_t *c, const vector_t *e,
+                                 double r, const vector_t *x,
+                                 double *lo, double *hi) {
+  /* declare required variables:
+   *  @p: offset of the vector from the center.
+   *  @h, @rho2: axial and squared radial offsets of the vector.
+   *  @s, @q: midpoint and half-width of the squared distance range.
+   */
+  vector_t p;
+  double h, rho2, s, q;
+
+  /* compute the axial and radial offsets of the vector. */
+  p.x = x->x - c->x;
+  p.y = x->y - c->y;
+  p.z = x->z - c->z;
+  h = p.x * e->x + p.y * e->y + p.z * e->z;
+  rho2 = p.x * p.x + p.y * p.y + p.z * p.z - h * h;
+  rho2 = (rho2 > 0.0 ? rho2 : 0.0);
+
+  /* compute the range. */
+  s = h * h + rho2 + r * r;
+  q = 2.0 * r * sqrt(rho2);
+  *lo = s - q;
+  *hi = s + q;
+}
+
 /* vector_printfn(): core function used by the vector_print() macro
  * to write vectors to standard output.
  *
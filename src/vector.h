@@ -50,5 +50,9 @@ double vector_angle (vector_t *a, vector_t *b, vector_t *c);
 double vector_dihedral (vector_t *a, vector_t *b,
                         vector_t *c, vector_t *d);
 
+void vector_circle_range (const vector_t *c, const vector_t *e,
+                          double r, const vector_t *x,
+                          double *lo, double *hi);
+
 void vector_printfn (vector_t *v, const char *id);
 
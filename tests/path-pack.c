@@ -0,0 +1,37 @@
+
+/* include the required headers. */
+#include "base.h"
+#include "../src/enum.h"
+#include "../src/enum-write.h"
+
+/* path-pack.x: test-case for packing and unpacking the branch paths of
+ * the path output format.
+ */
+int main (int argc, char **argv) {
+  unsigned int n_fails = 0;
+
+  /* define bit counts that cross byte boundaries. */
+  const unsigned int m = 8;
+  const unsigned int bits[8] = { 1, 2, 3, 5, 8, 13, 0, 7 };
+
+  /* define indices that set the first, last and every bit. */
+  const unsigned int idx[8] = { 1, 2, 5, 31, 128, 4097, 0, 127 };
+
+  /* pack and unpack the indices. */
+  unsigned char buf[6];
+  unsigned int out[8];
+  enum_write_path_pack(idx, bits, m, buf);
+  enum_write_path_unpack(buf, bits, m, out);
+
+  /* test the round trip. */
+  n_fails += test_eq_array_uint(m, idx, out);
+
+  /* test the byte layout, least significant bits first. */
+  const unsigned int lbits[2] = { 3, 5 };
+  const unsigned int lidx[2] = { 5, 17 };
+  enum_write_path_pack(lidx, lbits, 2, buf);
+  n_fails += test_eq_uint(buf[0], 0x8d);
+
+  return (n_fails > 0);
+}
+
@@ -0,0 +1,33 @@
+
+/* include the required headers. */
+#include "base.h"
+#include "../src/enum.h"
+#include "../src/enum-thread.h"
+
+/* replay-select.x: test-case for selecting the solutions to reconstruct
+ * from a path output file.
+ */
+int main (int argc, char **argv) {
+  unsigned int n_fails = 0;
+
+  /* test that a missing selection selects every solution. */
+  n_fails += test_eq_int(enum_replay_selected(NULL, 1), 1);
+  n_fails += test_eq_int(enum_replay_selected(NULL, 1000), 1);
+
+  /* test a single index. */
+  n_fails += test_eq_int(enum_replay_selected("7", 6), 0);
+  n_fails += test_eq_int(enum_replay_selected("7", 7), 1);
+  n_fails += test_eq_int(enum_replay_selected("7", 8), 0);
+
+  /* test ranges and indices, including their ends. */
+  n_fails += test_eq_int(enum_replay_selected("1-10,42", 1), 1);
+  n_fails += test_eq_int(enum_replay_selected("1-10,42", 10), 1);
+  n_fails += test_eq_int(enum_replay_selected("1-10,42", 11), 0);
+  n_fails += test_eq_int(enum_replay_selected("1-10,42", 42), 1);
+  n_fails += test_eq_int(enum_replay_selected("1-10,42", 43), 0);
+  n_fails += test_eq_int(enum_replay_selected("3,5-6", 4), 0);
+  n_fails += test_eq_int(enum_replay_selected("3,5-6", 6), 1);
+
+  return (n_fails > 0);
+}
+
@@ -0,0 +1,45 @@
+
+/* include the required headers. */
+#include "base.h"
+#include "../src/vector.h"
+
+/* vector-circle.x: test-case for computing the range of squared distances
+ * from a point to a circle, as used by forward checking.
+ */
+int main (int argc, char **argv) {
+  unsigned int n_fails = 0;
+  double lo, hi;
+
+  /* set up a unit circle in the xy-plane. */
+  vector_t c = { .x = 0.0, .y = 0.0, .z = 0.0 };
+  vector_t e = { .x = 0.0, .y = 0.0, .z = 1.0 };
+
+  /* test a point in the plane of the circle. */
+  vector_t a = { .x = 2.0, .y = 0.0, .z = 0.0 };
+  vector_circle_range(&c, &e, 1.0, &a, &lo, &hi);
+  n_fails += test_eq_double(lo, 1.0, 1.0e-12);
+  n_fails += test_eq_double(hi, 9.0, 1.0e-12);
+
+  /* test a point on the axis, which is equidistant from the circle. */
+  vector_t b = { .x = 0.0, .y = 0.0, .z = 1.0 };
+  vector_circle_range(&c, &e, 1.0, &b, &lo, &hi);
+  n_fails += test_eq_double(lo, 2.0, 1.0e-12);
+  n_fails += test_eq_double(hi, 2.0, 1.0e-12);
+
+  /* test a point off the plane and off the axis. */
+  vector_t d = { .x = 0.0, .y = 0.5, .z = 1.0 };
+  vector_circle_range(&c, &e, 1.0, &d, &lo, &hi);
+  n_fails += test_eq_double(lo, 1.25, 1.0e-12);
+  n_fails += test_eq_double(hi, 3.25, 1.0e-12);
+
+  /* test a shifted circle with a tilted axis. */
+  vector_t c2 = { .x = 1.0, .y = 1.0, .z = 1.0 };
+  vector_t e2 = { .x = M_SQRT1_2, .y = M_SQRT1_2, .z = 0.0 };
+  vector_t x2 = { .x = 1.0, .y = 1.0, .z = 3.0 };
+  vector_circle_range(&c2, &e2, 2.0, &x2, &lo, &hi);
+  n_fails += test_eq_double(lo, 0.0, 1.0e-12);
+  n_fails += test_eq_double(hi, 16.0, 1.0e-12);
+
+  return (n_fails > 0);
+}
+